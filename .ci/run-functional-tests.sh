@@ -11,6 +11,30 @@ TOOLCHAIN_TYPE=${TOOLCHAIN_TYPE:-gnu}
 declare -A FUNCTIONAL_TESTS
 FUNCTIONAL_TESTS["mutex"]="Fairness: PASS,Mutual Exclusion: PASS,Data Consistency: PASS,Overall: PASS"
 FUNCTIONAL_TESTS["semaphore"]="Overall: PASS"
+FUNCTIONAL_TESTS["vblk"]="Prompt wakeup: PASS,Overall: PASS"
+FUNCTIONAL_TESTS["pbuf"]="Packets by reference: PASS,Overall: PASS"
+FUNCTIONAL_TESTS["logger"]="Drained without drops: PASS,Overall: PASS"
+FUNCTIONAL_TESTS["prof"]="Sampling rate: PASS,Tick rate unaffected: PASS,Overall: PASS"
+FUNCTIONAL_TESTS["softirq"]="Handler runs once per raise: PASS,Registers preserved: PASS,Raised alongside ticks: PASS,Overall: PASS"
+FUNCTIONAL_TESTS["vcon"]="Device present: PASS,Bulk output accepted: PASS,Overall: PASS"
+FUNCTIONAL_TESTS["budget"]="Throttled to budget: PASS,Replenished every period: PASS,Budget removed: PASS,Overall: PASS"
+FUNCTIONAL_TESTS["fpu"]="Preempted with live FP state: PASS,FP registers and fcsr preserved: PASS,Overall: PASS"
+FUNCTIONAL_TESTS["fs"]="Format: PASS,Unmount: PASS,Overall: PASS"
+FUNCTIONAL_TESTS["futex"]="Wake all: PASS,Timeout: PASS,Overall: PASS"
+FUNCTIONAL_TESTS["ipc"]="Completion: PASS,Reply data: PASS,Error handling: PASS,Overall: PASS"
+FUNCTIONAL_TESTS["mq_batch"]="Partial send and drain: PASS,Blocking batch receive: PASS,Overall: PASS"
+FUNCTIONAL_TESTS["mq_fixed"]="No lost wakeups: PASS,Data integrity: PASS,Overall: PASS"
+FUNCTIONAL_TESTS["perf"]="Counts accrued: PASS,Monotonic: PASS,Within global count: PASS,Overall: PASS"
+FUNCTIONAL_TESTS["pipes_iov"]="Atomic gathered writes: PASS,Records and invalid vectors: PASS,Overall: PASS"
+FUNCTIONAL_TESTS["pipes_record"]="Truncation and limits: PASS,Record boundaries: PASS,Overall: PASS"
+FUNCTIONAL_TESTS["pt"]="Oversized writes fail: PASS,Semaphore wait: PASS,Semaphore timeout: PASS,Overall: PASS"
+FUNCTIONAL_TESTS["schedlock"]="No preemption while locked: PASS,Nested lock and deferred yield: PASS,Others run after unlock: PASS,Overall: PASS"
+FUNCTIONAL_TESTS["test_string"]="strlen: PASS,memchr: PASS,strcmp: PASS,Overall: PASS"
+FUNCTIONAL_TESTS["threshold"]="Same priority held off: PASS,Preempted above threshold: PASS,Peer held off around preemption: PASS,Overall: PASS"
+FUNCTIONAL_TESTS["timer_phase"]="Tick periods aligned to a common base: PASS,Phase kept when fired late: PASS,Overall: PASS"
+FUNCTIONAL_TESTS["timer_slack"]="Timers within their windows: PASS,Timer expiries coalesced: PASS,Delay wakeups coalesced: PASS,Overall: PASS"
+FUNCTIONAL_TESTS["topic"]="Delivered + dropped: PASS,Unsubscribe with a blocked receiver: PASS,Overall: PASS"
+FUNCTIONAL_TESTS["yieldto"]="Target runs next: PASS,Skipped tasks keep their turn: PASS,Unknown target rejected: PASS,Overall: PASS"
 #FUNCTIONAL_TESTS["test64"]="Unsigned Multiply: PASS,Unsigned Divide: PASS,Signed Multiply: PASS,Signed Divide: PASS,Left Shifts: PASS,Logical Right Shifts: PASS,Arithmetic Right Shifts: PASS,Overall: PASS"
 #FUNCTIONAL_TESTS["suspend"]="Suspend: PASS,Resume: PASS,Self-Suspend: PASS,Overall: PASS"
 
@@ -22,6 +46,19 @@ FUNCTIONAL_TESTS["semaphore"]="Overall: PASS"
 # FUNCTIONAL_TESTS["pipes"]="Bidirectional IPC: PASS,Data Integrity: PASS,Overall: PASS"
 # FUNCTIONAL_TESTS["mqueues"]="Multi-Queue Routing: PASS,Task Synchronization: PASS,Overall: PASS"
 
+# Extra make options for tests of features that are off by default
+declare -A MAKE_OPTS
+MAKE_OPTS["fpu"]="ISA=rv32imafd"
+MAKE_OPTS["prof"]="PROFILER=1"
+MAKE_OPTS["vcon"]="VIRTIO_CONSOLE=1"
+
+# Extra QEMU options for tests that need devices. A blank disk image is
+# created for every test that attaches one.
+DISK_IMAGE=build/disk.img
+declare -A QEMU_OPTS
+QEMU_OPTS["vblk"]="-drive file=${DISK_IMAGE},if=none,format=raw,id=disk -device virtio-blk-device,drive=disk -global virtio-mmio.force-legacy=false"
+QEMU_OPTS["vcon"]="-device virtio-serial-device -chardev file,id=vcon,path=build/console.log -device virtconsole,chardev=vcon -global virtio-mmio.force-legacy=false"
+
 # Store detailed criteria results
 declare -A CRITERIA_RESULTS
 
@@ -41,7 +78,8 @@ test_functional_app() {
     # Build phase
     echo "[+] Building..."
     make clean > /dev/null 2>&1 || true # Clean previous build artifacts (failures ignored)
-    if ! make "$test" TOOLCHAIN_TYPE="$TOOLCHAIN_TYPE" > /dev/null 2>&1; then
+    local make_opts="${MAKE_OPTS[$test]:-}"
+    if ! make "$test" TOOLCHAIN_TYPE="$TOOLCHAIN_TYPE" $make_opts > /dev/null 2>&1; then
         echo "[!] Build failed"
 
         # Mark all criteria as build_failed
@@ -58,7 +96,12 @@ test_functional_app() {
     # Run phase
     echo "[+] Running (timeout: ${TIMEOUT}s)..."
     local output exit_code
-    output=$(timeout ${TIMEOUT}s qemu-system-riscv32 -nographic -machine virt -bios none -kernel build/image.elf 2>&1)
+    local qemu_opts="${QEMU_OPTS[$test]:-}"
+    if [[ "$qemu_opts" == *"$DISK_IMAGE"* ]]; then
+        rm -f "$DISK_IMAGE"
+        truncate -s 1M "$DISK_IMAGE"
+    fi
+    output=$(timeout ${TIMEOUT}s qemu-system-riscv32 -nographic -machine virt -bios none -kernel build/image.elf $qemu_opts 2>&1)
     exit_code=$?
 
     # Debug: Show first 500 chars of output
@@ -0,0 +1,92 @@
+/* Test for CPU budgets
+ *
+ * A hog and a spinner of the same priority never block, and the hog counts
+ * the ticks it sees while running. With a budget of BUDGET ticks every
+ * PERIOD ticks its share of a window must stay within the budget, yet be
+ * replenished period after period; without the budget it must get its
+ * round-robin share again.
+ */
+
+#include <linmo.h>
+
+#include "private/error.h"
+#include "spin.h"
+
+#define BUDGET 2
+#define PERIOD 10
+#define WINDOW 100
+
+/* Most ticks the hog may see in a window: its budget in every period the
+ * window touches, plus one tick the charge may lag behind.
+ */
+#define BUDGET_MAX ((WINDOW / PERIOD + 1) * BUDGET + 1)
+
+static volatile uint32_t hog_ticks;
+static int32_t hog_id;
+
+void hog(void)
+{
+    uint32_t last = 0;
+
+    while (1) {
+        uint32_t now = mo_ticks();
+        if (now != last) {
+            last = now;
+            hog_ticks++;
+        }
+    }
+}
+
+/* Returns the ticks the hog ran in a window of WINDOW ticks */
+static uint32_t hog_window(void)
+{
+    uint32_t start = hog_ticks;
+    mo_task_delay(WINDOW);
+    return hog_ticks - start;
+}
+
+void tester(void)
+{
+    bool invalid_ok = mo_task_budget(hog_id, PERIOD, BUDGET) == ERR_FAIL &&
+                      mo_task_budget(0, BUDGET, PERIOD) == ERR_TASK_NOT_FOUND;
+
+    bool set_ok = mo_task_budget(hog_id, BUDGET, PERIOD) == ERR_OK;
+    uint32_t limited = hog_window();
+
+    bool clear_ok = mo_task_budget(hog_id, 0, 0) == ERR_OK;
+    uint32_t unlimited = hog_window();
+
+    /* Without replenishment the hog would stop after one budget */
+    bool throttle_ok = set_ok && limited <= BUDGET_MAX;
+    bool refill_ok = limited >= BUDGET_MAX / 2;
+    clear_ok = clear_ok && unlimited > BUDGET_MAX;
+
+    printf("\n=== BUDGET RESULTS ===\n");
+    printf("Hog ran %u ticks with a budget, %u without, of %d\n",
+           (unsigned) limited, (unsigned) unlimited, WINDOW);
+    printf("Invalid budget rejected: %s\n", invalid_ok ? "PASS" : "FAIL");
+    printf("Throttled to budget: %s\n", throttle_ok ? "PASS" : "FAIL");
+    printf("Replenished every period: %s\n", refill_ok ? "PASS" : "FAIL");
+    printf("Budget removed: %s\n", clear_ok ? "PASS" : "FAIL");
+    printf("Overall: %s\n",
+           (invalid_ok && throttle_ok && refill_ok && clear_ok) ? "PASS"
+                                                                : "FAIL");
+
+    /* Shutdown QEMU cleanly via virt machine's test device */
+    *(volatile uint32_t *) 0x100000U = 0x5555U;
+
+    while (1)
+        mo_task_yield();
+}
+
+int32_t app_main(void)
+{
+    hog_id = mo_task_spawn(hog, 512);
+    if (hog_id < 0 || mo_task_spawn(spinner, 512) < 0 ||
+        mo_task_spawn(tester, 1024) < 0) {
+        printf("FATAL: Failed to create tasks\n");
+        return false;
+    }
+
+    return true; /* Enable preemptive scheduling */
+}
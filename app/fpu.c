@@ -0,0 +1,146 @@
+/* Test for lazy FP context switching
+ *
+ * Two tasks run the same floating-point recurrence from different seeds and
+ * with different rounding modes, never yielding, so that they are preempted
+ * with live values in the FP registers. Every round must reproduce the first
+ * one bit for bit and each task must still see its own rounding mode. The
+ * monitor uses no FP at all and runs with the FPU off. Build with an F or D
+ * profile (e.g. ISA=rv32imafd); other profiles only report that there is no
+ * FPU to test.
+ */
+
+#include <linmo.h>
+
+#if HAL_HAS_FP
+
+#define WORKERS 2
+#define ITERATIONS 2000 /* Per round */
+#define DURATION 100    /* Ticks each worker keeps computing */
+#define DEADLINE 1000
+
+#define RM_RNE 0 /* Round to nearest, ties to even */
+#define RM_RTZ 1 /* Round towards zero */
+
+static volatile uint32_t rounds[WORKERS], errors[WORKERS];
+static volatile uint32_t interleaved[WORKERS];
+static volatile bool done[WORKERS];
+
+static inline void set_rounding(uint32_t rm)
+{
+    asm volatile("fsrm %0" : : "r"(rm));
+}
+
+static inline uint32_t get_rounding(void)
+{
+    uint32_t rm;
+    asm volatile("frrm %0" : "=r"(rm));
+    return rm;
+}
+
+/* Keeps several values live in FP registers across the whole round. The
+ * rounding mode changes the low bits, so a leaked 'fcsr' shows up too.
+ */
+static double compute(double seed)
+{
+    double a = seed, b = seed / 3.0, c = seed * 7.0, d = 1.0 / seed;
+
+    for (int i = 0; i < ITERATIONS; i++) {
+        a = a * 1.0000001 + b / 7.0;
+        b = b * 0.9999999 + c / 11.0;
+        c = c * 0.5 + d * 3.0;
+        d = d * 1.0000003 - a / 1e9;
+    }
+    return a + b + c + d;
+}
+
+void worker(void)
+{
+    static uint32_t next;
+    uint32_t self = next++, other = self ^ 1;
+    uint32_t rm = self ? RM_RTZ : RM_RNE;
+    double seed = 1.25 + self * 0.5;
+
+    set_rounding(rm);
+    double first = compute(seed);
+
+    uint32_t start = mo_ticks();
+    while (mo_ticks() - start < DURATION) {
+        uint32_t seen = rounds[other];
+        double r = compute(seed);
+
+        if (r != first || get_rounding() != rm)
+            errors[self]++;
+        /* The other worker ran while this one held live FP values */
+        if (rounds[other] != seen)
+            interleaved[self]++;
+        rounds[self]++;
+    }
+    done[self] = true;
+
+    while (1)
+        mo_task_yield();
+}
+
+void monitor(void)
+{
+    uint32_t start = mo_ticks();
+    while (!(done[0] && done[1]) && mo_ticks() - start < DEADLINE)
+        mo_task_delay(10);
+
+    bool finished = done[0] && done[1];
+    bool preempted = interleaved[0] && interleaved[1];
+    bool data_ok = finished && rounds[0] && rounds[1] && !errors[0] &&
+                   !errors[1];
+
+    printf("\n=== FPU RESULTS ===\n");
+    for (int i = 0; i < WORKERS; i++)
+        printf("Worker %d: %u rounds, %u interleaved, %u bad\n", i,
+               (unsigned) rounds[i], (unsigned) interleaved[i],
+               (unsigned) errors[i]);
+    printf("Preempted with live FP state: %s\n", preempted ? "PASS" : "FAIL");
+    printf("FP registers and fcsr preserved: %s\n", data_ok ? "PASS" : "FAIL");
+    printf("Overall: %s\n", (preempted && data_ok) ? "PASS" : "FAIL");
+
+    /* Shutdown QEMU cleanly via virt machine's test device */
+    *(volatile uint32_t *) 0x100000U = 0x5555U;
+
+    while (1)
+        mo_task_yield();
+}
+
+int32_t app_main(void)
+{
+    if (mo_task_spawn(worker, 1024) < 0 || mo_task_spawn(worker, 1024) < 0 ||
+        mo_task_spawn(monitor, 1024) < 0) {
+        printf("FATAL: Failed to create tasks\n");
+        return false;
+    }
+
+    return true; /* Enable preemptive scheduling */
+}
+
+#else /* !HAL_HAS_FP */
+
+void monitor(void)
+{
+    printf("\n=== FPU RESULTS ===\n");
+    printf("No FPU in this ISA profile, build with ISA=rv32imafd\n");
+
+    /* Shutdown QEMU cleanly via virt machine's test device */
+    *(volatile uint32_t *) 0x100000U = 0x5555U;
+
+    while (1)
+        mo_task_yield();
+}
+
+int32_t app_main(void)
+{
+    if (mo_task_spawn(monitor, 1024) < 0) {
+        printf("FATAL: Failed to create tasks\n");
+        return false;
+    }
+
+    return true; /* Enable preemptive scheduling */
+}
+
+#endif /* HAL_HAS_FP */
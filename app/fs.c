@@ -0,0 +1,233 @@
+/* Test for the block cache and log-structured file system
+ *
+ * Runs on a RAM disk, so it needs no storage device: appends fixed-size
+ * records to a log file, rewrites committed records in the middle (which
+ * moves their blocks), remounts to check that everything committed is found
+ * again, and finally drives a second file and a pipe through the POSIX
+ * system calls and the descriptor table.
+ */
+
+#include <linmo.h>
+
+#define DISK_BLOCKS 128
+#define RECORDS 500
+#define RECORD_SIZE 32
+#define REWRITE_AT 100 /* First record rewritten after the commit */
+#define REWRITES 40
+
+static blkdev_t *disk;
+static int failures;
+
+static void check(const char *what, bool ok)
+{
+    printf("%s: %s\n", what, ok ? "PASS" : "FAIL");
+    if (!ok)
+        failures++;
+}
+
+static void make_record(uint8_t *rec, uint32_t n, uint8_t tag)
+{
+    for (uint32_t i = 0; i < RECORD_SIZE; i++)
+        rec[i] = (uint8_t) (n * 7 + i) ^ tag;
+    memcpy(rec, &n, sizeof(n));
+}
+
+/* Reads the log back and checks every record */
+static bool verify_log(void)
+{
+    int32_t fd = mo_fs_open("log", O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    uint8_t rec[RECORD_SIZE], expect[RECORD_SIZE];
+    bool ok = true;
+    for (uint32_t n = 0; n < RECORDS && ok; n++) {
+        bool rewritten = n >= REWRITE_AT && n < REWRITE_AT + REWRITES;
+        make_record(expect, n, rewritten ? 0xA5 : 0);
+        ok = mo_fs_read(fd, rec, RECORD_SIZE) == RECORD_SIZE &&
+             !memcmp(rec, expect, RECORD_SIZE);
+    }
+    ok = ok && mo_fs_read(fd, rec, RECORD_SIZE) == 0;
+    mo_fs_close(fd);
+    return ok;
+}
+
+static void test_append(void)
+{
+    uint8_t rec[RECORD_SIZE];
+    bool ok = true;
+
+    int32_t fd = mo_fs_open("log", O_CREAT | O_WRONLY | O_APPEND);
+    uint64_t start = _read_us();
+    for (uint32_t n = 0; n < RECORDS && ok; n++) {
+        make_record(rec, n, 0);
+        ok = mo_fs_write(fd, rec, RECORD_SIZE) == RECORD_SIZE;
+    }
+    uint32_t elapsed = (uint32_t) (_read_us() - start);
+    ok = ok && mo_fs_close(fd) == 0 && mo_fs_sync() == 0;
+
+    printf("Appended %d records, %u us per append\n", RECORDS,
+           (unsigned) (elapsed / RECORDS));
+    check("Append", ok);
+}
+
+static void test_rewrite(void)
+{
+    uint8_t rec[RECORD_SIZE];
+    bool ok = true;
+
+    int32_t fd = mo_fs_open("log", O_RDWR);
+    ok = mo_fs_seek(fd, REWRITE_AT * RECORD_SIZE, SEEK_SET) ==
+         REWRITE_AT * RECORD_SIZE;
+    for (uint32_t n = REWRITE_AT; n < REWRITE_AT + REWRITES && ok; n++) {
+        make_record(rec, n, 0xA5);
+        ok = mo_fs_write(fd, rec, RECORD_SIZE) == RECORD_SIZE;
+    }
+    ok = ok && mo_fs_seek(fd, 0, SEEK_END) == RECORDS * RECORD_SIZE;
+    ok = ok && mo_fs_seek(fd, 1, SEEK_END) == -EINVAL;
+    ok = ok && mo_fs_close(fd) == 0;
+
+    check("Rewrite committed records", ok && verify_log());
+}
+
+static void test_remount(void)
+{
+    struct stat st;
+
+    bool ok = mo_fs_unmount() == 0 && mo_fs_mount(disk, false) == 0;
+    ok = ok && verify_log();
+    ok = ok && mo_fs_stat("log", &st) == 0 &&
+         st.st_size == RECORDS * RECORD_SIZE && S_ISREG(st.st_mode);
+    check("Remount", ok);
+}
+
+/* Before the first mount the calls fail cleanly instead of using the lock */
+static void test_unmounted(void)
+{
+    char c;
+
+    bool ok = !mo_fs_mounted() && mo_fs_open("log", O_RDONLY) == -ENOENT;
+    ok = ok && mo_fs_read(0, &c, 1) == -EBADF && mo_fs_sync() == -EINVAL;
+    ok = ok && syscall(SYS_open, "log", (void *) O_RDONLY, NULL) == -1;
+    ok = ok && syscall(SYS_unlink, "log", NULL, NULL) == -1;
+    check("Calls before mount", ok);
+}
+
+static void test_errors(void)
+{
+    bool ok = mo_fs_mount(disk, false) == -EBUSY;
+    ok = ok && mo_fs_open("missing", O_RDONLY) == -ENOENT;
+    ok = ok && mo_fs_open("log", O_CREAT | O_EXCL | O_WRONLY) == -EEXIST;
+    ok = ok && mo_fs_open("a-name-longer-than-allowed", O_CREAT) ==
+                   -ENAMETOOLONG;
+
+    int32_t fd = mo_fs_open("log", O_RDONLY);
+    ok = ok && mo_fs_write(fd, "x", 1) == -EBADF;
+    ok = ok && mo_fs_read(fd, &fd, 0) == 0;
+    ok = ok && mo_fs_unlink("log") == -EBUSY;
+    ok = ok && mo_fs_open("log", O_WRONLY | O_TRUNC) == -EBUSY;
+    ok = ok && mo_fs_close(fd) == 0 && mo_fs_close(fd) == -EBADF;
+    check("Error handling", ok);
+}
+
+static void test_syscalls(void)
+{
+    char buf[8];
+    struct stat st;
+
+    int fd = syscall(SYS_open, "notes", (void *) (O_CREAT | O_RDWR), NULL);
+    bool ok = fd >= 3;
+    ok = ok && syscall(SYS_write, (void *) fd, "linmo", (void *) 5) == 5;
+    ok = ok && syscall(SYS_lseek, (void *) fd, 0, (void *) SEEK_SET) == 0;
+    ok = ok && syscall(SYS_read, (void *) fd, buf, (void *) sizeof(buf)) == 5 &&
+         !memcmp(buf, "linmo", 5);
+    ok = ok && syscall(SYS_close, (void *) fd, NULL, NULL) == 0;
+    ok = ok && syscall(SYS_stat, "notes", &st, NULL) == 0 && st.st_size == 5;
+    ok = ok && syscall(SYS_unlink, "notes", NULL, NULL) == 0;
+    ok = ok && syscall(SYS_stat, "notes", &st, NULL) == -1;
+    check("System calls", ok);
+}
+
+static void test_descriptors(void)
+{
+    static const char msg[] = "through the descriptor table\n";
+    char buf[64];
+    int fds[2];
+
+    bool ok = syscall(SYS_pipe, fds, NULL, NULL) == 0;
+    ok = ok && syscall(SYS_write, (void *) fds[1], (void *) msg,
+                       (void *) sizeof(msg)) == sizeof(msg);
+    /* One read returns everything buffered, not a fixed count */
+    ok = ok && syscall(SYS_read, (void *) fds[0], buf, (void *) sizeof(buf)) ==
+                   sizeof(msg) &&
+         !memcmp(buf, msg, sizeof(msg));
+    ok = ok && syscall(SYS_lseek, (void *) fds[0], 0, (void *) SEEK_SET) == -1;
+
+    /* The duplicate keeps the write end open after the original closes */
+    int dup = syscall(SYS_dup, (void *) fds[1], NULL, NULL);
+    ok = ok && dup >= 3 && syscall(SYS_close, (void *) fds[1], NULL, NULL) == 0;
+    ok = ok && syscall(SYS_write, (void *) dup, "yz", (void *) 2) == 2;
+    struct stat st;
+    ok = ok && syscall(SYS_fstat, (void *) fds[0], &st, NULL) == 0 &&
+         S_ISFIFO(st.st_mode) && st.st_size == 2 &&
+         syscall(SYS_isatty, (void *) fds[0], NULL, NULL) == 0 &&
+         syscall(SYS_isatty, (void *) 1, NULL, NULL) == 1;
+
+    /* Without a writer, what is left is read and then the end of the pipe */
+    ok = ok && syscall(SYS_close, (void *) dup, NULL, NULL) == 0 &&
+         syscall(SYS_close, (void *) dup, NULL, NULL) == -1;
+    ok = ok &&
+         syscall(SYS_read, (void *) fds[0], buf, (void *) sizeof(buf)) == 2 &&
+         syscall(SYS_read, (void *) fds[0], buf, (void *) sizeof(buf)) == 0;
+    ok = ok && syscall(SYS_close, (void *) fds[0], NULL, NULL) == 0;
+
+    /* Without a reader, writes fail */
+    ok = ok && syscall(SYS_pipe, fds, NULL, NULL) == 0 &&
+         syscall(SYS_close, (void *) fds[0], NULL, NULL) == 0;
+    ok = ok && syscall(SYS_write, (void *) fds[1], "x", (void *) 1) == -1 &&
+         syscall(SYS_close, (void *) fds[1], NULL, NULL) == 0;
+
+    /* Standard output is the console, written in bulk */
+    ok = ok && syscall(SYS_write, (void *) 1, (void *) msg,
+                       (void *) (sizeof(msg) - 1)) == sizeof(msg) - 1;
+    check("Descriptors", ok);
+}
+
+void test_task(void)
+{
+    printf("\n=== FS RESULTS ===\n");
+
+    test_unmounted();
+    check("Format", mo_fs_mount(disk, true) == 0);
+    test_append();
+    test_rewrite();
+    test_remount();
+    test_errors();
+    test_syscalls();
+    test_descriptors();
+
+    check("Unmount", mo_fs_unmount() == 0);
+    printf("Overall: %s\n", failures ? "FAIL" : "PASS");
+
+    /* Shutdown QEMU cleanly via virt machine's test device */
+    *(volatile uint32_t *) 0x100000U = 0x5555U;
+
+    while (1)
+        mo_task_yield();
+}
+
+int32_t app_main(void)
+{
+    disk = mo_ramdisk_create(DISK_BLOCKS);
+    if (!disk) {
+        printf("FATAL: Failed to create the RAM disk\n");
+        return false;
+    }
+
+    if (mo_task_spawn(test_task, 2048) < 0) {
+        printf("FATAL: Failed to create tasks\n");
+        return false;
+    }
+
+    return true; /* Enable preemptive scheduling */
+}
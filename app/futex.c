@@ -0,0 +1,88 @@
+/* Test for the wait-on-address primitive
+ *
+ * Three waiters block on one word in spawn order. Waking one must release
+ * the oldest, waking all must release the rest, and a task waiting on a
+ * value the word does not hold, or with a timeout nobody beats, must not
+ * stay blocked.
+ */
+
+#include <linmo.h>
+
+#include "private/error.h"
+
+#define WAITERS 3
+
+static volatile uint32_t word;
+static volatile int order[WAITERS];
+static volatile int woken;
+
+void waiter(void)
+{
+    static int next;
+    int self = next++;
+
+    if (mo_wait_on(&word, 0, 0) == ERR_OK)
+        order[woken++] = self;
+
+    while (1)
+        mo_task_yield();
+}
+
+void tester(void)
+{
+    /* Let every waiter block */
+    mo_task_delay(2);
+
+    bool one_ok = mo_wake(&word, 1) == 1;
+    mo_task_delay(1);
+    one_ok = one_ok && woken == 1 && order[0] == 0;
+
+    bool all_ok = mo_wake(&word, WAKE_ALL) == WAITERS - 1;
+    mo_task_delay(1);
+    all_ok = all_ok && woken == WAITERS && mo_wake(&word, WAKE_ALL) == 0;
+
+    bool value_ok = mo_wait_on(&word, 1, 0) == ERR_WAIT_VALUE;
+
+    uint32_t start = mo_ticks();
+    bool timeout_ok = mo_wait_on(&word, 0, 5) == ERR_TIMEOUT &&
+                      mo_ticks() - start >= 5;
+
+    bool invalid_ok =
+        mo_wait_on(NULL, 0, 0) == ERR_FAIL &&
+        mo_wait_on((volatile uint32_t *) ((uintptr_t) &word + 1), 0, 0) ==
+            ERR_FAIL &&
+        mo_wake(NULL, 1) == ERR_FAIL;
+
+    printf("\n=== FUTEX RESULTS ===\n");
+    printf("Wake one, oldest first: %s\n", one_ok ? "PASS" : "FAIL");
+    printf("Wake all: %s\n", all_ok ? "PASS" : "FAIL");
+    printf("Value mismatch: %s\n", value_ok ? "PASS" : "FAIL");
+    printf("Timeout: %s\n", timeout_ok ? "PASS" : "FAIL");
+    printf("Invalid arguments: %s\n", invalid_ok ? "PASS" : "FAIL");
+    printf("Overall: %s\n",
+           (one_ok && all_ok && value_ok && timeout_ok && invalid_ok)
+               ? "PASS"
+               : "FAIL");
+
+    /* Shutdown QEMU cleanly via virt machine's test device */
+    *(volatile uint32_t *) 0x100000U = 0x5555U;
+
+    while (1)
+        mo_task_yield();
+}
+
+int32_t app_main(void)
+{
+    for (int i = 0; i < WAITERS; i++) {
+        if (mo_task_spawn(waiter, 512) < 0) {
+            printf("FATAL: Failed to create tasks\n");
+            return false;
+        }
+    }
+    if (mo_task_spawn(tester, 1024) < 0) {
+        printf("FATAL: Failed to create tasks\n");
+        return false;
+    }
+
+    return true; /* Enable preemptive scheduling */
+}
@@ -0,0 +1,120 @@
+/* Test for synchronous call/reply IPC
+ *
+ * Two clients call an adder server that replies with the sum of the request
+ * registers. Every reply is checked, and the monitor verifies that all calls
+ * completed and that invalid operations are rejected.
+ */
+
+#include <linmo.h>
+
+#include "private/error.h"
+
+#define CALLS_PER_CLIENT 50
+
+static uint16_t server_id;
+static volatile int calls_done[2];
+static volatile int bad_replies;
+static volatile bool errors_ok = true;
+
+/* Reply with the sum of the request registers in w[0], echo w[1] in w[1] */
+void server_task(void)
+{
+    ipc_msg_t req, rep;
+    int32_t client = mo_ipc_reply_wait(0, NULL, &req);
+
+    while (1) {
+        rep.w[0] = req.w[0] + req.w[1] + req.w[2] + req.w[3];
+        rep.w[1] = req.w[1];
+        rep.w[2] = rep.w[3] = 0;
+        client = mo_ipc_reply_wait(client, &rep, &req);
+    }
+}
+
+static void client_run(int idx)
+{
+    ipc_msg_t req, rep;
+
+    for (int i = 0; i < CALLS_PER_CLIENT; i++) {
+        req.w[0] = i;
+        req.w[1] = idx;
+        req.w[2] = 100;
+        req.w[3] = 1000;
+
+        if (mo_ipc_call(server_id, &req, &rep) != ERR_OK ||
+            rep.w[0] != (uint32_t) (i + idx + 1100) ||
+            rep.w[1] != (uint32_t) idx)
+            bad_replies++;
+        calls_done[idx]++;
+    }
+
+    while (1)
+        mo_task_yield();
+}
+
+void client_a(void)
+{
+    client_run(0);
+}
+
+void client_b(void)
+{
+    client_run(1);
+}
+
+void monitor_task(void)
+{
+    ipc_msg_t msg = {0};
+
+    /* Calling oneself, a missing task or replying without a call must fail */
+    if (mo_ipc_call(mo_task_id(), &msg, &msg) != ERR_FAIL ||
+        mo_ipc_call(0x7FFF, &msg, &msg) != ERR_TASK_NOT_FOUND ||
+        mo_ipc_reply(server_id, &msg) != ERR_IPC_NO_CALL)
+        errors_ok = false;
+
+    for (int i = 0; i < 500; i++) {
+        if (calls_done[0] >= CALLS_PER_CLIENT &&
+            calls_done[1] >= CALLS_PER_CLIENT)
+            break;
+        mo_task_yield();
+    }
+
+    bool calls_ok = calls_done[0] == CALLS_PER_CLIENT &&
+                    calls_done[1] == CALLS_PER_CLIENT;
+    bool data_ok = bad_replies == 0;
+
+    printf("\n=== IPC RESULTS ===\n");
+    printf("Calls completed: %d/%d\n", calls_done[0] + calls_done[1],
+           CALLS_PER_CLIENT * 2);
+    printf("Completion: %s\n", calls_ok ? "PASS" : "FAIL");
+    printf("Reply data: %s\n", data_ok ? "PASS" : "FAIL");
+    printf("Error handling: %s\n", errors_ok ? "PASS" : "FAIL");
+    printf("Overall: %s\n",
+           (calls_ok && data_ok && errors_ok) ? "PASS" : "FAIL");
+
+    /* Shutdown QEMU cleanly via virt machine's test device */
+    *(volatile uint32_t *) 0x100000U = 0x5555U;
+
+    while (1)
+        mo_task_yield();
+}
+
+int32_t app_main(void)
+{
+    printf("IPC call/reply test starting...\n");
+
+    int32_t srv = mo_task_spawn(server_task, 1024);
+    if (srv < 0) {
+        printf("FATAL: Failed to create server task\n");
+        return false;
+    }
+    server_id = srv;
+
+    if (mo_task_spawn(client_a, 1024) < 0 ||
+        mo_task_spawn(client_b, 1024) < 0 ||
+        mo_task_spawn(monitor_task, 1024) < 0) {
+        printf("FATAL: Failed to create tasks\n");
+        return false;
+    }
+
+    return true; /* Enable preemptive scheduling */
+}
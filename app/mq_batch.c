@@ -0,0 +1,115 @@
+/* Test for batch message queue operations
+ *
+ * Checks partial batch sends into a queue that fills up, batch receives that
+ * drain it in order, and a receiver blocked in 'mo_mq_recv_many()' taking a
+ * stream of batches sent by another task, then single enqueues.
+ */
+
+#include <linmo.h>
+
+#include "private/error.h"
+
+#define QUEUE_SIZE 8 /* Holds QUEUE_SIZE - 1 messages */
+#define BATCH 5
+#define MESSAGES 100 /* Multiple of BATCH */
+#define DEADLINE 1000
+
+static mq_t *mq;
+static message_t msgs[MESSAGES];
+static volatile uint32_t received, batches, order_errors;
+
+void receiver(void)
+{
+    message_t *out[QUEUE_SIZE];
+
+    while (1) {
+        int32_t n = mo_mq_recv_many(mq, out, QUEUE_SIZE, 0);
+        if (n <= 0)
+            continue;
+        for (int32_t i = 0; i < n; i++) {
+            if (out[i] != &msgs[received])
+                order_errors++;
+            received++;
+        }
+        batches++;
+    }
+}
+
+/* Partial sends and in-order drains on a private queue */
+static bool test_partial(void)
+{
+    mq_t *q = mo_mq_create(QUEUE_SIZE);
+    message_t *batch[QUEUE_SIZE + 2], *out[QUEUE_SIZE];
+
+    for (int i = 0; i < QUEUE_SIZE + 2; i++)
+        batch[i] = &msgs[i];
+
+    bool ok = q && mo_mq_send_many(q, batch, QUEUE_SIZE + 2) == QUEUE_SIZE - 1;
+    ok = ok && mo_mq_recv_many(q, out, 4, 1) == 4 && out[0] == &msgs[0] &&
+         out[3] == &msgs[3];
+    ok = ok && mo_mq_recv_many(q, out, QUEUE_SIZE, 1) == QUEUE_SIZE - 5 &&
+         out[0] == &msgs[4];
+    ok = ok && mo_mq_recv_many(q, out, QUEUE_SIZE, 3) == ERR_TIMEOUT;
+    ok = ok && mo_mq_recv_many(q, out, 0, 1) == ERR_FAIL;
+    return ok && mo_mq_destroy(q) == ERR_OK;
+}
+
+void sender(void)
+{
+    bool partial_ok = test_partial();
+
+    /* Batches first, then the rest one by one */
+    uint32_t sent = 0;
+    while (sent < MESSAGES / 2) {
+        message_t *batch[BATCH];
+        for (int i = 0; i < BATCH; i++)
+            batch[i] = &msgs[sent + i];
+
+        int32_t n = mo_mq_send_many(mq, batch, BATCH);
+        if (n > 0)
+            sent += n;
+        if (n < BATCH)
+            mo_task_yield();
+    }
+    while (sent < MESSAGES) {
+        if (mo_mq_enqueue(mq, &msgs[sent]) == ERR_OK)
+            sent++;
+        else
+            mo_task_yield();
+    }
+
+    uint32_t start = mo_ticks();
+    while (received < MESSAGES && mo_ticks() - start < DEADLINE)
+        mo_task_delay(1);
+
+    bool stream_ok = received == MESSAGES && order_errors == 0;
+
+    printf("\n=== BATCH MQUEUE RESULTS ===\n");
+    printf("%u messages received in %u batches\n", (unsigned) received,
+           (unsigned) batches);
+    printf("Partial send and drain: %s\n", partial_ok ? "PASS" : "FAIL");
+    printf("Blocking batch receive: %s\n", stream_ok ? "PASS" : "FAIL");
+    printf("Overall: %s\n", (partial_ok && stream_ok) ? "PASS" : "FAIL");
+
+    /* Shutdown QEMU cleanly via virt machine's test device */
+    *(volatile uint32_t *) 0x100000U = 0x5555U;
+
+    while (1)
+        mo_task_yield();
+}
+
+int32_t app_main(void)
+{
+    mq = mo_mq_create(QUEUE_SIZE);
+    if (!mq) {
+        printf("FATAL: Failed to create queue\n");
+        return false;
+    }
+
+    if (mo_task_spawn(receiver, 1024) < 0 || mo_task_spawn(sender, 1024) < 0) {
+        printf("FATAL: Failed to create tasks\n");
+        return false;
+    }
+
+    return true; /* Enable preemptive scheduling */
+}
@@ -0,0 +1,246 @@
+/* Test for reference-counted chained packet buffers
+ *
+ * Checks pool accounting while chains are allocated, shared and released
+ * segment by segment, that an exhausted pool fails without side effects,
+ * header push/pop within the headroom, concatenation and copying across
+ * segment boundaries. A producer then passes packets by reference through a
+ * message queue to a consumer that releases them, and a chain goes through a
+ * pipe and back. Every segment must be back in the pool at the end.
+ */
+
+#include <linmo.h>
+
+#include "private/error.h"
+
+#define SEG_SIZE 64
+#define SEGS 8
+#define HEADROOM 16
+#define PACKETS 100 /* Sent through the queue */
+#define PACKET_LEN 100
+#define DEADLINE 1000
+
+static pbuf_pool_t *pool;
+static mq_t *mq;
+static volatile uint32_t received, errors;
+static volatile bool started, sent; /* The pool is the monitor's until then */
+
+static void fill(uint8_t *p, uint16_t len, uint8_t seed)
+{
+    for (uint16_t i = 0; i < len; i++)
+        p[i] = (uint8_t) (i * 3 + seed);
+}
+
+static bool check(const uint8_t *p, uint16_t len, uint8_t seed)
+{
+    for (uint16_t i = 0; i < len; i++) {
+        if (p[i] != (uint8_t) (i * 3 + seed))
+            return false;
+    }
+    return true;
+}
+
+static uint16_t segments(const pbuf_t *p)
+{
+    uint16_t n = 0;
+    for (; p; p = p->next)
+        n++;
+    return n;
+}
+
+/* 150 bytes after 16 of headroom span 48 + 64 + 38 bytes */
+static bool test_pool(void)
+{
+    pbuf_t *p = pbuf_alloc(pool, 150, HEADROOM);
+
+    bool ok = p && segments(p) == 3 && pool->avail == SEGS - 3;
+    ok = ok && p->len == 48 && p->tot_len == 150 && p->next->len == 64 &&
+         p->next->tot_len == 102 && p->next->next->tot_len == 38;
+
+    /* Short pool: nothing is taken */
+    pbuf_t *big = pbuf_alloc(pool, (SEGS - 2) * SEG_SIZE, 0);
+    ok = ok && !big && pool->avail == SEGS - 3;
+    ok = ok && !pbuf_alloc(pool, 1, SEG_SIZE);
+    ok = ok && pbuf_pool_destroy(pool) == ERR_FAIL;
+
+    ok = ok && pbuf_free(p) == 3 && pool->avail == SEGS;
+    return ok;
+}
+
+/* A reference on a later segment stops the release there */
+static bool test_refs(void)
+{
+    pbuf_t *p = pbuf_alloc(pool, 150, HEADROOM);
+    if (!p)
+        return false;
+
+    pbuf_t *rest = p->next;
+    pbuf_ref(rest);
+    bool ok = pbuf_free(p) == 1 && pool->avail == SEGS - 2;
+    pbuf_ref(rest);
+    ok = ok && pbuf_free(rest) == 0 && pool->avail == SEGS - 2;
+    ok = ok && pbuf_free(rest) == 2 && pool->avail == SEGS;
+    return ok;
+}
+
+static bool test_push_pop(void)
+{
+    pbuf_t *p = pbuf_alloc(NULL, 32, 8);
+    if (!p)
+        return false;
+
+    uint8_t *hdr = pbuf_push(p, 8);
+    bool ok = hdr == p->data && p->len == 40 && p->tot_len == 40;
+    ok = ok && !pbuf_push(p, 1);
+    ok = ok && pbuf_pop(p, 41) == ERR_FAIL && pbuf_pop(p, 8) == ERR_OK &&
+         p->payload == p->data + 8 && p->len == 32;
+    ok = ok && pbuf_free(p) == 1;
+
+    /* The segment size must fit 'cap' */
+    return ok && !pbuf_alloc(NULL, UINT16_MAX, 1);
+}
+
+static bool test_cat_copy(void)
+{
+    uint8_t in[140], out[140];
+    pbuf_t *head = pbuf_alloc(pool, 40, 8);
+    pbuf_t *tail = pbuf_alloc(pool, 100, 0);
+    if (!head || !tail)
+        return false;
+
+    pbuf_cat(head, tail);
+    bool ok = segments(head) == 3 && head->tot_len == 140 &&
+              tail->tot_len == 100;
+
+    fill(in, sizeof(in), 7);
+    ok = ok && pbuf_copy_in(head, in, sizeof(in), 0) == sizeof(in);
+    memset(out, 0, sizeof(out));
+    ok = ok && pbuf_copy_out(head, out, 100, 30) == 100 &&
+         !memcmp(out, in + 30, 100);
+    ok = ok && pbuf_copy_out(head, out, 50, 120) == 20 &&
+         !memcmp(out, in + 120, 20);
+    ok = ok && pbuf_copy_in(head, in, 10, 140) == 0;
+
+    return ok && pbuf_free(head) == 3 && pool->avail == SEGS;
+}
+
+/* The chain's bytes go into the pipe's ring and come back in another one */
+static bool test_pipe(void)
+{
+    pipe_t *pipe = mo_pipe_create(256);
+    pbuf_t *src = pbuf_alloc(pool, 150, HEADROOM);
+    pbuf_t *dst = pbuf_alloc(pool, 150, 0);
+    uint8_t in[150], out[150];
+
+    bool ok = pipe && src && dst;
+    if (ok) {
+        fill(in, sizeof(in), 11);
+        pbuf_copy_in(src, in, sizeof(in), 0);
+        ok = mo_pipe_write_pbuf(pipe, src) == 150 &&
+             mo_pipe_read_pbuf(pipe, dst, 150) == 150 &&
+             pbuf_copy_out(dst, out, sizeof(out), 0) == sizeof(out) &&
+             !memcmp(in, out, sizeof(in));
+    }
+
+    pbuf_free(src);
+    pbuf_free(dst);
+    mo_pipe_destroy(pipe);
+    return ok && pool->avail == SEGS;
+}
+
+void producer(void)
+{
+    uint8_t data[PACKET_LEN];
+
+    while (!started)
+        mo_task_yield();
+
+    for (uint32_t n = 0; n < PACKETS; n++) {
+        pbuf_t *p;
+        while (!(p = pbuf_alloc(pool, PACKET_LEN, HEADROOM)))
+            mo_task_yield(); /* Pool empty until the consumer frees some */
+
+        fill(data, PACKET_LEN, (uint8_t) n);
+        pbuf_copy_in(p, data, PACKET_LEN, 0);
+        *(uint8_t *) pbuf_push(p, 1) = (uint8_t) n;
+        while (mo_mq_enqueue_pbuf(mq, p) != ERR_OK)
+            mo_task_yield();
+    }
+    sent = true;
+
+    while (1)
+        mo_task_yield();
+}
+
+void consumer(void)
+{
+    uint8_t data[PACKET_LEN + 1];
+
+    while (1) {
+        pbuf_t *p = mo_mq_dequeue_pbuf(mq);
+        if (!p) {
+            mo_task_yield();
+            continue;
+        }
+
+        if (p->tot_len != PACKET_LEN + 1 ||
+            pbuf_copy_out(p, data, sizeof(data), 0) != sizeof(data) ||
+            !check(data + 1, PACKET_LEN, data[0]))
+            errors++;
+        pbuf_free(p);
+        received++;
+    }
+}
+
+void monitor(void)
+{
+    bool pool_ok = test_pool();
+    bool refs_ok = test_refs();
+    bool push_ok = test_push_pop();
+    bool copy_ok = test_cat_copy();
+    bool pipe_ok = test_pipe();
+    started = true;
+
+    uint32_t start = mo_ticks();
+    while (received < PACKETS && mo_ticks() - start < DEADLINE)
+        mo_task_delay(10);
+
+    bool queue_ok = sent && received == PACKETS && !errors &&
+                    pool->avail == SEGS && pbuf_pool_destroy(pool) == ERR_OK;
+    bool all_ok = pool_ok && refs_ok && push_ok && copy_ok && pipe_ok &&
+                  queue_ok;
+
+    printf("\n=== PBUF RESULTS ===\n");
+    printf("%u/%d packets through the queue\n", (unsigned) received, PACKETS);
+    printf("Pool accounting and exhaustion: %s\n", pool_ok ? "PASS" : "FAIL");
+    printf("Shared chain release: %s\n", refs_ok ? "PASS" : "FAIL");
+    printf("Header push and pop: %s\n", push_ok ? "PASS" : "FAIL");
+    printf("Concatenation and copies: %s\n", copy_ok ? "PASS" : "FAIL");
+    printf("Pipe round trip: %s\n", pipe_ok ? "PASS" : "FAIL");
+    printf("Packets by reference: %s\n", queue_ok ? "PASS" : "FAIL");
+    printf("Overall: %s\n", all_ok ? "PASS" : "FAIL");
+
+    /* Shutdown QEMU cleanly via virt machine's test device */
+    *(volatile uint32_t *) 0x100000U = 0x5555U;
+
+    while (1)
+        mo_task_yield();
+}
+
+int32_t app_main(void)
+{
+    pool = pbuf_pool_create(SEG_SIZE, SEGS);
+    mq = mo_mq_create(SEGS);
+    if (!pool || !mq) {
+        printf("FATAL: Failed to create the pool or queue\n");
+        return false;
+    }
+
+    if (mo_task_spawn(monitor, 1024) < 0 ||
+        mo_task_spawn(producer, 1024) < 0 ||
+        mo_task_spawn(consumer, 1024) < 0) {
+        printf("FATAL: Failed to create tasks\n");
+        return false;
+    }
+
+    return true; /* Enable preemptive scheduling */
+}
@@ -0,0 +1,132 @@
+/* Test for record-mode pipes
+ *
+ * Two writers push records of varying length through one small record pipe
+ * while a reader takes them one read at a time. Every read must return one
+ * whole record from one writer, in order per writer, never two merged or
+ * interleaved. Truncating reads, oversized records and a mode change on a
+ * pipe holding data are checked on a private pipe.
+ */
+
+#include <linmo.h>
+
+#define WRITERS 2
+#define RECORDS 200 /* Per writer */
+#define PIPE_SIZE 64
+#define DEADLINE 1000
+
+static pipe_t *pipe;
+static volatile uint32_t received, errors;
+
+/* Length of record @seq: 3 to 19 bytes, so that records wrap the buffer at
+ * every possible offset
+ */
+static uint32_t record_len(uint8_t seq)
+{
+    return 3 + seq % 17;
+}
+
+void writer(void)
+{
+    static uint8_t next;
+    uint8_t self = next++;
+    char rec[20];
+
+    for (uint32_t seq = 0; seq < RECORDS; seq++) {
+        uint32_t len = record_len((uint8_t) seq);
+        rec[0] = (char) self;
+        rec[1] = (char) seq;
+        memset(rec + 2, self ^ (uint8_t) seq, len - 2);
+        mo_pipe_write(pipe, rec, len);
+    }
+
+    while (1)
+        mo_task_yield();
+}
+
+void reader(void)
+{
+    uint8_t expect[WRITERS] = {0};
+    char rec[32];
+
+    while (1) {
+        int32_t n = mo_pipe_read(pipe, rec, sizeof(rec));
+        uint8_t from = (uint8_t) rec[0], seq = (uint8_t) rec[1];
+        bool ok = n > 2 && from < WRITERS && seq == expect[from] &&
+                  (uint32_t) n == record_len(seq);
+        for (int32_t i = 2; ok && i < n; i++)
+            ok = (uint8_t) rec[i] == (from ^ seq);
+
+        if (!ok)
+            errors++;
+        else
+            expect[from]++;
+        received++;
+    }
+}
+
+static bool test_limits(void)
+{
+    pipe_t *p = mo_pipe_create(16);
+    char big[16] = "0123456789", out[8];
+
+    bool ok = p && mo_pipe_set_mode(p, PIPE_MODE_RECORD) == 0;
+
+    /* A short read takes the head of a record and drops the rest */
+    ok = ok && mo_pipe_write(p, big, 10) == 10 &&
+         mo_pipe_write(p, "ab", 2) == 2;
+    ok = ok && mo_pipe_read(p, out, 4) == 4 && !memcmp(out, "0123", 4);
+    ok = ok && mo_pipe_nbread(p, out, sizeof(out)) == 2 &&
+         !memcmp(out, "ab", 2);
+    ok = ok && mo_pipe_nbread(p, out, sizeof(out)) == 0;
+
+    /* Records go in whole or not at all, and one that can never fit fails */
+    ok = ok && mo_pipe_nbwrite(p, big, 16 - PIPE_RECORD_HDR + 1) < 0 &&
+         mo_pipe_write(p, big, 16) < 0;
+    ok = ok && mo_pipe_nbwrite(p, big, 10) == 10 &&
+         mo_pipe_nbwrite(p, big, 10) == 0;
+
+    /* Framing cannot change under queued data */
+    ok = ok && mo_pipe_set_mode(p, PIPE_MODE_STREAM) != 0;
+    return ok && mo_pipe_destroy(p) == 0;
+}
+
+void monitor(void)
+{
+    bool limits_ok = test_limits();
+
+    uint32_t start = mo_ticks();
+    while (received < WRITERS * RECORDS && mo_ticks() - start < DEADLINE)
+        mo_task_delay(5);
+
+    bool stream_ok = received == WRITERS * RECORDS && errors == 0;
+
+    printf("\n=== RECORD PIPE RESULTS ===\n");
+    printf("%u/%d records, %u bad\n", (unsigned) received, WRITERS * RECORDS,
+           (unsigned) errors);
+    printf("Truncation and limits: %s\n", limits_ok ? "PASS" : "FAIL");
+    printf("Record boundaries: %s\n", stream_ok ? "PASS" : "FAIL");
+    printf("Overall: %s\n", (limits_ok && stream_ok) ? "PASS" : "FAIL");
+
+    /* Shutdown QEMU cleanly via virt machine's test device */
+    *(volatile uint32_t *) 0x100000U = 0x5555U;
+
+    while (1)
+        mo_task_yield();
+}
+
+int32_t app_main(void)
+{
+    pipe = mo_pipe_create(PIPE_SIZE);
+    if (!pipe || mo_pipe_set_mode(pipe, PIPE_MODE_RECORD) != 0) {
+        printf("FATAL: Failed to create pipe\n");
+        return false;
+    }
+
+    if (mo_task_spawn(writer, 1024) < 0 || mo_task_spawn(writer, 1024) < 0 ||
+        mo_task_spawn(reader, 1024) < 0 || mo_task_spawn(monitor, 1024) < 0) {
+        printf("FATAL: Failed to create tasks\n");
+        return false;
+    }
+
+    return true; /* Enable preemptive scheduling */
+}
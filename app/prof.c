@@ -0,0 +1,83 @@
+/* Test for the statistical PC-sampling profiler
+ *
+ * A burner task keeps the CPU busy while the profiler samples at a rate ten
+ * times the scheduler tick. The sample count must match the rate over the
+ * measured time, the scheduler tick must keep its own rate meanwhile, and
+ * sampling must stop when told to. The samples are dumped at the end for
+ * 'scripts/profile.py'. Build with PROFILER=1.
+ */
+
+#include <linmo.h>
+
+#include "private/error.h"
+
+#define HZ (10 * F_TIMER) /* Sampling rate */
+#define WINDOW 50         /* Ticks sampled */
+
+static volatile uint32_t burned;
+
+void burner(void)
+{
+    while (1)
+        burned++;
+}
+
+/* True if @n is within a quarter of @expect */
+static bool near(uint32_t n, uint32_t expect)
+{
+    return n >= expect - expect / 4 && n <= expect + expect / 4;
+}
+
+void monitor(void)
+{
+    bool invalid_ok = mo_prof_start(0) == ERR_FAIL &&
+                      mo_prof_start(PROF_MAX_HZ + 1) == ERR_FAIL;
+
+    uint32_t start = mo_ticks();
+    uint64_t start_us = _read_us();
+    bool started = mo_prof_start(HZ) == ERR_OK;
+    mo_task_delay(WINDOW);
+    mo_prof_stop();
+    uint32_t ticks = mo_ticks() - start;
+    uint32_t us = (uint32_t) (_read_us() - start_us);
+    uint32_t count = mo_prof_count();
+
+    /* No more samples once stopped */
+    mo_task_delay(5);
+    bool stop_ok = started && mo_prof_count() == count;
+
+    uint32_t expect = (uint32_t) ((uint64_t) us * HZ / 1000000);
+    bool rate_ok = started && near(count, expect);
+    bool tick_ok = near(ticks, (uint32_t) ((uint64_t) us * F_TIMER / 1000000));
+
+    printf("\n=== PROFILER RESULTS ===\n");
+    if (!started)
+        printf("Profiler not built in, build with PROFILER=1\n");
+    printf("%u samples in %u us (%u expected), %u ticks\n", (unsigned) count,
+           (unsigned) us, (unsigned) expect, (unsigned) ticks);
+    printf("Invalid rates rejected: %s\n", invalid_ok ? "PASS" : "FAIL");
+    printf("Sampling rate: %s\n", rate_ok ? "PASS" : "FAIL");
+    printf("Tick rate unaffected: %s\n", tick_ok ? "PASS" : "FAIL");
+    printf("Stopped: %s\n", stop_ok ? "PASS" : "FAIL");
+    printf("Overall: %s\n",
+           (invalid_ok && rate_ok && tick_ok && stop_ok) ? "PASS" : "FAIL");
+
+    mo_prof_dump();
+    mo_logger_flush(); /* Let the dump reach the console first */
+
+    /* Shutdown QEMU cleanly via virt machine's test device */
+    *(volatile uint32_t *) 0x100000U = 0x5555U;
+
+    while (1)
+        mo_task_yield();
+}
+
+int32_t app_main(void)
+{
+    if (mo_task_spawn(burner, 512) < 0 || mo_task_spawn(monitor, 1024) < 0) {
+        printf("FATAL: Failed to create tasks\n");
+        return false;
+    }
+
+    return true; /* Enable preemptive scheduling */
+}
@@ -0,0 +1,221 @@
+/* Test for stackless protothreads
+ *
+ * One task runs a few hundred protothreads: periodic blinkers that sleep
+ * between toggles, a producer and a consumer passing sequence numbers
+ * through a stream pipe and records through a record pipe, and two waiters
+ * on a semaphore, one of which is signalled by a regular task while the
+ * other times out. Writes that can never fit either pipe must fail at once
+ * instead of waiting forever.
+ */
+
+#include <linmo.h>
+
+#define BLINKERS 200
+#define TOGGLES 5
+#define MESSAGES 64
+#define RECORDS 16
+#define RECORD_SIZE 6 /* Two records plus headers fill the record pipe */
+
+typedef struct {
+    pt_t pt;
+    uint32_t toggles;
+} blinker_t;
+
+static blinker_t blinkers[BLINKERS];
+static pt_t producer_pt, consumer_pt, signalled_pt, timeout_pt;
+static pt_t rec_writer_pt, rec_reader_pt;
+static pt_runner_t runner;
+
+static pipe_t *pipe, *rec_pipe;
+static sem_t *sem;
+
+static uint32_t produced, consumed, order_errors;
+static uint32_t rec_sent, rec_received, rec_errors;
+static uint32_t oversize_failed;
+static bool signalled_ok, timeout_ok;
+
+static char oversize[128]; /* Fits neither pipe */
+static int32_t oversize_before;
+
+static int8_t blink(pt_t *pt)
+{
+    blinker_t *b = pt->arg;
+
+    PT_BEGIN(pt);
+    while (b->toggles < TOGGLES) {
+        b->toggles++;
+        PT_SLEEP(pt, 1 + (b - blinkers) % 4);
+    }
+    PT_END(pt);
+}
+
+static int8_t producer(pt_t *pt)
+{
+    PT_BEGIN(pt);
+    while (produced < MESSAGES) {
+        PT_PIPE_WRITE(pt, pipe, (const char *) &produced, sizeof(produced));
+        if (PT_PIPE_FAILED(pt))
+            order_errors++;
+        produced++;
+        if (produced % 8 == 0)
+            PT_YIELD(pt);
+    }
+
+    oversize_before = mo_pipe_size(pipe);
+    PT_PIPE_WRITE(pt, pipe, oversize, sizeof(oversize));
+    if (PT_PIPE_FAILED(pt) && mo_pipe_size(pipe) == oversize_before)
+        oversize_failed++;
+    PT_END(pt);
+}
+
+static int8_t consumer(pt_t *pt)
+{
+    static uint32_t value;
+    static int32_t n;
+
+    PT_BEGIN(pt);
+    while (consumed < MESSAGES) {
+        PT_PIPE_READ(pt, pipe, (char *) &value, sizeof(value), n);
+        if (n != sizeof(value) || value != consumed)
+            order_errors++;
+        consumed++;
+    }
+    PT_END(pt);
+}
+
+static int8_t rec_writer(pt_t *pt)
+{
+    static char rec[RECORD_SIZE];
+
+    PT_BEGIN(pt);
+    while (rec_sent < RECORDS) {
+        memset(rec, 'a' + rec_sent, sizeof(rec));
+        PT_PIPE_WRITE(pt, rec_pipe, rec, sizeof(rec));
+        rec_sent++;
+    }
+
+    PT_PIPE_WRITE(pt, rec_pipe, oversize, sizeof(oversize));
+    if (PT_PIPE_FAILED(pt))
+        oversize_failed++;
+    PT_END(pt);
+}
+
+static int8_t rec_reader(pt_t *pt)
+{
+    static char rec[RECORD_SIZE + 2];
+    static int32_t n;
+
+    PT_BEGIN(pt);
+    while (rec_received < RECORDS) {
+        PT_PIPE_READ(pt, rec_pipe, rec, sizeof(rec), n);
+        if (n != RECORD_SIZE || rec[0] != (char) ('a' + rec_received))
+            rec_errors++;
+        rec_received++;
+    }
+    PT_END(pt);
+}
+
+static int8_t signalled_waiter(pt_t *pt)
+{
+    PT_BEGIN(pt);
+    PT_SEM_WAIT_TIMEOUT(pt, sem, 1000);
+    signalled_ok = !PT_TIMED_OUT(pt);
+    PT_END(pt);
+}
+
+static int8_t timeout_waiter(pt_t *pt)
+{
+    PT_BEGIN(pt);
+    /* Wait until the signalled waiter is done with the only token */
+    PT_WAIT_UNTIL(pt, signalled_pt.state == PT_EXITED);
+    PT_SEM_WAIT_TIMEOUT(pt, sem, 5);
+    timeout_ok = PT_TIMED_OUT(pt);
+    PT_END(pt);
+}
+
+/* A regular task releasing the semaphore a little later */
+void signaller(void)
+{
+    mo_task_delay(3);
+    mo_sem_signal(sem);
+
+    while (1)
+        mo_task_yield();
+}
+
+void host_task(void)
+{
+    for (int i = 0; i < BLINKERS; i++) {
+        mo_pt_init(&blinkers[i].pt, blink, &blinkers[i]);
+        mo_pt_add(&runner, &blinkers[i].pt);
+    }
+    mo_pt_init(&producer_pt, producer, NULL);
+    mo_pt_init(&consumer_pt, consumer, NULL);
+    mo_pt_init(&signalled_pt, signalled_waiter, NULL);
+    mo_pt_init(&timeout_pt, timeout_waiter, NULL);
+    mo_pt_add(&runner, &producer_pt);
+    mo_pt_add(&runner, &consumer_pt);
+    mo_pt_add(&runner, &signalled_pt);
+    mo_pt_add(&runner, &timeout_pt);
+    mo_pt_init(&rec_writer_pt, rec_writer, NULL);
+    mo_pt_init(&rec_reader_pt, rec_reader, NULL);
+    mo_pt_add(&runner, &rec_writer_pt);
+    mo_pt_add(&runner, &rec_reader_pt);
+
+    uint32_t start = mo_ticks();
+    mo_pt_run(&runner);
+    uint32_t elapsed = mo_ticks() - start;
+
+    uint32_t toggles = 0;
+    for (int i = 0; i < BLINKERS; i++)
+        toggles += blinkers[i].toggles;
+
+    bool blink_ok = toggles == BLINKERS * TOGGLES;
+    bool pipe_ok = consumed == MESSAGES && order_errors == 0;
+    bool rec_ok = rec_received == RECORDS && rec_errors == 0;
+    bool oversize_ok = oversize_failed == 2;
+
+    printf("\n=== PROTOTHREAD RESULTS ===\n");
+    printf("%d protothreads in %u bytes, done in %u ticks\n", BLINKERS + 6,
+           (unsigned) ((BLINKERS + 6) * sizeof(pt_t)), (unsigned) elapsed);
+    printf("Blinkers: %u/%d toggles: %s\n", (unsigned) toggles,
+           BLINKERS * TOGGLES, blink_ok ? "PASS" : "FAIL");
+    printf("Pipe: %u/%d in order: %s\n", (unsigned) consumed, MESSAGES,
+           pipe_ok ? "PASS" : "FAIL");
+    printf("Record pipe: %u/%d records: %s\n", (unsigned) rec_received,
+           RECORDS, rec_ok ? "PASS" : "FAIL");
+    printf("Oversized writes fail: %s\n", oversize_ok ? "PASS" : "FAIL");
+    printf("Semaphore wait: %s\n", signalled_ok ? "PASS" : "FAIL");
+    printf("Semaphore timeout: %s\n", timeout_ok ? "PASS" : "FAIL");
+    printf("Overall: %s\n",
+           (blink_ok && pipe_ok && rec_ok && oversize_ok && signalled_ok &&
+            timeout_ok)
+               ? "PASS"
+               : "FAIL");
+
+    /* Shutdown QEMU cleanly via virt machine's test device */
+    *(volatile uint32_t *) 0x100000U = 0x5555U;
+
+    while (1)
+        mo_task_yield();
+}
+
+int32_t app_main(void)
+{
+    pipe = mo_pipe_create(64);
+    rec_pipe = mo_pipe_create(16);
+    sem = mo_sem_create(1, 0);
+    if (!pipe || !rec_pipe || !sem ||
+        mo_pipe_set_mode(rec_pipe, PIPE_MODE_RECORD) != 0) {
+        printf("FATAL: Failed to create pipe or semaphore\n");
+        return false;
+    }
+
+    if (mo_task_spawn(host_task, 1024) < 0 ||
+        mo_task_spawn(signaller, 512) < 0) {
+        printf("FATAL: Failed to create tasks\n");
+        return false;
+    }
+
+    return true; /* Enable preemptive scheduling */
+}
@@ -0,0 +1,147 @@
+/* Test for the vectored interrupt entry stubs
+ *
+ * A handler attached to the machine software interrupt must run once per
+ * raise and stop running once detached; a raise left pending while detached
+ * is taken as soon as the handler is attached again. A software interrupt
+ * taken in the middle of an asm block must leave every register it holds
+ * intact. Finally a burst of raises runs alongside a spinner and the timer,
+ * so the software, timer and context switch paths keep interleaving.
+ */
+
+#include <linmo.h>
+
+#include "spin.h"
+
+#define CLINT_MSIP 0x02000000U /* Hart 0 on the QEMU virt machine */
+#define ROUNDS 100
+#define DURATION 10 /* Ticks spent raising back to back */
+#define WAIT 100000 /* Polls before a raise counts as lost */
+
+static volatile uint32_t fired;
+
+static void soft_handler(void)
+{
+    fired++;
+}
+
+/* Raises the interrupt and polls until the handler has run */
+static bool raise_and_wait(void)
+{
+    uint32_t before = fired;
+
+    hal_soft_irq_raise();
+    for (uint32_t i = 0; i < WAIT; i++) {
+        if (fired != before)
+            return fired == before + 1;
+    }
+    return false;
+}
+
+static bool test_dispatch(void)
+{
+    bool ok = hal_irq_attach(HAL_IRQ_SOFT, soft_handler) == 0;
+    for (int i = 0; ok && i < ROUNDS; i++)
+        ok = raise_and_wait();
+    return ok;
+}
+
+static bool test_detach(void)
+{
+    bool ok = hal_irq_attach(HAL_IRQ_SOFT, NULL) == 0;
+    uint32_t before = fired;
+
+    hal_soft_irq_raise();
+    for (uint32_t i = 0; i < WAIT / 10; i++)
+        asm volatile("nop");
+    ok = ok && fired == before;
+
+    /* The pending raise is taken right after attaching */
+    ok = ok && hal_irq_attach(HAL_IRQ_SOFT, soft_handler) == 0;
+    for (uint32_t i = 0; i < WAIT && fired == before; i++)
+        asm volatile("nop");
+    return ok && fired == before + 1;
+}
+
+/* The raise and the wait happen inside the asm block, so the interrupt lands
+ * while all of the values below are held in registers.
+ */
+static bool test_registers(void)
+{
+    uint32_t v0 = 0x01234567, v1 = 0x89ABCDEF, v2 = 0xDEADBEEF;
+    uint32_t v3 = 0xA5A5A5A5, v4 = 0x5A5A5A5A, v5 = 0x0F0F0F0F;
+    uint32_t v6 = 0xF0F0F0F0, v7 = 0x13579BDF, v8 = 0x2468ACE0;
+    uint32_t v9 = 0x7FFFFFFF, v10 = 0x80000001, v11 = 0xCAFEF00D;
+    uint32_t before = fired, polls = WAIT, seen;
+
+    asm volatile(
+        "sw %[one], 0(%[msip])\n"
+        "1: lw %[seen], 0(%[cnt])\n"
+        "bne %[seen], %[before], 2f\n"
+        "addi %[polls], %[polls], -1\n"
+        "bnez %[polls], 1b\n"
+        "2:\n"
+        : [seen] "=&r"(seen), [polls] "+r"(polls), "+r"(v0), "+r"(v1),
+          "+r"(v2), "+r"(v3), "+r"(v4), "+r"(v5), "+r"(v6), "+r"(v7),
+          "+r"(v8), "+r"(v9), "+r"(v10), "+r"(v11)
+        : [one] "r"(1), [msip] "r"(CLINT_MSIP), [cnt] "r"(&fired),
+          [before] "r"(before)
+        : "memory");
+
+    return seen == before + 1 && v0 == 0x01234567 && v1 == 0x89ABCDEF &&
+           v2 == 0xDEADBEEF && v3 == 0xA5A5A5A5 && v4 == 0x5A5A5A5A &&
+           v5 == 0x0F0F0F0F && v6 == 0xF0F0F0F0 && v7 == 0x13579BDF &&
+           v8 == 0x2468ACE0 && v9 == 0x7FFFFFFF && v10 == 0x80000001 &&
+           v11 == 0xCAFEF00D;
+}
+
+/* Preemption stays on, so ticks and task switches land between raises */
+static bool test_burst(uint32_t *raised)
+{
+    uint32_t start = mo_ticks(), before = fired;
+    bool ok = true;
+
+    *raised = 0;
+    while (ok && mo_ticks() - start < DURATION) {
+        ok = raise_and_wait();
+        (*raised)++;
+    }
+    return ok && fired == before + *raised && spins;
+}
+
+void monitor(void)
+{
+    uint32_t raised = 0;
+
+    bool dispatch_ok = test_dispatch();
+    bool detach_ok = dispatch_ok && test_detach();
+    bool regs_ok = dispatch_ok && test_registers();
+    bool burst_ok = dispatch_ok && test_burst(&raised);
+    hal_irq_attach(HAL_IRQ_SOFT, NULL);
+    bool all_ok = dispatch_ok && detach_ok && regs_ok && burst_ok;
+
+    printf("\n=== SOFTIRQ RESULTS ===\n");
+    printf("%u software interrupts, %u of them over %d ticks\n",
+           (unsigned) fired, (unsigned) raised, DURATION);
+    printf("Handler runs once per raise: %s\n", dispatch_ok ? "PASS" : "FAIL");
+    printf("Detach and reattach: %s\n", detach_ok ? "PASS" : "FAIL");
+    printf("Registers preserved: %s\n", regs_ok ? "PASS" : "FAIL");
+    printf("Raised alongside ticks: %s\n", burst_ok ? "PASS" : "FAIL");
+    printf("Overall: %s\n", all_ok ? "PASS" : "FAIL");
+
+    /* Shutdown QEMU cleanly via virt machine's test device */
+    *(volatile uint32_t *) 0x100000U = 0x5555U;
+
+    while (1)
+        mo_task_yield();
+}
+
+int32_t app_main(void)
+{
+    if (mo_task_spawn(monitor, 1024) < 0 ||
+        mo_task_spawn(spinner, 1024) < 0) {
+        printf("FATAL: Failed to create tasks\n");
+        return false;
+    }
+
+    return true; /* Enable preemptive scheduling */
+}
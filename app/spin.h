@@ -0,0 +1,25 @@
+#pragma once
+
+/* Busy loops shared by the scheduler tests
+ *
+ * 'spinner()' is a task that never blocks and counts its rounds in 'spins',
+ * so a test can tell whether it got the CPU during an interval.
+ */
+
+#include <linmo.h>
+
+static volatile uint32_t spins;
+
+static inline void spinner(void)
+{
+    while (1)
+        spins++;
+}
+
+/* Busy-waits for @ticks ticks without giving up the CPU */
+static inline void spin_ticks(uint32_t ticks)
+{
+    uint32_t start = mo_ticks();
+    while (mo_ticks() - start < ticks)
+        ;
+}
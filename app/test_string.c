@@ -0,0 +1,156 @@
+/* Test for the word-at-a-time string functions
+ *
+ * Checks strlen, memchr and strcmp against byte-by-byte references for every
+ * alignment, for lengths across several words, and for bytes with the high
+ * bit set. Build with a Zbb profile (e.g. ISA=rv32imac_zba_zbb) to cover the
+ * 'orc.b' fast paths; the default profile covers the portable ones.
+ */
+
+#include <linmo.h>
+
+#define MAX_LEN 40
+#define MAX_OFFSET 8
+
+static char a[MAX_OFFSET + MAX_LEN + 8] __attribute__((aligned(4)));
+static char b[MAX_OFFSET + MAX_LEN + 8] __attribute__((aligned(4)));
+
+/* Non-zero bytes, including ones with the high bit set */
+static char pattern(int i)
+{
+    static const uint8_t bytes[] = {'a', 0x80, 'z', 0xFF, 0x01, 0x7F, 'Q'};
+    return (char) bytes[i % sizeof(bytes)];
+}
+
+static size_t ref_strlen(const char *s)
+{
+    size_t n = 0;
+    while (s[n])
+        n++;
+    return n;
+}
+
+static int32_t ref_strcmp(const char *s1, const char *s2)
+{
+    while (*s1 && *s1 == *s2)
+        s1++, s2++;
+    return (int32_t) ((unsigned char) *s1 - (unsigned char) *s2);
+}
+
+static int test_strlen(void)
+{
+    int failures = 0;
+
+    for (int off = 0; off < MAX_OFFSET; off++) {
+        for (int len = 0; len <= MAX_LEN; len++) {
+            char *s = a + off;
+            for (int i = 0; i < len; i++)
+                s[i] = pattern(i);
+            s[len] = 0;
+            s[len + 1] = 'x'; /* A non-zero byte in the same word */
+            if (strlen(s) != (size_t) len || ref_strlen(s) != (size_t) len)
+                failures++;
+        }
+    }
+    return failures;
+}
+
+static int test_memchr(void)
+{
+    int failures = 0;
+
+    for (int off = 0; off < MAX_OFFSET; off++) {
+        for (int n = 0; n <= MAX_LEN; n++) {
+            uint8_t *s = (uint8_t *) a + off;
+
+            /* Target at every position, and just past the end */
+            for (int k = 0; k <= n; k++) {
+                memset(s, 0x11, n + 4);
+                s[k] = 0xA5;
+                void *want = k < n ? s + k : NULL;
+                /* Only the low byte of the character counts */
+                if (memchr(s, 0xA5, n) != want ||
+                    memchr(s, 0x1A5, n) != want)
+                    failures++;
+            }
+
+            /* Zero bytes are found like any other */
+            memset(s, 0x11, n + 4);
+            s[n / 2] = 0;
+            if (memchr(s, 0, n) != (n ? s + n / 2 : NULL))
+                failures++;
+        }
+    }
+    return failures;
+}
+
+/* Compares @s1 and @s2 both ways, checking the sign and the value */
+static int check_strcmp(const char *s1, const char *s2)
+{
+    return strcmp(s1, s2) != ref_strcmp(s1, s2) ||
+           strcmp(s2, s1) != ref_strcmp(s2, s1);
+}
+
+static int test_strcmp(void)
+{
+    static const uint8_t other[] = {0x01, 'b', 0x7F, 0x80, 0xFE};
+    int failures = 0;
+
+    /* Same and different alignments of the two strings */
+    for (int off1 = 0; off1 < 4; off1++) {
+        for (int off2 = 0; off2 < 4; off2++) {
+            for (int len = 0; len <= MAX_LEN; len++) {
+                char *s1 = a + off1, *s2 = b + off2;
+                for (int i = 0; i < len; i++)
+                    s1[i] = s2[i] = pattern(i);
+                s1[len] = s2[len] = 0;
+                failures += check_strcmp(s1, s2);
+
+                /* One differing byte at every position */
+                for (int k = 0; k < len; k++) {
+                    for (size_t v = 0; v < sizeof(other); v++) {
+                        s2[k] = (char) other[v];
+                        failures += check_strcmp(s1, s2);
+                    }
+                    s2[k] = 0; /* @s2 ends early */
+                    failures += check_strcmp(s1, s2);
+                    s2[k] = s1[k];
+                }
+            }
+        }
+    }
+    return failures;
+}
+
+void test_task(void)
+{
+    int strlen_failures = test_strlen();
+    int memchr_failures = test_memchr();
+    int strcmp_failures = test_strcmp();
+
+    printf("\n=== STRING RESULTS ===\n");
+#if defined(__riscv_zbb)
+    printf("Using the Zbb paths\n");
+#endif
+    printf("strlen: %s\n", strlen_failures ? "FAIL" : "PASS");
+    printf("memchr: %s\n", memchr_failures ? "FAIL" : "PASS");
+    printf("strcmp: %s\n", strcmp_failures ? "FAIL" : "PASS");
+    printf("Overall: %s\n",
+           (strlen_failures || memchr_failures || strcmp_failures) ? "FAIL"
+                                                                   : "PASS");
+
+    /* Shutdown QEMU cleanly via virt machine's test device */
+    *(volatile uint32_t *) 0x100000U = 0x5555U;
+
+    while (1)
+        mo_task_yield();
+}
+
+int32_t app_main(void)
+{
+    if (mo_task_spawn(test_task, 2048) < 0) {
+        printf("FATAL: Failed to create tasks\n");
+        return false;
+    }
+
+    return true; /* Enable preemptive scheduling */
+}
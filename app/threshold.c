@@ -0,0 +1,91 @@
+/* Test for preemption thresholds
+ *
+ * A tester busy-waits with its threshold raised to high priority while a
+ * spinner of its own priority stays ready. Ticks must not hand the CPU to the
+ * spinner, but must still hand it to a task raised above the threshold, which
+ * gives it back to the tester rather than to the spinner. The spinner runs
+ * again once the threshold is cleared.
+ */
+
+#include <linmo.h>
+
+#include "private/error.h"
+#include "spin.h"
+
+#define SPIN_TICKS 20
+
+static volatile bool armed, urgent_ran;
+static int32_t urgent_id;
+
+/* Ready on every tick, but only counts once raised above the threshold */
+void urgent(void)
+{
+    while (1) {
+        if (armed)
+            urgent_ran = true;
+        mo_task_delay(1);
+    }
+}
+
+void tester(void)
+{
+    uint16_t self = mo_task_id();
+
+    /* Let the spinner get going first */
+    mo_task_delay(2);
+
+    bool invalid_ok =
+        mo_task_preempt_threshold(self, TASK_PRIO_LOW) == ERR_TASK_INVALID_PRIO;
+    bool set_ok = mo_task_preempt_threshold(self, TASK_PRIO_HIGH) == ERR_OK;
+
+    uint32_t snap = spins;
+    spin_ticks(SPIN_TICKS);
+    bool held_ok = spins == snap;
+
+    /* The urgent task preempts every tick, and the tester must get the CPU
+     * back each time rather than the spinner sharing its threshold.
+     */
+    armed = true;
+    snap = spins;
+    mo_task_priority(urgent_id, TASK_PRIO_REALTIME);
+    spin_ticks(SPIN_TICKS);
+    bool preempt_ok = urgent_ran;
+    bool peer_ok = spins == snap;
+
+    bool clear_ok = mo_task_preempt_threshold(self, TASK_PRIO_NORMAL) == ERR_OK;
+    snap = spins;
+    spin_ticks(SPIN_TICKS);
+    clear_ok = clear_ok && spins != snap;
+
+    printf("\n=== PREEMPTION THRESHOLD RESULTS ===\n");
+    printf("Invalid threshold rejected: %s\n", invalid_ok ? "PASS" : "FAIL");
+    printf("Same priority held off: %s\n",
+           (set_ok && held_ok) ? "PASS" : "FAIL");
+    printf("Preempted above threshold: %s\n", preempt_ok ? "PASS" : "FAIL");
+    printf("Peer held off around preemption: %s\n",
+           peer_ok ? "PASS" : "FAIL");
+    printf("Threshold cleared: %s\n", clear_ok ? "PASS" : "FAIL");
+    printf("Overall: %s\n",
+           (invalid_ok && set_ok && held_ok && preempt_ok && peer_ok &&
+            clear_ok)
+               ? "PASS"
+               : "FAIL");
+
+    /* Shutdown QEMU cleanly via virt machine's test device */
+    *(volatile uint32_t *) 0x100000U = 0x5555U;
+
+    while (1)
+        mo_task_yield();
+}
+
+int32_t app_main(void)
+{
+    urgent_id = mo_task_spawn(urgent, 512);
+    if (mo_task_spawn(spinner, 512) < 0 || urgent_id < 0 ||
+        mo_task_spawn(tester, 1024) < 0) {
+        printf("FATAL: Failed to create tasks\n");
+        return false;
+    }
+
+    return true; /* Enable preemptive scheduling */
+}
@@ -0,0 +1,103 @@
+/* Test for tick-native, phase-aligned timers
+ *
+ * Timers with periods given in ticks are started against a common base tick
+ * with 'mo_timer_start_at()'. Every expiry must fall on the base plus a whole
+ * number of periods, including those of a timer whose slack makes it fire
+ * late; and a start in the past must fire on the next tick.
+ */
+
+#include <linmo.h>
+
+#define FAST 3
+#define SLOW 10
+#define LATE 7 /* Period of the timer with slack */
+#define SLACK_MS (4 * 1000 / F_TIMER)
+#define SLACK MS_TO_TICKS(SLACK_MS)
+#define EVENTS 12
+#define LEAD 5 /* Ticks from now to the base tick */
+
+/* Ticks of the first EVENTS occurrences of something */
+typedef struct {
+    volatile uint32_t at[EVENTS];
+    volatile int n;
+} trace_t;
+
+static trace_t fast, slow, late, past;
+
+static void *on_timer(void *arg)
+{
+    trace_t *t = arg;
+    if (t->n < EVENTS)
+        t->at[t->n++] = mo_ticks();
+    return NULL;
+}
+
+/* Checks that the expiries of @t are the deadlines @base + i * @period,
+ * each delayed by at most @slack ticks
+ */
+static bool aligned(const trace_t *t, uint32_t base, uint32_t period,
+                    uint32_t slack)
+{
+    if (t->n < EVENTS)
+        return false;
+    for (int i = 0; i < EVENTS; i++) {
+        uint32_t late_by = t->at[i] - (base + i * period);
+        if (late_by > slack)
+            return false;
+    }
+    return true;
+}
+
+void tester(void)
+{
+    int32_t fast_id = mo_timer_create_ticks(on_timer, FAST, &fast);
+    int32_t slow_id = mo_timer_create_ticks(on_timer, SLOW, &slow);
+    int32_t late_id = mo_timer_create_ticks(on_timer, LATE, &late);
+    int32_t past_id = mo_timer_create_ticks(on_timer, SLOW, &past);
+    bool setup_ok = fast_id > 0 && slow_id > 0 && late_id > 0 && past_id > 0 &&
+                    mo_timer_set_slack(late_id, SLACK_MS) == 0;
+
+    uint32_t base = mo_ticks() + LEAD;
+    setup_ok = setup_ok &&
+               mo_timer_start_at(fast_id, base, TIMER_AUTORELOAD) == 0 &&
+               mo_timer_start_at(slow_id, base, TIMER_AUTORELOAD) == 0 &&
+               mo_timer_start_at(late_id, base, TIMER_AUTORELOAD) == 0;
+    uint32_t now = mo_ticks();
+    setup_ok = setup_ok &&
+               mo_timer_start_at(past_id, now - LEAD, TIMER_ONESHOT) == 0;
+
+    mo_task_delay(LEAD + EVENTS * (SLOW + 1));
+    mo_timer_destroy(fast_id);
+    mo_timer_destroy(slow_id);
+    mo_timer_destroy(late_id);
+    mo_timer_destroy(past_id);
+
+    bool phase_ok = setup_ok && aligned(&fast, base, FAST, 0) &&
+                    aligned(&slow, base, SLOW, 0);
+    bool late_ok = aligned(&late, base, LATE, SLACK);
+    bool past_ok = past.n == 1 && past.at[0] - now <= 1;
+
+    printf("\n=== TIMER PHASE RESULTS ===\n");
+    printf("Tick periods aligned to a common base: %s\n",
+           phase_ok ? "PASS" : "FAIL");
+    printf("Phase kept when fired late: %s\n", late_ok ? "PASS" : "FAIL");
+    printf("Start in the past fires at once: %s\n", past_ok ? "PASS" : "FAIL");
+    printf("Overall: %s\n",
+           (phase_ok && late_ok && past_ok) ? "PASS" : "FAIL");
+
+    /* Shutdown QEMU cleanly via virt machine's test device */
+    *(volatile uint32_t *) 0x100000U = 0x5555U;
+
+    while (1)
+        mo_task_yield();
+}
+
+int32_t app_main(void)
+{
+    if (mo_task_spawn(tester, 1024) < 0) {
+        printf("FATAL: Failed to create tasks\n");
+        return false;
+    }
+
+    return true; /* Enable preemptive scheduling */
+}
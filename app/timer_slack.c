@@ -0,0 +1,141 @@
+/* Test for timer and delay slack
+ *
+ * A strict timer fires every STRICT ticks next to a loose one with a period
+ * of LOOSE ticks and a slack of SLACK ticks; two tasks sleep the same way
+ * with 'mo_task_delay()' and 'mo_task_delay_slack()'. The strict events must
+ * stay on time, the loose ones must never leave their window, and some of
+ * them must have been moved onto the ticks of the strict ones.
+ */
+
+#include <linmo.h>
+
+#define STRICT 10
+#define LOOSE 7
+#define SLACK 5
+#define EVENTS 12
+
+/* Ticks of the first EVENTS occurrences of something */
+typedef struct {
+    volatile uint32_t at[EVENTS];
+    volatile int n;
+} trace_t;
+
+static trace_t strict_timer, loose_timer, strict_sleep, loose_sleep;
+static volatile bool started;
+
+static void note(trace_t *t)
+{
+    if (t->n < EVENTS)
+        t->at[t->n++] = mo_ticks();
+}
+
+static void *on_timer(void *arg)
+{
+    note(arg);
+    return NULL;
+}
+
+void strict_sleeper(void)
+{
+    while (!started)
+        mo_task_yield();
+    while (1) {
+        mo_task_delay(STRICT);
+        note(&strict_sleep);
+    }
+}
+
+void loose_sleeper(void)
+{
+    while (!started)
+        mo_task_yield();
+    while (1) {
+        mo_task_delay_slack(LOOSE, SLACK);
+        note(&loose_sleep);
+    }
+}
+
+/* Checks that all EVENTS occurred, spaced @lo to @hi ticks apart */
+static bool spaced(const trace_t *t, uint32_t lo, uint32_t hi)
+{
+    if (t->n < EVENTS)
+        return false;
+    for (int i = 1; i < EVENTS; i++) {
+        uint32_t gap = t->at[i] - t->at[i - 1];
+        if (gap < lo || gap > hi)
+            return false;
+    }
+    return true;
+}
+
+/* Counts the events of @t that happened on the tick of an event of @on */
+static int shared(const trace_t *t, const trace_t *on)
+{
+    int count = 0;
+    for (int i = 0; i < t->n; i++) {
+        for (int j = 0; j < on->n; j++) {
+            if (t->at[i] == on->at[j]) {
+                count++;
+                break;
+            }
+        }
+    }
+    return count;
+}
+
+void tester(void)
+{
+    int32_t strict = mo_timer_create(on_timer, STRICT * 1000 / F_TIMER,
+                                     (void *) &strict_timer);
+    int32_t loose = mo_timer_create(on_timer, LOOSE * 1000 / F_TIMER,
+                                    (void *) &loose_timer);
+    bool setup_ok = strict > 0 && loose > 0 &&
+                    mo_timer_set_slack(loose, SLACK * 1000 / F_TIMER) == 0 &&
+                    mo_timer_start(strict, TIMER_AUTORELOAD) == 0 &&
+                    mo_timer_start(loose, TIMER_AUTORELOAD) == 0;
+    started = true;
+
+    mo_task_delay(EVENTS * (LOOSE + SLACK + STRICT));
+    mo_timer_destroy(strict);
+    mo_timer_destroy(loose);
+
+    bool timer_ok = setup_ok && spaced(&strict_timer, STRICT, STRICT) &&
+                    spaced(&loose_timer, LOOSE - SLACK, LOOSE + SLACK);
+    int timer_shared = shared(&loose_timer, &strict_timer);
+
+    /* A woken task may record its wakeup a tick late */
+    bool sleep_ok = spaced(&strict_sleep, STRICT, STRICT + 1) &&
+                    spaced(&loose_sleep, LOOSE, LOOSE + SLACK + 1);
+    int sleep_shared = shared(&loose_sleep, &strict_sleep);
+
+    printf("\n=== TIMER SLACK RESULTS ===\n");
+    printf("Loose timer fired with the strict one %d/%d times\n",
+           timer_shared, EVENTS);
+    printf("Loose sleeper woke with the strict one %d/%d times\n",
+           sleep_shared, EVENTS);
+    printf("Timers within their windows: %s\n", timer_ok ? "PASS" : "FAIL");
+    printf("Timer expiries coalesced: %s\n", timer_shared ? "PASS" : "FAIL");
+    printf("Delays within their windows: %s\n", sleep_ok ? "PASS" : "FAIL");
+    printf("Delay wakeups coalesced: %s\n", sleep_shared ? "PASS" : "FAIL");
+    printf("Overall: %s\n",
+           (timer_ok && timer_shared && sleep_ok && sleep_shared) ? "PASS"
+                                                                  : "FAIL");
+
+    /* Shutdown QEMU cleanly via virt machine's test device */
+    *(volatile uint32_t *) 0x100000U = 0x5555U;
+
+    while (1)
+        mo_task_yield();
+}
+
+int32_t app_main(void)
+{
+    if (mo_task_spawn(strict_sleeper, 512) < 0 ||
+        mo_task_spawn(loose_sleeper, 512) < 0 ||
+        mo_task_spawn(tester, 1024) < 0) {
+        printf("FATAL: Failed to create tasks\n");
+        return false;
+    }
+
+    return true; /* Enable preemptive scheduling */
+}
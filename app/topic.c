@@ -0,0 +1,165 @@
+/* Test for the publish/subscribe topic bus
+ *
+ * A publisher sends numbered samples on one topic to two subscribers: a fast
+ * consumer with a deep queue that must see every sample in order, and a slow
+ * consumer with a shallow drop-oldest queue that must only ever see the most
+ * recent samples, with every other sample accounted for as dropped. A
+ * subscription on a second, quiet topic cannot be cancelled while a task is
+ * blocked receiving on it.
+ */
+
+#include <linmo.h>
+
+#include "private/error.h"
+
+#define SAMPLES 40
+#define SLOW_DEPTH 2
+
+static topic_t *topic, *quiet;
+static topic_sub_t *fast_sub, *slow_sub, *quiet_sub;
+
+static volatile int fast_seen, fast_errors;
+static volatile int slow_seen, slow_last = -1, slow_errors;
+static volatile bool publisher_done, quiet_received;
+
+static void consume(topic_buf_t *buf, int *value)
+{
+    memcpy(value, buf->data, sizeof(*value));
+    mo_topic_buf_release(buf);
+}
+
+void publisher(void)
+{
+    for (int i = 0; i < SAMPLES; i++) {
+        topic_buf_t *buf = mo_topic_buf_alloc(sizeof(int));
+        if (!buf)
+            break;
+        memcpy(buf->data, &i, sizeof(i));
+
+        /* Both subscribers take a reference; ours is consumed */
+        mo_topic_publish(topic, buf);
+
+        if (i % 8 == 7)
+            mo_task_yield();
+    }
+    publisher_done = true;
+
+    while (1)
+        mo_task_yield();
+}
+
+void fast_consumer(void)
+{
+    while (fast_seen < SAMPLES) {
+        int value;
+        consume(mo_topic_recv(fast_sub, 0), &value);
+        if (value != fast_seen)
+            fast_errors++;
+        fast_seen++;
+    }
+
+    while (1)
+        mo_task_yield();
+}
+
+void slow_consumer(void)
+{
+    while (1) {
+        topic_buf_t *buf = mo_topic_recv(slow_sub, 20);
+        if (!buf)
+            break; /* Publisher finished and the queue drained */
+
+        int value;
+        consume(buf, &value);
+        if (value <= slow_last)
+            slow_errors++;
+        slow_last = value;
+        slow_seen++;
+
+        for (int i = 0; i < 4; i++)
+            mo_task_yield();
+    }
+
+    while (1)
+        mo_task_yield();
+}
+
+/* Blocks on a topic nothing is published to until the monitor does */
+void quiet_consumer(void)
+{
+    topic_buf_t *buf = mo_topic_recv(quiet_sub, 0);
+    mo_topic_buf_release(buf);
+    quiet_received = buf != NULL;
+
+    while (1)
+        mo_task_yield();
+}
+
+/* Unsubscribing must wait until the blocked receiver is gone */
+static bool test_unsubscribe(void)
+{
+    bool ok = mo_topic_unsubscribe(quiet_sub) == ERR_TASK_BUSY;
+
+    topic_buf_t *buf = mo_topic_buf_alloc(1);
+    ok = ok && buf && mo_topic_publish(quiet, buf) == 1;
+    for (int i = 0; i < 100 && !quiet_received; i++)
+        mo_task_yield();
+
+    ok = ok && quiet_received && mo_topic_unsubscribe(quiet_sub) == ERR_OK;
+    return ok && mo_topic_destroy(quiet) == ERR_OK;
+}
+
+void monitor_task(void)
+{
+    for (int i = 0; i < 1000; i++) {
+        if (publisher_done && fast_seen == SAMPLES && slow_last == SAMPLES - 1)
+            break;
+        mo_task_yield();
+    }
+
+    bool fast_ok = fast_seen == SAMPLES && fast_errors == 0;
+    bool slow_ok = slow_last == SAMPLES - 1 && slow_errors == 0;
+    bool count_ok = slow_seen + (int) slow_sub->dropped == SAMPLES;
+    bool unsub_ok = test_unsubscribe();
+
+    printf("\n=== TOPIC RESULTS ===\n");
+    printf("Fast subscriber: %d/%d in order: %s\n", fast_seen, SAMPLES,
+           fast_ok ? "PASS" : "FAIL");
+    printf("Slow subscriber: %d seen, %u dropped: %s\n", slow_seen,
+           (unsigned) slow_sub->dropped, slow_ok ? "PASS" : "FAIL");
+    printf("Delivered + dropped: %s\n", count_ok ? "PASS" : "FAIL");
+    printf("Unsubscribe with a blocked receiver: %s\n",
+           unsub_ok ? "PASS" : "FAIL");
+    printf("Overall: %s\n",
+           (fast_ok && slow_ok && count_ok && unsub_ok) ? "PASS" : "FAIL");
+
+    /* Shutdown QEMU cleanly via virt machine's test device */
+    *(volatile uint32_t *) 0x100000U = 0x5555U;
+
+    while (1)
+        mo_task_yield();
+}
+
+int32_t app_main(void)
+{
+    topic = mo_topic_create();
+    fast_sub = mo_topic_subscribe(topic, SAMPLES, TOPIC_DROP_NEWEST);
+    slow_sub = mo_topic_subscribe(topic, SLOW_DEPTH, TOPIC_DROP_OLDEST);
+    quiet = mo_topic_create();
+    quiet_sub = mo_topic_subscribe(quiet, 1, TOPIC_DROP_NEWEST);
+    if (!topic || !fast_sub || !slow_sub || !quiet || !quiet_sub) {
+        printf("FATAL: Failed to create topic\n");
+        return false;
+    }
+
+    if (mo_task_spawn(publisher, 1024) < 0 ||
+        mo_task_spawn(fast_consumer, 1024) < 0 ||
+        mo_task_spawn(slow_consumer, 1024) < 0 ||
+        mo_task_spawn(quiet_consumer, 1024) < 0 ||
+        mo_task_spawn(monitor_task, 1024) < 0) {
+        printf("FATAL: Failed to create tasks\n");
+        return false;
+    }
+
+    return true; /* Enable preemptive scheduling */
+}
@@ -0,0 +1,168 @@
+/* Test for the virtio-blk driver
+ *
+ * Needs a disk of at least 64 KiB, whose contents it overwrites, e.g.
+ * 'truncate -s 1M disk.img && make vblk run DISK=disk.img'.
+ *
+ * A tester writes and reads back sectors, queues adjacent writes with
+ * completion callbacks for the driver to merge, checks that invalid requests
+ * are refused and goes through the block device adapter. A spinner of the
+ * same priority keeps the CPU busy throughout, so synchronous I/O is only
+ * fast if the completion interrupt switches straight to the waiting task.
+ */
+
+#include <linmo.h>
+#include <virtio.h>
+
+#include "spin.h"
+
+#define BASE 16    /* First sector used */
+#define SECTORS 8  /* Adjacent writes queued at once */
+#define ROUNDS 100 /* Synchronous reads timed */
+
+static uint8_t buf[SECTORS * VBLK_SECTOR_SIZE] __attribute__((aligned(4)));
+static uint8_t out[SECTORS * VBLK_SECTOR_SIZE] __attribute__((aligned(4)));
+static volatile uint32_t callbacks;
+
+static void fill(uint8_t *p, uint32_t sector, uint8_t tag)
+{
+    for (uint32_t i = 0; i < VBLK_SECTOR_SIZE; i++)
+        p[i] = (uint8_t) (sector * 13 + i) ^ tag;
+}
+
+static bool check(const uint8_t *p, uint32_t sector, uint8_t tag)
+{
+    for (uint32_t i = 0; i < VBLK_SECTOR_SIZE; i++) {
+        if (p[i] != (uint8_t) ((sector * 13 + i) ^ tag))
+            return false;
+    }
+    return true;
+}
+
+/* Runs in the completion interrupt */
+static void count_done(vblk_req_t *req)
+{
+    if (req->status == VBLK_OK)
+        callbacks++;
+}
+
+static bool test_sync(void)
+{
+    fill(buf, BASE, 0x5A);
+    bool ok = virtio_blk_rw(VBLK_WRITE, BASE, buf, 1) == VBLK_OK;
+    memset(out, 0, VBLK_SECTOR_SIZE);
+    ok = ok && virtio_blk_rw(VBLK_READ, BASE, out, 1) == VBLK_OK;
+    return ok && check(out, BASE, 0x5A) &&
+           virtio_blk_rw(VBLK_FLUSH, 0, NULL, 0) == VBLK_OK;
+}
+
+/* Adjacent writes queued together, read back as one request */
+static bool test_queued(void)
+{
+    vblk_req_t req[SECTORS];
+    bool ok = true;
+
+    callbacks = 0;
+    for (uint32_t i = 0; i < SECTORS; i++) {
+        fill(buf + i * VBLK_SECTOR_SIZE, BASE + i, 0xC3);
+        req[i] = (vblk_req_t){
+            .op = VBLK_WRITE,
+            .sector = BASE + i,
+            .count = 1,
+            .buf = buf + i * VBLK_SECTOR_SIZE,
+            .done = count_done,
+        };
+        ok = ok && virtio_blk_submit(&req[i]) == 0;
+    }
+    for (uint32_t i = 0; i < SECTORS; i++)
+        ok = virtio_blk_wait(&req[i]) == VBLK_OK && ok;
+    ok = ok && callbacks == SECTORS;
+
+    memset(out, 0, sizeof(out));
+    ok = ok && virtio_blk_rw(VBLK_READ, BASE, out, SECTORS) == VBLK_OK;
+    for (uint32_t i = 0; ok && i < SECTORS; i++)
+        ok = check(out + i * VBLK_SECTOR_SIZE, BASE + i, 0xC3);
+    return ok;
+}
+
+static bool test_invalid(void)
+{
+    uint32_t cap = virtio_blk_capacity();
+    vblk_req_t past = {.op = VBLK_READ, .sector = cap, .count = 1, .buf = out};
+    vblk_req_t tail = {
+        .op = VBLK_READ, .sector = cap - 1, .count = 2, .buf = out};
+    vblk_req_t empty = {.op = VBLK_READ, .sector = BASE, .buf = out};
+    vblk_req_t nobuf = {.op = VBLK_WRITE, .sector = BASE, .count = 1};
+
+    return virtio_blk_submit(&past) < 0 && virtio_blk_submit(&tail) < 0 &&
+           virtio_blk_submit(&empty) < 0 && virtio_blk_submit(&nobuf) < 0 &&
+           virtio_blk_submit(NULL) < 0;
+}
+
+/* Scattered blocks through the block device interface */
+static bool test_blkdev(void)
+{
+    blkdev_t *dev = hal_blk_device();
+    uint32_t blocks[3] = {BASE + 20, BASE + 2, BASE + 40};
+    void *bufs[3] = {buf, buf + BLK_SIZE, buf + 2 * BLK_SIZE};
+
+    if (!dev || dev->blocks != virtio_blk_capacity())
+        return false;
+    for (int i = 0; i < 3; i++)
+        fill(bufs[i], blocks[i], 0x3C);
+
+    bool ok = dev->write(dev, blocks, bufs, 3) == 0;
+    for (int i = 0; ok && i < 3; i++) {
+        ok = dev->read(dev, blocks[i], out) == 0 &&
+             check(out, blocks[i], 0x3C);
+    }
+    return ok && dev->sync(dev) == 0;
+}
+
+void tester(void)
+{
+    bool present = virtio_blk_init() == 0 &&
+                   virtio_blk_capacity() >= BASE + 64;
+
+    bool sync_ok = present && test_sync();
+    bool queued_ok = present && test_queued();
+    bool invalid_ok = present && test_invalid();
+    bool blkdev_ok = present && test_blkdev();
+
+    /* Each read would wait for the spinner's time slice to run out if
+     * completions only readied the waiter.
+     */
+    uint32_t start = mo_ticks();
+    bool reads_ok = present;
+    for (int i = 0; reads_ok && i < ROUNDS; i++)
+        reads_ok = virtio_blk_rw(VBLK_READ, BASE, out, 1) == VBLK_OK;
+    uint32_t elapsed = mo_ticks() - start;
+    bool wakeup_ok = reads_ok && elapsed < ROUNDS / 4 && spins;
+    bool all_ok = sync_ok && queued_ok && invalid_ok && blkdev_ok && wakeup_ok;
+
+    printf("\n=== VIRTIO-BLK RESULTS ===\n");
+    if (!present)
+        printf("No disk of at least %d sectors attached\n", BASE + 64);
+    printf("%d synchronous reads in %u ticks\n", ROUNDS, (unsigned) elapsed);
+    printf("Read back and flush: %s\n", sync_ok ? "PASS" : "FAIL");
+    printf("Queued writes and callbacks: %s\n", queued_ok ? "PASS" : "FAIL");
+    printf("Invalid requests refused: %s\n", invalid_ok ? "PASS" : "FAIL");
+    printf("Block device adapter: %s\n", blkdev_ok ? "PASS" : "FAIL");
+    printf("Prompt wakeup: %s\n", wakeup_ok ? "PASS" : "FAIL");
+    printf("Overall: %s\n", all_ok ? "PASS" : "FAIL");
+
+    /* Shutdown QEMU cleanly via virt machine's test device */
+    *(volatile uint32_t *) 0x100000U = 0x5555U;
+
+    while (1)
+        mo_task_yield();
+}
+
+int32_t app_main(void)
+{
+    if (mo_task_spawn(tester, 2048) < 0 || mo_task_spawn(spinner, 1024) < 0) {
+        printf("FATAL: Failed to create tasks\n");
+        return false;
+    }
+
+    return true; /* Enable preemptive scheduling */
+}
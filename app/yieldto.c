@@ -0,0 +1,91 @@
+/* Test for directed yields
+ *
+ * Three workers and a tester share the CPU cooperatively, each worker noting
+ * its turn in a trace. When the tester yields to the last worker, that
+ * worker must run first, and the two workers it jumped over must still get
+ * their turn before the tester runs again.
+ */
+
+#include <linmo.h>
+
+#include "private/error.h"
+
+#define WORKERS 3
+#define TRACE_LEN 16
+
+static int32_t worker_id[WORKERS];
+static volatile int32_t trace[TRACE_LEN];
+static volatile int trace_len;
+static volatile bool tracing;
+
+void worker(void)
+{
+    int32_t self = mo_task_id();
+
+    while (1) {
+        if (tracing && trace_len < TRACE_LEN)
+            trace[trace_len++] = self;
+        mo_task_yield();
+    }
+}
+
+/* Checks whether @id ran before the tester got the CPU back */
+static bool traced(int32_t id)
+{
+    for (int i = 0; i < trace_len; i++) {
+        if (trace[i] == id)
+            return true;
+    }
+    return false;
+}
+
+void tester(void)
+{
+    /* Let every worker run once, so that all of them are ready */
+    mo_task_yield();
+
+    trace_len = 0;
+    tracing = true;
+    int32_t rc = mo_task_yield_to(worker_id[WORKERS - 1]);
+    tracing = false;
+
+    bool direct_ok = rc == ERR_OK && trace_len > 0 &&
+                     trace[0] == worker_id[WORKERS - 1];
+    bool turns_ok = true;
+    for (int i = 0; i < WORKERS - 1; i++)
+        turns_ok = turns_ok && traced(worker_id[i]);
+    bool self_ok = mo_task_yield_to(mo_task_id()) == ERR_OK;
+    bool invalid_ok = mo_task_yield_to(0) == ERR_TASK_NOT_FOUND &&
+                      mo_task_yield_to(UINT16_MAX) == ERR_TASK_NOT_FOUND;
+
+    printf("\n=== YIELD TO RESULTS ===\n");
+    printf("Target runs next: %s\n", direct_ok ? "PASS" : "FAIL");
+    printf("Skipped tasks keep their turn: %s\n", turns_ok ? "PASS" : "FAIL");
+    printf("Yield to self: %s\n", self_ok ? "PASS" : "FAIL");
+    printf("Unknown target rejected: %s\n", invalid_ok ? "PASS" : "FAIL");
+    printf("Overall: %s\n",
+           (direct_ok && turns_ok && self_ok && invalid_ok) ? "PASS" : "FAIL");
+
+    /* Shutdown QEMU cleanly via virt machine's test device */
+    *(volatile uint32_t *) 0x100000U = 0x5555U;
+
+    while (1)
+        mo_task_yield();
+}
+
+int32_t app_main(void)
+{
+    for (int i = 0; i < WORKERS; i++) {
+        worker_id[i] = mo_task_spawn(worker, 512);
+        if (worker_id[i] < 0) {
+            printf("FATAL: Failed to create tasks\n");
+            return false;
+        }
+    }
+    if (mo_task_spawn(tester, 1024) < 0) {
+        printf("FATAL: Failed to create tasks\n");
+        return false;
+    }
+
+    return false; /* Cooperative: only yields switch tasks */
+}
@@ -1,9 +1,10 @@
 /* Start-up and Interrupt Entry Code for RV32I
  *
- * This file contains the machine-mode reset vector ('_entry') and the common
- * interrupt/exception entry point (_isr). It is placed in the .text.prologue
- * section by the linker script to ensure it is located at the very beginning
- * of the executable image, which is where the CPU begins execution on reset.
+ * This file contains the machine-mode reset vector ('_entry'), the vectored
+ * trap table and the per-cause interrupt/exception entry points. It is placed
+ * in the .text.prologue section by the linker script to ensure it is located
+ * at the very beginning of the executable image, which is where the CPU
+ * begins execution on reset.
  */
 
 #include <types.h>
@@ -17,6 +18,9 @@ extern uint32_t _sbss, _ebss;
 /* C entry points */
 void main(void);
 void do_trap(uint32_t cause, uint32_t epc);
+uint32_t do_timer_trap(uint32_t epc, uint32_t isr_sp);
+uint32_t do_soft_trap(uint32_t epc, uint32_t isr_sp);
+uint32_t do_ext_trap(uint32_t epc, uint32_t isr_sp);
 void hal_panic(void);
 
 /* Machine-mode entry point ('_entry'). This is the first code executed on
@@ -66,8 +70,11 @@ __attribute__((naked, section(".text.prologue"))) void _entry(void)
         "csrr   t0, mhartid\n"
         "bnez   t0, .Lpark_hart\n"
 
-        /* Set the machine trap vector (mtvec) to point to our ISR */
-        "la     t0, _isr\n"
+        /* Point the machine trap vector (mtvec) at the vector table, in
+         * vectored mode so each interrupt class enters its own stub.
+         */
+        "la     t0, _isr_vector\n"
+        "ori    t0, t0, %2\n"
         "csrw   mtvec, t0\n"
 
         /* Enable machine-level external interrupts (MIE.MEIE).
@@ -89,7 +96,7 @@ __attribute__((naked, section(".text.prologue"))) void _entry(void)
         "j      .Lpark_hart\n"
 
         : /* no outputs */
-        : "i"(MSTATUS_MPP_MACH), "i"(MIE_MEIE)
+        : "i"(MSTATUS_MPP_MACH), "i"(MIE_MEIE), "i"(MTVEC_MODE_VECTORED)
         : "memory");
 }
 
@@ -99,59 +106,104 @@ __attribute__((naked, section(".text.prologue"))) void _entry(void)
  */
 #define ISR_CONTEXT_SIZE 128
 
+/* Full context save into a frame allocated on the current stack. Operand %0
+ * must be ISR_CONTEXT_SIZE.
+ *
+ * Stack Frame Layout (offsets from sp in bytes):
+ *   0: ra,   4: gp,   8: tp,  12: t0,  16: t1,  20: t2
+ *  24: s0,  28: s1,  32: a0,  36: a1,  40: a2,  44: a3
+ *  48: a4,  52: a5,  56: a6,  60: a7,  64: s2,  68: s3
+ *  72: s4,  76: s5,  80: s6,  84: s7,  88: s8,  92: s9
+ *  96: s10, 100:s11, 104:t3, 108: t4, 112: t5, 116: t6
+ * 120: mcause, 124: mepc
+ */
+#define ISR_SAVE_FULL        \
+    "addi   sp, sp, -%0\n"   \
+    "sw  ra,   0*4(sp)\n"    \
+    "sw  gp,   1*4(sp)\n"    \
+    "sw  tp,   2*4(sp)\n"    \
+    "sw  t0,   3*4(sp)\n"    \
+    "sw  t1,   4*4(sp)\n"    \
+    "sw  t2,   5*4(sp)\n"    \
+    "sw  s0,   6*4(sp)\n"    \
+    "sw  s1,   7*4(sp)\n"    \
+    "sw  a0,   8*4(sp)\n"    \
+    "sw  a1,   9*4(sp)\n"    \
+    "sw  a2,  10*4(sp)\n"    \
+    "sw  a3,  11*4(sp)\n"    \
+    "sw  a4,  12*4(sp)\n"    \
+    "sw  a5,  13*4(sp)\n"    \
+    "sw  a6,  14*4(sp)\n"    \
+    "sw  a7,  15*4(sp)\n"    \
+    "sw  s2,  16*4(sp)\n"    \
+    "sw  s3,  17*4(sp)\n"    \
+    "sw  s4,  18*4(sp)\n"    \
+    "sw  s5,  19*4(sp)\n"    \
+    "sw  s6,  20*4(sp)\n"    \
+    "sw  s7,  21*4(sp)\n"    \
+    "sw  s8,  22*4(sp)\n"    \
+    "sw  s9,  23*4(sp)\n"    \
+    "sw  s10, 24*4(sp)\n"    \
+    "sw  s11, 25*4(sp)\n"    \
+    "sw  t3,  26*4(sp)\n"    \
+    "sw  t4,  27*4(sp)\n"    \
+    "sw  t5,  28*4(sp)\n"    \
+    "sw  t6,  29*4(sp)\n"
+
+/* Full context restore from the frame at sp, followed by 'mret'. mepc is
+ * reloaded from the frame, as the handler may have modified it or switched
+ * to another task's frame.
+ */
+#define ISR_RESTORE_FULL     \
+    "lw     a1,  31*4(sp)\n" \
+    "csrw   mepc, a1\n"      \
+    "lw  ra,   0*4(sp)\n"    \
+    "lw  gp,   1*4(sp)\n"    \
+    "lw  tp,   2*4(sp)\n"    \
+    "lw  t0,   3*4(sp)\n"    \
+    "lw  t1,   4*4(sp)\n"    \
+    "lw  t2,   5*4(sp)\n"    \
+    "lw  s0,   6*4(sp)\n"    \
+    "lw  s1,   7*4(sp)\n"    \
+    "lw  a0,   8*4(sp)\n"    \
+    "lw  a1,   9*4(sp)\n"    \
+    "lw  a2,  10*4(sp)\n"    \
+    "lw  a3,  11*4(sp)\n"    \
+    "lw  a4,  12*4(sp)\n"    \
+    "lw  a5,  13*4(sp)\n"    \
+    "lw  a6,  14*4(sp)\n"    \
+    "lw  a7,  15*4(sp)\n"    \
+    "lw  s2,  16*4(sp)\n"    \
+    "lw  s3,  17*4(sp)\n"    \
+    "lw  s4,  18*4(sp)\n"    \
+    "lw  s5,  19*4(sp)\n"    \
+    "lw  s6,  20*4(sp)\n"    \
+    "lw  s7,  21*4(sp)\n"    \
+    "lw  s8,  22*4(sp)\n"    \
+    "lw  s9,  23*4(sp)\n"    \
+    "lw  s10, 24*4(sp)\n"    \
+    "lw  s11, 25*4(sp)\n"    \
+    "lw  t3,  26*4(sp)\n"    \
+    "lw  t4,  27*4(sp)\n"    \
+    "lw  t5,  28*4(sp)\n"    \
+    "lw  t6,  29*4(sp)\n"    \
+    "addi   sp, sp, %0\n"    \
+    "mret\n"
+
 /* Low-level Interrupt Service Routine (ISR) trampoline.
  *
- * This is the common entry point for all traps. It performs a FULL context
- * save, creating a complete trap frame on the stack. This makes the C handler
- * robust, as it does not need to preserve any registers itself.
+ * This is the entry point for exceptions and for any interrupt without a
+ * dedicated stub. It performs a FULL context save, creating a complete trap
+ * frame on the stack. This makes the C handler robust, as it does not need
+ * to preserve any registers itself.
  */
 __attribute__((naked, aligned(4))) void _isr(void)
 {
     asm volatile(
-        /* Allocate stack frame for full context save */
-        "addi   sp, sp, -%0\n"
-
-        /* Save all general-purpose registers except x0 (zero) and x2 (sp).
-         * This includes caller-saved and callee-saved registers.
-         *
-         * Stack Frame Layout (offsets from sp in bytes):
-         *   0: ra,   4: gp,   8: tp,  12: t0,  16: t1,  20: t2
-         *  24: s0,  28: s1,  32: a0,  36: a1,  40: a2,  44: a3
-         *  48: a4,  52: a5,  56: a6,  60: a7,  64: s2,  68: s3
-         *  72: s4,  76: s5,  80: s6,  84: s7,  88: s8,  92: s9
-         *  96: s10, 100:s11, 104:t3, 108: t4, 112: t5, 116: t6
-         * 120: mcause, 124: mepc
+        /* Allocate stack frame and save all general-purpose registers except
+         * x0 (zero) and x2 (sp).
          */
-        "sw  ra,   0*4(sp)\n"
-        "sw  gp,   1*4(sp)\n"
-        "sw  tp,   2*4(sp)\n"
-        "sw  t0,   3*4(sp)\n"
-        "sw  t1,   4*4(sp)\n"
-        "sw  t2,   5*4(sp)\n"
-        "sw  s0,   6*4(sp)\n"
-        "sw  s1,   7*4(sp)\n"
-        "sw  a0,   8*4(sp)\n"
-        "sw  a1,   9*4(sp)\n"
-        "sw  a2,  10*4(sp)\n"
-        "sw  a3,  11*4(sp)\n"
-        "sw  a4,  12*4(sp)\n"
-        "sw  a5,  13*4(sp)\n"
-        "sw  a6,  14*4(sp)\n"
-        "sw  a7,  15*4(sp)\n"
-        "sw  s2,  16*4(sp)\n"
-        "sw  s3,  17*4(sp)\n"
-        "sw  s4,  18*4(sp)\n"
-        "sw  s5,  19*4(sp)\n"
-        "sw  s6,  20*4(sp)\n"
-        "sw  s7,  21*4(sp)\n"
-        "sw  s8,  22*4(sp)\n"
-        "sw  s9,  23*4(sp)\n"
-        "sw  s10, 24*4(sp)\n"
-        "sw  s11, 25*4(sp)\n"
-        "sw  t3,  26*4(sp)\n"
-        "sw  t4,  27*4(sp)\n"
-        "sw  t5,  28*4(sp)\n"
-        "sw  t6,  29*4(sp)\n"
+        ISR_SAVE_FULL
 
         /* Save trap-related CSRs and prepare arguments for do_trap */
         "csrr   a0, mcause\n" /* Arg 1: cause */
@@ -169,46 +221,122 @@ __attribute__((naked, aligned(4))) void _isr(void)
         /* Use returned SP for context restore (enables context switching) */
         "mv     sp, a0\n"
 
-        /* Restore context. mepc might have been modified by the handler */
-        "lw     a1,  31*4(sp)\n"
-        "csrw   mepc, a1\n"
-        "lw  ra,   0*4(sp)\n"
-        "lw  gp,   1*4(sp)\n"
-        "lw  tp,   2*4(sp)\n"
-        "lw  t0,   3*4(sp)\n"
-        "lw  t1,   4*4(sp)\n"
-        "lw  t2,   5*4(sp)\n"
-        "lw  s0,   6*4(sp)\n"
-        "lw  s1,   7*4(sp)\n"
-        "lw  a0,   8*4(sp)\n"
-        "lw  a1,   9*4(sp)\n"
-        "lw  a2,  10*4(sp)\n"
-        "lw  a3,  11*4(sp)\n"
-        "lw  a4,  12*4(sp)\n"
-        "lw  a5,  13*4(sp)\n"
-        "lw  a6,  14*4(sp)\n"
-        "lw  a7,  15*4(sp)\n"
-        "lw  s2,  16*4(sp)\n"
-        "lw  s3,  17*4(sp)\n"
-        "lw  s4,  18*4(sp)\n"
-        "lw  s5,  19*4(sp)\n"
-        "lw  s6,  20*4(sp)\n"
-        "lw  s7,  21*4(sp)\n"
-        "lw  s8,  22*4(sp)\n"
-        "lw  s9,  23*4(sp)\n"
-        "lw  s10, 24*4(sp)\n"
-        "lw  s11, 25*4(sp)\n"
-        "lw  t3,  26*4(sp)\n"
-        "lw  t4,  27*4(sp)\n"
-        "lw  t5,  28*4(sp)\n"
-        "lw  t6,  29*4(sp)\n"
-
-        /* Deallocate stack frame */
-        "addi   sp, sp, %0\n"
-
-        /* Return from trap */
-        "mret\n"
+        /* Restore context and return from trap */
+        ISR_RESTORE_FULL
+        : /* no outputs */
+        : "i"(ISR_CONTEXT_SIZE)
+        : "memory");
+}
+
+/* Machine timer interrupt entry.
+ *
+ * The tick may preempt the running task, so the full frame is saved exactly
+ * as in '_isr'; only the 'mcause' decode in 'do_trap()' is skipped.
+ */
+__attribute__((naked, aligned(4))) void _isr_timer(void)
+{
+    asm volatile(
+        ISR_SAVE_FULL
+
+        "csrr   a0, mepc\n" /* Arg 1: epc */
+        "mv     a1, sp\n"   /* Arg 2: isr_sp */
+        "csrr   t0, mcause\n"
+        "sw     t0,  30*4(sp)\n"
+        "sw     a0,  31*4(sp)\n"
+
+        /* Returns the SP to restore from, as 'do_trap()' does */
+        "call   do_timer_trap\n"
+        "mv     sp, a0\n"
+
+        ISR_RESTORE_FULL
         : /* no outputs */
         : "i"(ISR_CONTEXT_SIZE)
         : "memory");
 }
+
+/* Machine software and external interrupt entries.
+ *
+ * The handlers run driver code and completion callbacks, so these save the
+ * full frame and use the same return-SP convention as '_isr_timer': the C
+ * side may switch to a task the handlers woke. mepc is reloaded from the
+ * frame, and since an interrupt is only taken with 'mstatus.MIE' set, MPIE
+ * and MPP are put back to what the interrupted code had before 'mret'.
+ *
+ * Handlers must never yield or block. Every yield path issues an 'ecall',
+ * which from here would dispatch from inside this trap and clobber the mepc
+ * and mstatus it returns with.
+ */
+__attribute__((naked, aligned(4))) void _isr_soft(void)
+{
+    asm volatile(
+        ISR_SAVE_FULL
+
+        "csrr   a0, mepc\n" /* Arg 1: epc */
+        "mv     a1, sp\n"   /* Arg 2: isr_sp */
+        "csrr   t0, mcause\n"
+        "sw     t0,  30*4(sp)\n"
+        "sw     a0,  31*4(sp)\n"
+
+        "call   do_soft_trap\n"
+        "mv     sp, a0\n"
+
+        /* Interrupts were enabled in the interrupted code */
+        "li     t0, %1\n"
+        "csrs   mstatus, t0\n"
+
+        ISR_RESTORE_FULL
+        : /* no outputs */
+        : "i"(ISR_CONTEXT_SIZE), "i"(MSTATUS_MPIE | MSTATUS_MPP_MACH)
+        : "memory");
+}
+
+__attribute__((naked, aligned(4))) void _isr_ext(void)
+{
+    asm volatile(
+        ISR_SAVE_FULL
+
+        "csrr   a0, mepc\n" /* Arg 1: epc */
+        "mv     a1, sp\n"   /* Arg 2: isr_sp */
+        "csrr   t0, mcause\n"
+        "sw     t0,  30*4(sp)\n"
+        "sw     a0,  31*4(sp)\n"
+
+        "call   do_ext_trap\n"
+        "mv     sp, a0\n"
+
+        /* Interrupts were enabled in the interrupted code */
+        "li     t0, %1\n"
+        "csrs   mstatus, t0\n"
+
+        ISR_RESTORE_FULL
+        : /* no outputs */
+        : "i"(ISR_CONTEXT_SIZE), "i"(MSTATUS_MPIE | MSTATUS_MPP_MACH)
+        : "memory");
+}
+
+/* Vectored-mode trap table.
+ *
+ * With 'mtvec' in vectored mode, exceptions enter at the base and interrupt
+ * cause N at base + 4 * N. Every slot is a single uncompressed jump, so the
+ * slot spacing holds even when building with the C extension. Causes without
+ * a dedicated stub go through the generic '_isr'.
+ */
+__attribute__((naked, aligned(64))) void _isr_vector(void)
+{
+    asm volatile(
+        ".option push\n"
+        ".option norvc\n"
+        "j      _isr\n"       /* 0: exceptions */
+        "j      _isr\n"       /* 1: supervisor software */
+        "j      _isr\n"       /* 2: reserved */
+        "j      _isr_soft\n"  /* 3: machine software */
+        "j      _isr\n"       /* 4: reserved */
+        "j      _isr\n"       /* 5: supervisor timer */
+        "j      _isr\n"       /* 6: reserved */
+        "j      _isr_timer\n" /* 7: machine timer */
+        "j      _isr\n"       /* 8: reserved */
+        "j      _isr\n"       /* 9: supervisor external */
+        "j      _isr\n"       /* 10: reserved */
+        "j      _isr_ext\n"   /* 11: machine external */
+        ".option pop\n");
+}
@@ -16,6 +16,16 @@
 /* Previous Interrupt Enable bit: Value of MIE before entering trap. */
 #define MSTATUS_MPIE (1U << 7)
 
+/* Floating-point unit status (FS) bits: Off makes every FP instruction trap
+ * as illegal; any FP register write moves Initial or Clean to Dirty.
+ */
+#define MSTATUS_FS_SHIFT 13
+#define MSTATUS_FS (3U << MSTATUS_FS_SHIFT)
+#define MSTATUS_FS_OFF (0U << MSTATUS_FS_SHIFT)
+#define MSTATUS_FS_INITIAL (1U << MSTATUS_FS_SHIFT)
+#define MSTATUS_FS_CLEAN (2U << MSTATUS_FS_SHIFT)
+#define MSTATUS_FS_DIRTY (3U << MSTATUS_FS_SHIFT)
+
 /* Previous Privilege Mode bits: Indicates the privilege mode before a trap.
  * 3: Machine Mode, 2: Reserved, 1: Supervisor Mode, 0: User Mode.
  */
@@ -179,3 +189,15 @@
 
 /* Machine Scratch Register - For temporary storage during traps */
 #define CSR_MSCRATCH 0x340
+
+/* Hardware Performance Monitor CSRs
+ *
+ * Counter N (0 = cycle, 2 = instret, 3..31 = mhpmcounterN) is read through
+ * CSR_MCYCLE + N and its upper half through CSR_MCYCLEH + N on RV32. The event
+ * selector of counter N (3..31) is CSR_MHPMEVENT_BASE + N.
+ */
+#define CSR_MCYCLE 0xb00
+#define CSR_MINSTRET 0xb02
+#define CSR_MCYCLEH 0xb80
+#define CSR_MINSTRETH 0xb82
+#define CSR_MHPMEVENT_BASE 0x320
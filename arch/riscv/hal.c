@@ -5,6 +5,7 @@
 #include "csr.h"
 #include "private/stdio.h"
 #include "private/utils.h"
+#include "virtio.h"
 
 /* Context frame offsets for jmp_buf (as 32-bit word indices).
  *
@@ -67,6 +68,9 @@ static uint32_t current_isr_frame_sp = 0;
 #define NS16550A_RBR 0x00 /* Receive Buffer Register (read-only) */
 #define NS16550A_DLL 0x00 /* Divisor Latch LSB (when DLAB=1) */
 #define NS16550A_DLM 0x01 /* Divisor Latch MSB (when DLAB=1) */
+#define NS16550A_IER 0x01 /* Interrupt Enable Register (when DLAB=0) */
+#define NS16550A_IIR 0x02 /* Interrupt Identification Register (read-only) */
+#define NS16550A_FCR 0x02 /* FIFO Control Register (write-only) */
 #define NS16550A_LCR 0x03 /* Line Control Register */
 #define NS16550A_LSR 0x05 /* Line Status Register */
 
@@ -75,6 +79,16 @@ static uint32_t current_isr_frame_sp = 0;
 /* Transmit Holding Register Empty: ready to send */
 #define NS16550A_LSR_THRE 0x20
 
+/* Interrupt Enable Register bits */
+#define NS16550A_IER_ETBEI 0x02 /* Transmit Holding Register Empty interrupt */
+
+/* FIFO Control Register bits: enable and reset both FIFOs */
+#define NS16550A_FCR_INIT 0x07
+#define NS16550A_TX_FIFO 16 /* Bytes accepted each time THRE is set */
+
+/* PLIC source of UART0 on the 'virt' machine */
+#define NS16550A_UART0_IRQ 10
+
 /* Line Control Register bits */
 #define NS16550A_LCR_8BIT 0x03 /* 8-bit chars, no parity, 1 stop bit (8N1) */
 #define NS16550A_LCR_DLAB 0x80 /* Divisor Latch Access Bit */
@@ -92,11 +106,125 @@ static uint32_t current_isr_frame_sp = 0;
 #define MTIME_L (*(volatile uint32_t *) (CLINT_BASE + 0xBFF8u))
 #define MTIME_H (*(volatile uint32_t *) (CLINT_BASE + 0xBFFCu))
 
+/* Machine software interrupt pending bit for hart 0 */
+#define CLINT_MSIP (*(volatile uint32_t *) (CLINT_BASE + 0x0000u))
+
+/* PLIC (Platform-Level Interrupt Controller) - Routes device interrupts to
+ * the machine external interrupt of hart 0 (PLIC context 0).
+ */
+#define PLIC_BASE 0x0C000000U
+#define PLIC_PRIORITY(src) (*(volatile uint32_t *) (PLIC_BASE + 4u * (src)))
+#define PLIC_ENABLE(src) \
+    (*(volatile uint32_t *) (PLIC_BASE + 0x2000u + 4u * ((src) / 32)))
+#define PLIC_ENABLE_BIT(src) (1U << ((src) % 32))
+#define PLIC_THRESHOLD (*(volatile uint32_t *) (PLIC_BASE + 0x200000u))
+#define PLIC_CLAIM (*(volatile uint32_t *) (PLIC_BASE + 0x200004u))
+
 /* Low-Level I/O and Delay */
 
+/* Interrupt-driven transmit ring. Producers append at 'head' with interrupts
+ * disabled; the THRE interrupt moves bytes from 'tail' into the TX FIFO and
+ * masks itself once the ring is empty. Both indices run freely and are
+ * reduced modulo the (power of two) ring size on access.
+ */
+static struct {
+    uint8_t buf[HAL_UART_TX_RING];
+    volatile uint32_t head, tail;
+} uart_tx;
+
+/* Moves queued bytes into the TX FIFO while it has room. Must be called with
+ * interrupts disabled.
+ */
+static void uart_tx_pump(void)
+{
+    if (NS16550A_UART0_REG(NS16550A_LSR) & NS16550A_LSR_THRE) {
+        /* THRE with FIFOs enabled means the whole TX FIFO is empty */
+        for (int i = 0; i < NS16550A_TX_FIFO && uart_tx.tail != uart_tx.head;
+             i++) {
+            NS16550A_UART0_REG(NS16550A_THR) =
+                uart_tx.buf[uart_tx.tail++ & (HAL_UART_TX_RING - 1)];
+        }
+    }
+
+    if (uart_tx.tail == uart_tx.head)
+        NS16550A_UART0_REG(NS16550A_IER) &= ~NS16550A_IER_ETBEI;
+    else
+        NS16550A_UART0_REG(NS16550A_IER) |= NS16550A_IER_ETBEI;
+}
+
+static void uart_irq(void)
+{
+    (void) NS16550A_UART0_REG(NS16550A_IIR); /* Acknowledge THRE interrupt */
+    uart_tx_pump();
+    if (uart_tx.head - uart_tx.tail <= HAL_UART_TX_RING / 4)
+        hal_console_drained();
+}
+
+uint32_t hal_uart_tx_write(const void *buf, uint32_t len)
+{
+    const uint8_t *p = buf;
+
+    int32_t was_enabled = _di();
+    uint32_t space = HAL_UART_TX_RING - (uart_tx.head - uart_tx.tail);
+    if (len > space)
+        len = space;
+    for (uint32_t i = 0; i < len; i++)
+        uart_tx.buf[uart_tx.head++ & (HAL_UART_TX_RING - 1)] = p[i];
+    uart_tx_pump(); /* Start transmission; the interrupt continues it */
+    hal_interrupt_set(was_enabled);
+
+    return len;
+}
+
+/* Bulk console output: the UART TX ring, or virtio-console when enabled */
+static uint32_t (*console_write)(const void *buf,
+                                 uint32_t len) = hal_uart_tx_write;
+
+/* Drain notification, armed by a write that did not fit */
+static void (*console_drain_hook)(void);
+static bool console_full;
+
+uint32_t hal_console_write(const void *buf, uint32_t len)
+{
+    /* Arming with interrupts off keeps the drain from slipping in between */
+    int32_t was_enabled = _di();
+    uint32_t n = console_write(buf, len);
+    if (n < len)
+        console_full = true;
+    hal_interrupt_set(was_enabled);
+    return n;
+}
+
+void hal_console_on_drain(void (*fn)(void))
+{
+    console_drain_hook = fn;
+}
+
+void hal_console_drained(void)
+{
+    if (!console_full)
+        return;
+
+    console_full = false;
+    if (console_drain_hook)
+        console_drain_hook();
+}
+
 /* Backend for 'putchar', writes a single character to the UART. */
 static int __putchar(int value)
 {
+    /* Send bytes already queued in the transmit ring first so that direct
+     * output (panics, flushed logs) appears in order after them. Polled
+     * because this may run with interrupts disabled.
+     */
+    if (unlikely(uart_tx.tail != uart_tx.head)) {
+        int32_t was_enabled = _di();
+        volatile uint32_t drain = 0x100000; /* Same limit as below */
+        while (uart_tx.tail != uart_tx.head && --drain)
+            uart_tx_pump();
+        hal_interrupt_set(was_enabled);
+    }
+
     /* Spin (busy-wait) until the UART's transmit buffer is ready for a new
      * character.
      */
@@ -179,6 +307,127 @@ static inline void mtimecmp_w(uint64_t val)
     write_csr(mie, old_mie);
 }
 
+/* Performance Counters */
+
+/* Access a CSR by number, for counters selected at run time */
+#define csr_read_num(num)                                     \
+    ({                                                        \
+        uint32_t __tmp;                                       \
+        asm volatile("csrr %0, %1" : "=r"(__tmp) : "i"(num)); \
+        __tmp;                                                \
+    })
+#define csr_write_num(num, val) \
+    asm volatile("csrw %0, %1" ::"i"(num), "r"(val))
+
+/* Read a 64-bit counter on RV32: the high half is read before and after the
+ * low half, and the read retried if a carry propagated in between.
+ */
+#define csr_read64(lo_csr, hi_csr)              \
+    ({                                          \
+        uint32_t __hi, __lo;                    \
+        do {                                    \
+            __hi = csr_read_num(hi_csr);        \
+            __lo = csr_read_num(lo_csr);        \
+        } while (__hi != csr_read_num(hi_csr)); \
+        CT64(__hi, __lo);                       \
+    })
+
+/* Expands @X for every programmable counter index */
+#define HPM_COUNTERS(X)                                                    \
+    X(3) X(4) X(5) X(6) X(7) X(8) X(9) X(10) X(11) X(12) X(13) X(14) X(15) \
+    X(16) X(17) X(18) X(19) X(20) X(21) X(22) X(23) X(24) X(25) X(26)      \
+    X(27) X(28) X(29) X(30) X(31)
+
+uint64_t hal_perf_read(uint32_t counter)
+{
+    switch (counter) {
+#define HPM_READ(n) \
+    case n:         \
+        return csr_read64(CSR_MCYCLE + n, CSR_MCYCLEH + n);
+        HPM_READ(HAL_PERF_CYCLE)
+        HPM_READ(HAL_PERF_INSTRET)
+        HPM_COUNTERS(HPM_READ)
+#undef HPM_READ
+    default:
+        return 0;
+    }
+}
+
+int32_t hal_perf_event(uint32_t counter, uint32_t event)
+{
+    switch (counter) {
+#define HPM_EVENT(n)                                  \
+    case n:                                           \
+        csr_write_num(CSR_MHPMEVENT_BASE + n, event); \
+        return 0;
+        HPM_COUNTERS(HPM_EVENT)
+#undef HPM_EVENT
+    default:
+        return -1;
+    }
+}
+
+#if HAL_HAS_FP
+/* Floating-Point Context */
+
+#if __riscv_flen == 64
+#define FP_STORE "fsd"
+#define FP_LOAD "fld"
+#define FP_SIZE "8"
+#else
+#define FP_STORE "fsw"
+#define FP_LOAD "flw"
+#define FP_SIZE "4"
+#endif
+
+/* Expands @X for every FP register number */
+#define FP_REGS(X)                                                           \
+    X(0) X(1) X(2) X(3) X(4) X(5) X(6) X(7) X(8) X(9) X(10) X(11) X(12) X(13) \
+    X(14) X(15) X(16) X(17) X(18) X(19) X(20) X(21) X(22) X(23) X(24) X(25)  \
+    X(26) X(27) X(28) X(29) X(30) X(31)
+
+#define FP_SAVE_REG(n) FP_STORE " f" #n ", " #n "*" FP_SIZE "(%0)\n"
+#define FP_LOAD_REG(n) FP_LOAD " f" #n ", " #n "*" FP_SIZE "(%0)\n"
+
+/* Set 'mstatus.FS' atomically; the field is cleared then set */
+static inline void fp_status_set(uint32_t fs)
+{
+    asm volatile("csrc mstatus, %0" ::"r"(MSTATUS_FS));
+    if (fs)
+        asm volatile("csrs mstatus, %0" ::"r"(fs));
+}
+
+int32_t hal_fp_dirty(void)
+{
+    return (read_csr(mstatus) & MSTATUS_FS) == MSTATUS_FS_DIRTY;
+}
+
+void hal_fp_save(hal_fp_context_t *ctx)
+{
+    asm volatile(FP_REGS(FP_SAVE_REG) : : "r"(ctx->f) : "memory");
+    ctx->fcsr = read_csr(fcsr);
+    fp_status_set(MSTATUS_FS_CLEAN);
+}
+
+void hal_fp_restore(const hal_fp_context_t *ctx)
+{
+    fp_status_set(MSTATUS_FS_CLEAN); /* FP loads trap while the FPU is off */
+    asm volatile(FP_REGS(FP_LOAD_REG) : : "r"(ctx->f) : "memory");
+    write_csr(fcsr, ctx->fcsr);
+    fp_status_set(MSTATUS_FS_CLEAN); /* The loads above marked it dirty */
+}
+
+void hal_fp_enable(void)
+{
+    fp_status_set(MSTATUS_FS_CLEAN);
+}
+
+void hal_fp_disable(void)
+{
+    fp_status_set(MSTATUS_FS_OFF);
+}
+#endif /* HAL_HAS_FP */
+
 /* Returns number of microseconds since boot by reading the 'mtime' counter */
 uint64_t _read_us(void)
 {
@@ -226,16 +475,29 @@ static void uart_init(uint32_t baud)
     NS16550A_UART0_REG(NS16550A_DLL) = divisor & 0xff;
     /* Clear DLAB and set line control to 8N1 mode */
     NS16550A_UART0_REG(NS16550A_LCR) = NS16550A_LCR_8BIT;
+    /* FIFOs let each THRE interrupt send a burst instead of a single byte */
+    NS16550A_UART0_REG(NS16550A_FCR) = NS16550A_FCR_INIT;
+    NS16550A_UART0_REG(NS16550A_IER) = 0;
 }
 
 /* Performs all essential hardware initialization at boot */
 void hal_hardware_init(void)
 {
     uart_init(USART_BAUD);
+    /* Let every enabled PLIC source with a non-zero priority through */
+    PLIC_THRESHOLD = 0;
+    hal_irq_attach(NS16550A_UART0_IRQ, uart_irq);
     /* Set the first timer interrupt. Subsequent interrupts are set in ISR */
     mtimecmp_w(mtime_r() + (F_CPU / F_TIMER));
     /* Install low-level I/O handlers for the C standard library */
     _stdout_install(__putchar);
+#if CONFIG_VIRTIO_CONSOLE
+    /* Input stays on the UART; virtio-console only carries output */
+    if (virtio_console_init() == 0) {
+        console_write = virtio_console_write;
+        _stdout_install(virtio_console_putchar);
+    }
+#endif
     _stdin_install(__getchar);
     _stdpoll_install(__kbhit);
 }
@@ -289,6 +551,217 @@ static const char *exc_msg[] = {
     [15] = "Store/AMO page fault",
 };
 
+/* Profiler sampling timer
+ *
+ * The CLINT provides a single 'mtimecmp' per hart, so a sampling rate
+ * independent of the scheduler tick is obtained by multiplexing: while
+ * sampling is active, both deadlines are tracked here and 'mtimecmp' is
+ * always programmed with the earlier one. Each deadline advances relative to
+ * its own previous target, so neither the tick period nor the sampling
+ * period drifts.
+ */
+static uint32_t prof_interval = 0; /* Cycles between samples, 0 = disabled */
+static uint64_t prof_next;         /* 'mtime' target of the next sample */
+static uint64_t tick_next;         /* 'mtime' target of the next tick */
+static void (*prof_hook)(uint32_t epc);
+
+static inline void prof_timer_arm(void)
+{
+    mtimecmp_w(prof_next < tick_next ? prof_next : tick_next);
+}
+
+/* Handles a timer interrupt while sampling is active. Returns true if the
+ * scheduler tick is also due.
+ */
+static bool prof_timer_expire(uint32_t epc)
+{
+    uint64_t now = mtime_r();
+    bool tick = now >= tick_next;
+
+    if (now >= prof_next) {
+        prof_hook(epc);
+        prof_next += prof_interval;
+        /* Skip samples missed while interrupts were masked rather than
+         * taking them back to back at the same PC.
+         */
+        if (unlikely(prof_next <= now))
+            prof_next = now + prof_interval;
+    }
+    if (tick)
+        tick_next += F_CPU / F_TIMER;
+
+    prof_timer_arm();
+    return tick;
+}
+
+void hal_prof_timer_start(uint32_t interval, void (*hook)(uint32_t epc))
+{
+    uint32_t old_mie = read_csr(mie);
+    write_csr(mie, old_mie & ~MIE_MTIE);
+
+    /* The pending 'mtimecmp' value is the next scheduler tick */
+    if (!prof_interval)
+        tick_next = mtimecmp_r();
+    prof_hook = hook;
+    prof_interval = interval;
+    prof_next = mtime_r() + interval;
+    prof_timer_arm();
+
+    write_csr(mie, old_mie);
+}
+
+void hal_prof_timer_stop(void)
+{
+    uint32_t old_mie = read_csr(mie);
+    write_csr(mie, old_mie & ~MIE_MTIE);
+
+    if (prof_interval) {
+        prof_interval = 0;
+        mtimecmp_w(tick_next);
+    }
+
+    write_csr(mie, old_mie);
+}
+
+/* Returns the length in bytes of the instruction at @pc. With the C
+ * extension, instructions are only 2-byte aligned and 16-bit encodings are
+ * those whose two lowest bits are not 0b11. 'ecall' has no compressed form,
+ * but decoding the length keeps the resume address right for any trapping
+ * instruction without relying on that.
+ */
+static inline uint32_t insn_len(uint32_t pc)
+{
+    return (*(const volatile uint16_t *) pc & 0x3) == 0x3 ? 4 : 2;
+}
+
+/* Machine timer interrupt: advance the tick and run the scheduler */
+static inline void timer_interrupt(uint32_t epc)
+{
+    /* To avoid timer drift, schedule the next interrupt relative to the
+     * previous target time, not the current time. This ensures a consistent
+     * tick frequency even with interrupt latency.
+     */
+    if (likely(!prof_interval)) {
+        mtimecmp_w(mtimecmp_r() + (F_CPU / F_TIMER));
+        /* Invoke scheduler - parameter 1 = from timer, increment ticks */
+        dispatcher(1);
+    } else if (prof_timer_expire(epc)) {
+        dispatcher(1);
+    }
+}
+
+/* Interrupt handlers attached with 'hal_irq_attach()'; slot 0 is the software
+ * interrupt, the others are PLIC sources.
+ */
+static hal_irq_handler_t irq_handlers[PLIC_SOURCES];
+
+int32_t hal_irq_attach(uint32_t source, hal_irq_handler_t handler)
+{
+    if (source >= PLIC_SOURCES)
+        return -1;
+
+    int32_t was_enabled = _di();
+    irq_handlers[source] = handler;
+    if (source == HAL_IRQ_SOFT) {
+        if (handler)
+            write_csr(mie, read_csr(mie) | MIE_MSIE);
+        else
+            write_csr(mie, read_csr(mie) & ~MIE_MSIE);
+    } else {
+        /* Priority 1 is the lowest that can pass the zero threshold */
+        PLIC_PRIORITY(source) = handler ? 1 : 0;
+        if (handler)
+            PLIC_ENABLE(source) |= PLIC_ENABLE_BIT(source);
+        else
+            PLIC_ENABLE(source) &= ~PLIC_ENABLE_BIT(source);
+    }
+    hal_interrupt_set(was_enabled);
+    return 0;
+}
+
+void hal_soft_irq_raise(void)
+{
+    CLINT_MSIP = 1;
+}
+
+/* Runs the software interrupt handler */
+static void do_soft_irq(void)
+{
+    CLINT_MSIP = 0; /* Acknowledge before running the handler */
+    if (irq_handlers[HAL_IRQ_SOFT])
+        irq_handlers[HAL_IRQ_SOFT]();
+}
+
+/* Runs the handlers of every pending PLIC source before returning, so
+ * back-to-back device interrupts are handled without another trap.
+ */
+static void do_ext_irq(void)
+{
+    uint32_t source;
+    while ((source = PLIC_CLAIM) != 0) {
+        if (likely(source < PLIC_SOURCES && irq_handlers[source]))
+            irq_handlers[source]();
+        PLIC_CLAIM = source; /* Complete */
+    }
+}
+
+/* Lets the kernel switch to a task an interrupt handler woke. A masked timer
+ * interrupt means preemption is off (scheduler not started, or a NOSCHED
+ * section), and the woken task then waits for its turn like any other.
+ */
+static inline void irq_exit(void)
+{
+    if (read_csr(mie) & MIE_MTIE)
+        _sched_irq_exit();
+}
+
+/* Machine software interrupt, entered from '_isr_soft' in vectored mode.
+ * @epc    : The interrupted PC
+ * @isr_sp : The stack pointer pointing to the full ISR frame
+ *
+ * Returns the SP to use for restoring context, as 'do_trap()' does.
+ */
+uint32_t do_soft_trap(uint32_t epc, uint32_t isr_sp)
+{
+    pending_switch_sp = NULL;
+    current_isr_frame_sp = isr_sp;
+
+    do_soft_irq();
+    irq_exit();
+
+    return pending_switch_sp ? (uint32_t) pending_switch_sp : isr_sp;
+}
+
+/* Machine external interrupt, entered from '_isr_ext' in vectored mode.
+ * Arguments and return value as for 'do_soft_trap()'.
+ */
+uint32_t do_ext_trap(uint32_t epc, uint32_t isr_sp)
+{
+    pending_switch_sp = NULL;
+    current_isr_frame_sp = isr_sp;
+
+    do_ext_irq();
+    irq_exit();
+
+    return pending_switch_sp ? (uint32_t) pending_switch_sp : isr_sp;
+}
+
+/* Machine timer interrupt, entered from '_isr_timer' in vectored mode.
+ * @epc    : The interrupted PC
+ * @isr_sp : The stack pointer pointing to the full ISR frame
+ *
+ * Returns the SP to use for restoring context, as 'do_trap()' does.
+ */
+uint32_t do_timer_trap(uint32_t epc, uint32_t isr_sp)
+{
+    pending_switch_sp = NULL;
+    current_isr_frame_sp = isr_sp;
+
+    timer_interrupt(epc);
+
+    return pending_switch_sp ? (uint32_t) pending_switch_sp : isr_sp;
+}
+
 /* C-level trap handler, called by the '_isr' assembly routine.
  * @cause : The value of the 'mcause' CSR, indicating the reason for the trap.
  * @epc   : The value of the 'mepc' CSR, the PC at the time of the trap.
@@ -307,13 +780,11 @@ uint32_t do_trap(uint32_t cause, uint32_t epc, uint32_t isr_sp)
     if (MCAUSE_IS_INTERRUPT(cause)) { /* Asynchronous Interrupt */
         uint32_t int_code = MCAUSE_GET_CODE(cause);
         if (int_code == MCAUSE_MTI) { /* Machine Timer Interrupt */
-            /* To avoid timer drift, schedule the next interrupt relative to the
-             * previous target time, not the current time. This ensures a
-             * consistent tick frequency even with interrupt latency.
-             */
-            mtimecmp_w(mtimecmp_r() + (F_CPU / F_TIMER));
-            /* Invoke scheduler - parameter 1 = from timer, increment ticks */
-            dispatcher(1);
+            timer_interrupt(epc);
+        } else if (int_code == MCAUSE_MSI) {
+            do_soft_irq();
+        } else if (int_code == MCAUSE_MEI) {
+            do_ext_irq();
         } else {
             /* All other interrupt sources are unexpected and fatal */
             hal_panic();
@@ -323,8 +794,8 @@ uint32_t do_trap(uint32_t cause, uint32_t epc, uint32_t isr_sp)
 
         /* Handle ecall from M-mode - used for yielding in preemptive mode */
         if (code == MCAUSE_ECALL_MMODE) {
-            /* Advance mepc past the ecall instruction (4 bytes) */
-            uint32_t new_epc = epc + 4;
+            /* Advance mepc past the ecall instruction */
+            uint32_t new_epc = epc + insn_len(epc);
             write_csr(mepc, new_epc);
 
             /* Also update mepc in the ISR frame on the stack!
@@ -344,6 +815,14 @@ uint32_t do_trap(uint32_t cause, uint32_t epc, uint32_t isr_sp)
             return pending_switch_sp ? (uint32_t) pending_switch_sp : isr_sp;
         }
 
+#if HAL_HAS_FP
+        /* First FP instruction of a task that has not used the FPU yet */
+        if (code == MCAUSE_ILLEGAL_INST &&
+            (read_csr(mstatus) & MSTATUS_FS) == MSTATUS_FS_OFF &&
+            _task_fp_trap())
+            return isr_sp; /* Retry the instruction with the FPU on */
+#endif
+
         /* Print exception info via direct UART (safe in trap context) */
         trap_puts("[EXCEPTION] ");
         if (code < ARRAY_SIZE(exc_msg) && exc_msg[code])
@@ -369,7 +848,12 @@ void hal_timer_enable(void)
 {
     uint64_t now = mtime_r();
     uint64_t target = now + (F_CPU / F_TIMER);
-    mtimecmp_w(target);
+    if (prof_interval) {
+        tick_next = target;
+        prof_timer_arm();
+    } else {
+        mtimecmp_w(target);
+    }
     write_csr(mie, read_csr(mie) | MIE_MTIE);
 }
 
@@ -598,6 +1082,15 @@ __attribute__((noreturn)) void hal_context_restore(jmp_buf env, int32_t val)
     asm volatile(
         /* Restore mstatus FIRST to ensure correct processor state */
         "lw  t0, 16*4(%0)\n"
+#if HAL_HAS_FP
+        /* Keep the live FPU state; it is managed by the lazy FP switch */
+        "li   t1, %2\n"
+        "csrr t2, mstatus\n"
+        "and  t2, t2, t1\n"
+        "not  t1, t1\n"
+        "and  t0, t0, t1\n"
+        "or   t0, t0, t2\n"
+#endif
         "csrw mstatus, t0\n"
         /* Restore all registers from the provided 'jmp_buf' */
         "lw  s0,   0*4(%0)\n"
@@ -621,7 +1114,7 @@ __attribute__((noreturn)) void hal_context_restore(jmp_buf env, int32_t val)
         /* "Return" to the restored 'ra', effectively jumping to new context */
         "ret\n"
         :
-        : "r"(env), "r"(val)
+        : "r"(env), "r"(val), "i"(MSTATUS_FS)
         : "memory");
 
     __builtin_unreachable(); /* Tell compiler this point is never reached */
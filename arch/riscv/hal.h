@@ -103,10 +103,157 @@ void hal_timer_irq_enable(
 void hal_timer_irq_disable(
     void); /* Disable timer interrupt bit only (for NOSCHED) */
 void hal_interrupt_tick(void); /* Enable interrupts on first task run */
+
+/* Starts the profiler sampling timer, multiplexed with the scheduler tick.
+ * @interval : Sampling period in 'mtime' cycles (must be non-zero)
+ * @hook     : Called from the timer trap with the interrupted PC
+ */
+void hal_prof_timer_start(uint32_t interval, void (*hook)(uint32_t epc));
+
+/* Stops the profiler sampling timer; the scheduler tick is unaffected */
+void hal_prof_timer_stop(void);
 void *hal_build_initial_frame(
     void *stack_top,
     void (*task_entry)(void)); /* Build ISR frame for preemptive mode */
 
+/* Interrupt Handlers
+ *
+ * Software and device interrupts are dispatched to handlers attached here.
+ * Handlers run in interrupt context with interrupts disabled, on the stack of
+ * the interrupted task. They must never block or yield, not even through an
+ * API such as 'mo_sem_signal()' that may yield: the 'ecall' behind every
+ * yield would nest a trap and dispatch from inside this one.
+ */
+typedef void (*hal_irq_handler_t)(void);
+
+/* Number of interrupt sources: 0 is the machine software interrupt, 1 and
+ * above are PLIC device sources (e.g., 10 is UART0 on QEMU 'virt').
+ */
+#define HAL_IRQ_SOFT 0
+#define PLIC_SOURCES 64
+
+/* Attaches a handler to an interrupt source and enables it, or detaches and
+ * disables it when @handler is NULL.
+ * @source  : HAL_IRQ_SOFT or a PLIC source number (< PLIC_SOURCES)
+ * @handler : Function called for each interrupt, or NULL
+ *
+ * Returns 0 on success, or -1 for an invalid source
+ */
+int32_t hal_irq_attach(uint32_t source, hal_irq_handler_t handler);
+
+/* Raises the machine software interrupt of the current hart */
+void hal_soft_irq_raise(void);
+
+/* Interrupt-Driven UART Transmit
+ *
+ * Queues up to @len bytes from @buf for transmission on the console UART and
+ * returns immediately; the transmitter-empty interrupt sends them in FIFO
+ * sized bursts. Returns the number of bytes queued, which is less than @len
+ * when the ring is full. Safe to call from tasks and interrupt handlers.
+ * Direct console output through '_putchar()' first drains the ring.
+ */
+#ifndef HAL_UART_TX_RING
+#define HAL_UART_TX_RING 1024 /* Transmit ring size in bytes, power of two */
+#endif
+
+uint32_t hal_uart_tx_write(const void *buf, uint32_t len);
+
+/* Queues console output without waiting for the device, with the same
+ * semantics as 'hal_uart_tx_write()'. Goes to the virtio console when
+ * CONFIG_VIRTIO_CONSOLE is set and one is present, to the UART otherwise.
+ */
+uint32_t hal_console_write(const void *buf, uint32_t len);
+
+/* Registers @fn to be called once the console has room again after a
+ * 'hal_console_write()' that did not fit: when the UART ring has drained
+ * to a quarter of its size, or a virtio-console buffer has completed. @fn
+ * runs in the device's interrupt handler, under its rules (see
+ * 'hal_irq_attach()'), and is called once per short write episode.
+ */
+void hal_console_on_drain(void (*fn)(void));
+
+/* Called by the console backends from their interrupt handlers once they
+ * can take more output; runs the hook if a short write armed it.
+ */
+void hal_console_drained(void);
+
+/* Returns the virtio block device as a 'blkdev_t' (see <sys/blkdev.h>),
+ * probing it on first use, or NULL if there is none.
+ */
+struct blkdev;
+struct blkdev *hal_blk_device(void);
+
+/* Floating-Point Context
+ *
+ * Available when building for an ISA with the F (and optionally D) extension.
+ * The FP registers are switched lazily by the scheduler using 'mstatus.FS';
+ * with the ilp32 ABI all FP registers are caller-saved, so only asynchronous
+ * (preemptive) switches need to preserve them.
+ */
+#if defined(__riscv_flen)
+#define HAL_HAS_FP 1
+
+typedef struct {
+#if __riscv_flen == 64
+    uint64_t f[32]; /* f0-f31 */
+#else
+    uint32_t f[32]; /* f0-f31 */
+#endif
+    uint32_t fcsr; /* Rounding mode and accrued exception flags */
+} hal_fp_context_t;
+
+/* Returns non-zero if the FP registers were written since the last save or
+ * restore ('mstatus.FS' is Dirty).
+ */
+int32_t hal_fp_dirty(void);
+
+/* Saves the FP registers to @ctx and marks them clean */
+void hal_fp_save(hal_fp_context_t *ctx);
+
+/* Enables the FPU, loads the FP registers from @ctx and marks them clean */
+void hal_fp_restore(const hal_fp_context_t *ctx);
+
+/* Turns the FPU on without touching the registers and marks them clean */
+void hal_fp_enable(void);
+
+/* Turns the FPU off, so that the next FP instruction traps */
+void hal_fp_disable(void);
+
+/* Kernel hook called by the trap handler when an instruction traps with the
+ * FPU off. Returns non-zero if the FPU was enabled for the current task and
+ * the instruction should be retried.
+ */
+int32_t _task_fp_trap(void);
+#else
+#define HAL_HAS_FP 0
+#endif
+
+/* Hardware Performance Counters
+ *
+ * Counters are identified by their index in the RISC-V counter space. Which
+ * programmable counters exist and which events they support is
+ * implementation-defined; accessing a counter the core lacks traps.
+ */
+#define HAL_PERF_CYCLE 0     /* mcycle: clock cycles */
+#define HAL_PERF_INSTRET 2   /* minstret: retired instructions */
+#define HAL_PERF_HPM_FIRST 3 /* First programmable mhpmcounter */
+#define HAL_PERF_HPM_LAST 31 /* Last programmable mhpmcounter */
+
+/* Reads a 64-bit performance counter.
+ * @counter : Counter index (HAL_PERF_CYCLE, HAL_PERF_INSTRET or an HPM index)
+ *
+ * Returns the counter value, or 0 for an invalid index
+ */
+uint64_t hal_perf_read(uint32_t counter);
+
+/* Selects the event counted by a programmable counter.
+ * @counter : HPM counter index (HAL_PERF_HPM_FIRST to HAL_PERF_HPM_LAST)
+ * @event   : Implementation-defined event selector, 0 = none
+ *
+ * Returns 0 on success, or -1 for an invalid index
+ */
+int32_t hal_perf_event(uint32_t counter, uint32_t event);
+
 /* Initializes the context structure for a new task.
  * @ctx : Pointer to jmp_buf to initialize (must be non-NULL).
  * @sp  : Base address of the task's stack (must be valid).
@@ -0,0 +1,213 @@
+/* virtio-mmio Transport and Split Virtqueues
+ *
+ * Implements the driver side of the virtio 1.x MMIO register interface:
+ * device discovery, the status handshake, feature negotiation and queue
+ * setup, plus the descriptor/available/used ring handling shared by the
+ * virtio device drivers.
+ */
+
+#include <hal.h>
+#include <lib/libc.h>
+
+#include "private/utils.h"
+#include "virtio.h"
+
+/* MMIO register offsets (virtio 1.x, section 4.2.2) */
+#define VIRTIO_MMIO_MAGIC 0x000
+#define VIRTIO_MMIO_VERSION 0x004
+#define VIRTIO_MMIO_DEVICE_ID 0x008
+#define VIRTIO_MMIO_DEVICE_FEATURES 0x010
+#define VIRTIO_MMIO_DEVICE_FEATURES_SEL 0x014
+#define VIRTIO_MMIO_DRIVER_FEATURES 0x020
+#define VIRTIO_MMIO_DRIVER_FEATURES_SEL 0x024
+#define VIRTIO_MMIO_QUEUE_SEL 0x030
+#define VIRTIO_MMIO_QUEUE_NUM_MAX 0x034
+#define VIRTIO_MMIO_QUEUE_NUM 0x038
+#define VIRTIO_MMIO_QUEUE_READY 0x044
+#define VIRTIO_MMIO_QUEUE_NOTIFY 0x050
+#define VIRTIO_MMIO_INTERRUPT_STATUS 0x060
+#define VIRTIO_MMIO_INTERRUPT_ACK 0x064
+#define VIRTIO_MMIO_STATUS 0x070
+#define VIRTIO_MMIO_QUEUE_DESC_LOW 0x080
+#define VIRTIO_MMIO_QUEUE_DESC_HIGH 0x084
+#define VIRTIO_MMIO_QUEUE_DRIVER_LOW 0x090
+#define VIRTIO_MMIO_QUEUE_DRIVER_HIGH 0x094
+#define VIRTIO_MMIO_QUEUE_DEVICE_LOW 0x0a0
+#define VIRTIO_MMIO_QUEUE_DEVICE_HIGH 0x0a4
+#define VIRTIO_MMIO_CONFIG 0x100
+
+#define VIRTIO_MMIO_MAGIC_VALUE 0x74726976U /* "virt" */
+#define VIRTIO_MMIO_VERSION_1X 2
+
+/* Device status bits */
+#define VIRTIO_STATUS_ACKNOWLEDGE 1
+#define VIRTIO_STATUS_DRIVER 2
+#define VIRTIO_STATUS_DRIVER_OK 4
+#define VIRTIO_STATUS_FEATURES_OK 8
+#define VIRTIO_STATUS_FAILED 128
+
+/* Feature bit 32: the device conforms to virtio 1.x */
+#define VIRTIO_F_VERSION_1_HI (1U << 0)
+
+#define VIRTIO_REG(dev, off) (*(volatile uint32_t *) ((dev)->base + (off)))
+
+/* Orders ring updates against the device's view of memory */
+#define virtio_mb() asm volatile("fence rw, rw" ::: "memory")
+
+int32_t virtio_probe(uint32_t device_id, virtio_dev_t *dev)
+{
+    for (uint32_t slot = 0; slot < VIRTIO_MMIO_SLOTS; slot++) {
+        virtio_dev_t d = {
+            .base = VIRTIO_MMIO_BASE + slot * VIRTIO_MMIO_STRIDE,
+            .irq = VIRTIO_MMIO_IRQ(slot),
+        };
+
+        if (VIRTIO_REG(&d, VIRTIO_MMIO_MAGIC) != VIRTIO_MMIO_MAGIC_VALUE ||
+            VIRTIO_REG(&d, VIRTIO_MMIO_VERSION) != VIRTIO_MMIO_VERSION_1X)
+            continue; /* Not virtio, or a legacy-only transport */
+
+        if (VIRTIO_REG(&d, VIRTIO_MMIO_DEVICE_ID) == device_id) {
+            *dev = d;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int32_t virtio_setup(virtio_dev_t *dev, uint32_t features)
+{
+    /* Reset, then announce ourselves */
+    VIRTIO_REG(dev, VIRTIO_MMIO_STATUS) = 0;
+    while (VIRTIO_REG(dev, VIRTIO_MMIO_STATUS) != 0)
+        ;
+    VIRTIO_REG(dev, VIRTIO_MMIO_STATUS) = VIRTIO_STATUS_ACKNOWLEDGE;
+    VIRTIO_REG(dev, VIRTIO_MMIO_STATUS) |= VIRTIO_STATUS_DRIVER;
+
+    VIRTIO_REG(dev, VIRTIO_MMIO_DEVICE_FEATURES_SEL) = 1;
+    if (!(VIRTIO_REG(dev, VIRTIO_MMIO_DEVICE_FEATURES) &
+          VIRTIO_F_VERSION_1_HI))
+        goto fail;
+
+    VIRTIO_REG(dev, VIRTIO_MMIO_DEVICE_FEATURES_SEL) = 0;
+    features &= VIRTIO_REG(dev, VIRTIO_MMIO_DEVICE_FEATURES);
+
+    VIRTIO_REG(dev, VIRTIO_MMIO_DRIVER_FEATURES_SEL) = 0;
+    VIRTIO_REG(dev, VIRTIO_MMIO_DRIVER_FEATURES) = features;
+    VIRTIO_REG(dev, VIRTIO_MMIO_DRIVER_FEATURES_SEL) = 1;
+    VIRTIO_REG(dev, VIRTIO_MMIO_DRIVER_FEATURES) = VIRTIO_F_VERSION_1_HI;
+
+    VIRTIO_REG(dev, VIRTIO_MMIO_STATUS) |= VIRTIO_STATUS_FEATURES_OK;
+    if (!(VIRTIO_REG(dev, VIRTIO_MMIO_STATUS) & VIRTIO_STATUS_FEATURES_OK))
+        goto fail; /* Device rejected the feature subset */
+
+    return (int32_t) features;
+
+fail:
+    VIRTIO_REG(dev, VIRTIO_MMIO_STATUS) |= VIRTIO_STATUS_FAILED;
+    return -1;
+}
+
+int32_t virtio_queue_setup(virtio_dev_t *dev, virtq_t *vq, uint16_t index)
+{
+    VIRTIO_REG(dev, VIRTIO_MMIO_QUEUE_SEL) = index;
+    if (VIRTIO_REG(dev, VIRTIO_MMIO_QUEUE_READY) ||
+        VIRTIO_REG(dev, VIRTIO_MMIO_QUEUE_NUM_MAX) < VIRTQ_SIZE)
+        return -1;
+
+    memset(vq, 0, sizeof(*vq));
+    vq->dev = dev;
+    vq->index = index;
+    vq->num_free = VIRTQ_SIZE;
+    for (uint16_t i = 0; i < VIRTQ_SIZE - 1; i++)
+        vq->desc[i].next = i + 1;
+
+    VIRTIO_REG(dev, VIRTIO_MMIO_QUEUE_NUM) = VIRTQ_SIZE;
+    VIRTIO_REG(dev, VIRTIO_MMIO_QUEUE_DESC_LOW) = (uintptr_t) vq->desc;
+    VIRTIO_REG(dev, VIRTIO_MMIO_QUEUE_DESC_HIGH) = 0;
+    VIRTIO_REG(dev, VIRTIO_MMIO_QUEUE_DRIVER_LOW) = (uintptr_t) &vq->avail;
+    VIRTIO_REG(dev, VIRTIO_MMIO_QUEUE_DRIVER_HIGH) = 0;
+    VIRTIO_REG(dev, VIRTIO_MMIO_QUEUE_DEVICE_LOW) = (uintptr_t) &vq->used;
+    VIRTIO_REG(dev, VIRTIO_MMIO_QUEUE_DEVICE_HIGH) = 0;
+    VIRTIO_REG(dev, VIRTIO_MMIO_QUEUE_READY) = 1;
+
+    return 0;
+}
+
+void virtio_ready(virtio_dev_t *dev)
+{
+    VIRTIO_REG(dev, VIRTIO_MMIO_STATUS) |= VIRTIO_STATUS_DRIVER_OK;
+}
+
+uint32_t virtio_config_read(virtio_dev_t *dev, uint32_t offset)
+{
+    return VIRTIO_REG(dev, VIRTIO_MMIO_CONFIG + offset);
+}
+
+uint32_t virtio_irq_ack(virtio_dev_t *dev)
+{
+    uint32_t status = VIRTIO_REG(dev, VIRTIO_MMIO_INTERRUPT_STATUS);
+    VIRTIO_REG(dev, VIRTIO_MMIO_INTERRUPT_ACK) = status;
+    return status;
+}
+
+int32_t virtq_submit(virtq_t *vq,
+                     const virtq_buf_t *bufs,
+                     uint16_t count,
+                     void *token)
+{
+    if (unlikely(!count || count > vq->num_free))
+        return -1;
+
+    uint16_t head = vq->free_head;
+    uint16_t d = head;
+    for (uint16_t i = 0; i < count; i++) {
+        vq->desc[d].addr = (uintptr_t) bufs[i].addr;
+        vq->desc[d].len = bufs[i].len;
+        vq->desc[d].flags = bufs[i].flags & VIRTQ_DESC_F_WRITE;
+        if (i + 1 < count) {
+            vq->desc[d].flags |= VIRTQ_DESC_F_NEXT;
+            d = vq->desc[d].next;
+        }
+    }
+    vq->free_head = vq->desc[d].next;
+    vq->num_free -= count;
+    vq->token[head] = token;
+
+    vq->avail.ring[vq->avail.idx & (VIRTQ_SIZE - 1)] = head;
+    virtio_mb(); /* Descriptors and ring entry before the index */
+    vq->avail.idx++;
+
+    return 0;
+}
+
+void virtq_kick(virtq_t *vq)
+{
+    virtio_mb(); /* Available index before the notification */
+    VIRTIO_REG(vq->dev, VIRTIO_MMIO_QUEUE_NOTIFY) = vq->index;
+}
+
+void *virtq_reclaim(virtq_t *vq, uint32_t *len)
+{
+    if (vq->last_used == *(volatile uint16_t *) &vq->used.idx)
+        return NULL;
+    virtio_mb(); /* Used index before the used ring entry */
+
+    uint32_t slot = vq->last_used++ & (VIRTQ_SIZE - 1);
+    uint16_t head = vq->used.ring[slot].id;
+    if (len)
+        *len = vq->used.ring[slot].len;
+
+    /* Return the chain to the free list */
+    uint16_t d = head;
+    vq->num_free++;
+    while (vq->desc[d].flags & VIRTQ_DESC_F_NEXT) {
+        d = vq->desc[d].next;
+        vq->num_free++;
+    }
+    vq->desc[d].next = vq->free_head;
+    vq->free_head = head;
+
+    void *token = vq->token[head];
+    vq->token[head] = NULL;
+    return token;
+}
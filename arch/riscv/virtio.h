@@ -0,0 +1,224 @@
+#pragma once
+
+/* virtio-mmio Transport
+ *
+ * Minimal driver-side implementation of the virtio 1.x MMIO transport
+ * (non-legacy, version 2) and split virtqueues, as provided by the QEMU
+ * 'virt' machine. QEMU defaults to the legacy interface; it must be started
+ * with '-global virtio-mmio.force-legacy=false'.
+ *
+ * Devices are polled or interrupt driven at the device driver's choice;
+ * nothing here blocks except device reset. There is no IOMMU or MMU, so
+ * buffer addresses are passed to the device as-is.
+ */
+
+#include <types.h>
+
+/* MMIO slots of the 'virt' machine; slot N raises PLIC source N + 1 */
+#define VIRTIO_MMIO_BASE 0x10001000U
+#define VIRTIO_MMIO_STRIDE 0x1000U
+#define VIRTIO_MMIO_SLOTS 8
+#define VIRTIO_MMIO_IRQ(slot) ((slot) + 1)
+
+/* Device IDs */
+#define VIRTIO_ID_BLOCK 2
+#define VIRTIO_ID_CONSOLE 3
+
+/* Descriptor flags */
+#define VIRTQ_DESC_F_NEXT 1  /* Buffer continues in the 'next' descriptor */
+#define VIRTQ_DESC_F_WRITE 2 /* Buffer is written by the device */
+
+/* Descriptors per virtqueue; must be a power of two */
+#ifndef VIRTQ_SIZE
+#define VIRTQ_SIZE 16
+#endif
+
+/* Split virtqueue rings, laid out as the device expects them */
+typedef struct {
+    uint64_t addr;
+    uint32_t len;
+    uint16_t flags;
+    uint16_t next;
+} virtq_desc_t;
+
+typedef struct {
+    uint16_t flags;
+    uint16_t idx;
+    uint16_t ring[VIRTQ_SIZE];
+    uint16_t used_event;
+} virtq_avail_t;
+
+typedef struct {
+    uint16_t flags;
+    uint16_t idx;
+    struct {
+        uint32_t id;
+        uint32_t len;
+    } ring[VIRTQ_SIZE];
+    uint16_t avail_event;
+} virtq_used_t;
+
+typedef struct {
+    uintptr_t base; /* MMIO register block */
+    uint32_t irq;   /* PLIC source */
+} virtio_dev_t;
+
+/* One virtqueue: the shared rings plus driver-private bookkeeping */
+typedef struct {
+    virtq_desc_t desc[VIRTQ_SIZE] __attribute__((aligned(16)));
+    virtq_avail_t avail __attribute__((aligned(2)));
+    virtq_used_t used __attribute__((aligned(4)));
+
+    virtio_dev_t *dev;
+    void *token[VIRTQ_SIZE]; /* Caller cookie of each in-flight chain head */
+    uint16_t index;          /* Queue number within the device */
+    uint16_t free_head;      /* First unused descriptor */
+    uint16_t num_free;
+    uint16_t last_used; /* Next used ring entry to reclaim */
+} virtq_t;
+
+/* One buffer of a descriptor chain */
+typedef struct {
+    void *addr;
+    uint32_t len;
+    uint16_t flags; /* VIRTQ_DESC_F_WRITE for device-writable buffers */
+} virtq_buf_t;
+
+/* Device Setup */
+
+/* Finds the first virtio-mmio slot holding a device with @device_id.
+ * Returns 0 and fills @dev on success, -1 if there is none.
+ */
+int32_t virtio_probe(uint32_t device_id, virtio_dev_t *dev);
+
+/* Resets the device and negotiates features. @features is the set of
+ * device-specific feature bits (0-31) the driver supports; VIRTIO_F_VERSION_1
+ * is always required. Returns the negotiated bits, or -1 on failure.
+ */
+int32_t virtio_setup(virtio_dev_t *dev, uint32_t features);
+
+/* Sets up queue @index of the device using the rings in @vq.
+ * Returns 0 on success, -1 if the device cannot provide the queue.
+ */
+int32_t virtio_queue_setup(virtio_dev_t *dev, virtq_t *vq, uint16_t index);
+
+/* Marks the driver ready; call after all queues are set up */
+void virtio_ready(virtio_dev_t *dev);
+
+/* Reads a 32-bit word of the device-specific configuration space */
+uint32_t virtio_config_read(virtio_dev_t *dev, uint32_t offset);
+
+/* Reads and acknowledges the interrupt status. Returns the status bits. */
+uint32_t virtio_irq_ack(virtio_dev_t *dev);
+
+/* Queue Operations
+ *
+ * Not synchronized: callers serialize access to a queue, typically with
+ * interrupts disabled when it is also used from an interrupt handler.
+ */
+
+/* Adds a chain of @count buffers to the available ring. @token is returned
+ * by 'virtq_reclaim()' once the device has used the chain. The device is not
+ * notified until 'virtq_kick()'.
+ * Returns 0 on success, -1 if not enough descriptors are free.
+ */
+int32_t virtq_submit(virtq_t *vq,
+                     const virtq_buf_t *bufs,
+                     uint16_t count,
+                     void *token);
+
+/* Notifies the device that new buffers are available */
+void virtq_kick(virtq_t *vq);
+
+/* Returns the token of the next chain used by the device and frees its
+ * descriptors, or NULL if none. If @len is not NULL, it receives the number
+ * of bytes the device wrote.
+ */
+void *virtq_reclaim(virtq_t *vq, uint32_t *len);
+
+/* virtio-console
+ *
+ * Output-only driver for port 0 of a virtio console. Output is staged in two
+ * buffers: one is filled while the other is in flight, and a buffer is handed
+ * to the device as soon as the device is idle or the buffer is full, so
+ * output is batched under load without delaying it when the link is quiet.
+ */
+
+/* Probes and starts the console. Returns 0 on success, -1 if absent. */
+int32_t virtio_console_init(void);
+
+/* Queues up to @len bytes. Returns the number accepted, which is less than
+ * @len when both buffers are in use. Safe from tasks and interrupts.
+ */
+uint32_t virtio_console_write(const void *buf, uint32_t len);
+
+/* '_stdout_install()' backend. Blocks until the byte is accepted and pushes
+ * out buffered output at each newline.
+ */
+int virtio_console_putchar(int c);
+
+/* virtio-blk
+ *
+ * Asynchronous block driver. Requests are queued in sector order and sent
+ * to the device as descriptors allow; pending requests for adjacent sectors
+ * in the same direction are merged into one device request with one data
+ * descriptor each, up to VBLK_MAX_MERGE. Completion is interrupt driven.
+ *
+ * Requests in flight at the same time may complete in any order; a caller
+ * that needs ordering between two requests must wait for the first.
+ */
+
+#define VBLK_SECTOR_SIZE 512
+#define VBLK_MAX_MERGE 4 /* Requests merged into one device request */
+
+/* Request operations */
+#define VBLK_READ 0
+#define VBLK_WRITE 1
+#define VBLK_FLUSH 4 /* Commit written data to stable storage */
+
+/* Request status; any other negative value is an error */
+#define VBLK_PENDING 1
+#define VBLK_OK 0
+#define VBLK_ERROR (-1)
+
+typedef struct vblk_req {
+    struct vblk_req *next; /* Driver-private queue link */
+    uint32_t op;           /* VBLK_READ, VBLK_WRITE or VBLK_FLUSH */
+    uint32_t sector;       /* First sector */
+    uint32_t count;        /* Sectors to transfer (0 for VBLK_FLUSH) */
+    void *buf;             /* count * VBLK_SECTOR_SIZE bytes */
+
+    /* Called with interrupts disabled once 'status' is final: usually from
+     * the completion interrupt, but in task context from 'virtio_blk_wait()'
+     * when it polls, and from 'virtio_blk_submit()' itself for a flush the
+     * device does not need. Must not block or yield either way. The request
+     * may be reused or freed from the callback.
+     */
+    void (*done)(struct vblk_req *req);
+    void *arg; /* For the owner's use */
+
+    volatile int32_t status; /* VBLK_PENDING until completion */
+    void *waiter;            /* Task blocked in 'virtio_blk_wait()' */
+} vblk_req_t;
+
+/* Probes and starts the block device. Returns 0 on success, -1 if absent. */
+int32_t virtio_blk_init(void);
+
+/* Returns the device capacity in sectors, or 0 without a device */
+uint32_t virtio_blk_capacity(void);
+
+/* Queues @req and returns without waiting. Returns 0 if queued, -1 if the
+ * request is invalid (out of range, write to a read-only device, no device).
+ */
+int32_t virtio_blk_submit(vblk_req_t *req);
+
+/* Blocks the calling task until @req completes and returns its status.
+ * Polls the device instead when called with interrupts disabled (before
+ * the scheduler starts).
+ */
+int32_t virtio_blk_wait(vblk_req_t *req);
+
+/* Synchronous helper: submits one request and waits for it.
+ * Returns VBLK_OK or a negative status.
+ */
+int32_t virtio_blk_rw(uint32_t op, uint32_t sector, void *buf, uint32_t count);
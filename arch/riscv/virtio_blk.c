@@ -0,0 +1,395 @@
+/* virtio-blk Driver
+ *
+ * Requests wait in a pending list kept in sector order. Whenever a device
+ * request slot and enough descriptors are free, the next request of a
+ * circular sweep (the first at or above the sector where the previous
+ * dispatch ended, wrapping to the lowest) is sent together with the pending
+ * requests that directly follow it on disk in the same direction, as one
+ * device request:
+ *
+ *   [header] [data req 1] ... [data req n] [status]
+ *
+ * The completion interrupt finishes every request of a device request,
+ * wakes blocked waiters (switching to them as the interrupt returns, rather
+ * than at the next tick), runs callbacks and refills the queue, so the CPU
+ * only spends time per request, never per sector. The sweep only moves
+ * forward, so requests at low sectors cannot be starved by a stream of
+ * requests just above them.
+ */
+
+#include <hal.h>
+#include <lib/libc.h>
+#include <sys/blkdev.h>
+#include <sys/errno.h>
+#include <sys/task.h>
+
+#include "private/utils.h"
+#include "virtio.h"
+
+#define VBLK_REQQ 0 /* requestq */
+
+/* Feature bits */
+#define VIRTIO_BLK_F_RO (1U << 5)    /* Device is read-only */
+#define VIRTIO_BLK_F_FLUSH (1U << 9) /* Cache flush command support */
+
+/* Configuration space: 64-bit capacity in sectors */
+#define VIRTIO_BLK_CFG_CAPACITY_LO 0x00
+#define VIRTIO_BLK_CFG_CAPACITY_HI 0x04
+
+/* Status byte written by the device */
+#define VIRTIO_BLK_S_OK 0
+
+/* Device requests in flight: each needs at least three descriptors */
+#define VBLK_SLOTS (VIRTQ_SIZE / 3)
+
+/* Block device writes queued at once, for the driver to merge */
+#define VBLK_DEV_BATCH 8
+
+typedef struct {
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t sector;
+} vblk_hdr_t;
+
+typedef struct {
+    vblk_hdr_t hdr;
+    uint8_t status;
+    bool used;
+    vblk_req_t *reqs; /* Requests carried, linked through 'next' */
+} vblk_slot_t;
+
+static struct {
+    virtio_dev_t dev;
+    virtq_t vq;
+    vblk_slot_t slot[VBLK_SLOTS];
+    vblk_req_t *pending; /* Sorted by sector between flushes */
+    uint32_t sweep;      /* Sector where the last dispatch ended */
+    uint32_t capacity;
+    uint32_t features;
+    bool ready;
+} vblk;
+
+static vblk_slot_t *vblk_slot_alloc(void)
+{
+    for (int i = 0; i < VBLK_SLOTS; i++) {
+        if (!vblk.slot[i].used) {
+            vblk.slot[i].used = true;
+            return &vblk.slot[i];
+        }
+    }
+    return NULL;
+}
+
+/* Takes the next request of the sweep and the requests mergeable with it.
+ * Only the requests ahead of the first flush take part; the flush itself
+ * goes once they are all sent.
+ */
+static vblk_req_t *vblk_take_batch(uint16_t *count)
+{
+    vblk_req_t **link = &vblk.pending;
+    while (*link && (*link)->op != VBLK_FLUSH && (*link)->sector < vblk.sweep)
+        link = &(*link)->next;
+    if (!*link || (*link)->op == VBLK_FLUSH)
+        link = &vblk.pending; /* Nothing left ahead: wrap around */
+
+    vblk_req_t *first = *link, *last = first;
+    uint16_t n = 1;
+
+    if (first->op != VBLK_FLUSH) {
+        while (n < VBLK_MAX_MERGE && last->next &&
+               last->next->op == first->op &&
+               last->next->sector == last->sector + last->count) {
+            last = last->next;
+            n++;
+        }
+    }
+
+    *link = last->next;
+    last->next = NULL;
+    if (first->op != VBLK_FLUSH)
+        vblk.sweep = last->sector + last->count;
+    *count = n;
+    return first;
+}
+
+/* Sends pending requests while slots and descriptors last. Interrupts must
+ * be disabled.
+ */
+static void vblk_dispatch(void)
+{
+    bool kicked = false;
+
+    while (vblk.pending && vblk.vq.num_free >= 2 + VBLK_MAX_MERGE) {
+        vblk_slot_t *slot = vblk_slot_alloc();
+        if (!slot)
+            break;
+
+        uint16_t n;
+        vblk_req_t *reqs = vblk_take_batch(&n);
+        virtq_buf_t bufs[2 + VBLK_MAX_MERGE];
+        uint16_t nbufs = 0;
+
+        slot->hdr.type = reqs->op;
+        slot->hdr.reserved = 0;
+        slot->hdr.sector = reqs->sector;
+        slot->status = 0xff;
+        slot->reqs = reqs;
+
+        bufs[nbufs++] = (virtq_buf_t){&slot->hdr, sizeof(slot->hdr), 0};
+        for (vblk_req_t *r = reqs; r && r->count; r = r->next) {
+            bufs[nbufs++] = (virtq_buf_t){
+                r->buf, r->count * VBLK_SECTOR_SIZE,
+                r->op == VBLK_READ ? VIRTQ_DESC_F_WRITE : 0};
+        }
+        bufs[nbufs++] = (virtq_buf_t){&slot->status, 1, VIRTQ_DESC_F_WRITE};
+
+        virtq_submit(&vblk.vq, bufs, nbufs, slot); /* Space checked above */
+        kicked = true;
+    }
+
+    if (kicked)
+        virtq_kick(&vblk.vq);
+}
+
+/* Finishes every device request the device has used */
+static void vblk_complete(void)
+{
+    vblk_slot_t *slot;
+
+    while ((slot = virtq_reclaim(&vblk.vq, NULL))) {
+        int32_t status =
+            slot->status == VIRTIO_BLK_S_OK ? VBLK_OK : VBLK_ERROR;
+        vblk_req_t *r = slot->reqs;
+        slot->reqs = NULL;
+        slot->used = false;
+
+        while (r) {
+            vblk_req_t *next = r->next;
+            tcb_t *waiter = r->waiter;
+
+            r->next = NULL;
+            r->status = status;
+            if (waiter)
+                _sched_wakeup_irq(waiter); /* Runs once the interrupt ends */
+            if (r->done)
+                r->done(r); /* May free or resubmit @r */
+            r = next;
+        }
+    }
+
+    vblk_dispatch();
+}
+
+static void vblk_irq(void)
+{
+    virtio_irq_ack(&vblk.dev);
+    vblk_complete();
+}
+
+int32_t virtio_blk_init(void)
+{
+    if (vblk.ready)
+        return 0;
+
+    int32_t features = virtio_probe(VIRTIO_ID_BLOCK, &vblk.dev) < 0
+                           ? -1
+                           : virtio_setup(&vblk.dev, VIRTIO_BLK_F_RO |
+                                                         VIRTIO_BLK_F_FLUSH);
+    if (features < 0 || virtio_queue_setup(&vblk.dev, &vblk.vq, VBLK_REQQ) < 0)
+        return -1;
+
+    vblk.features = (uint32_t) features;
+    /* Capacities beyond 2 TiB are clamped to what 32-bit sectors address */
+    vblk.capacity =
+        virtio_config_read(&vblk.dev, VIRTIO_BLK_CFG_CAPACITY_HI)
+            ? UINT32_MAX
+            : virtio_config_read(&vblk.dev, VIRTIO_BLK_CFG_CAPACITY_LO);
+
+    virtio_ready(&vblk.dev);
+    hal_irq_attach(vblk.dev.irq, vblk_irq);
+    vblk.ready = true;
+    return 0;
+}
+
+uint32_t virtio_blk_capacity(void)
+{
+    return vblk.ready ? vblk.capacity : 0;
+}
+
+int32_t virtio_blk_submit(vblk_req_t *req)
+{
+    if (unlikely(!vblk.ready || !req))
+        return -1;
+
+    switch (req->op) {
+    case VBLK_WRITE:
+        if (vblk.features & VIRTIO_BLK_F_RO)
+            return -1;
+        /* fall through */
+    case VBLK_READ:
+        if (!req->count || !req->buf || req->sector >= vblk.capacity ||
+            req->count > vblk.capacity - req->sector)
+            return -1;
+        break;
+    case VBLK_FLUSH:
+        if (!(vblk.features & VIRTIO_BLK_F_FLUSH)) {
+            /* Without a volatile write cache there is nothing to flush.
+             * Callbacks always run with interrupts disabled.
+             */
+            req->status = VBLK_OK;
+            if (req->done) {
+                int32_t was_enabled = _di();
+                req->done(req);
+                hal_interrupt_set(was_enabled);
+            }
+            return 0;
+        }
+        req->count = 0;
+        break;
+    default:
+        return -1;
+    }
+
+    req->status = VBLK_PENDING;
+    req->waiter = NULL;
+
+    int32_t was_enabled = _di();
+
+    /* A flush goes to the tail and nothing overtakes it in either
+     * direction, so it cannot be starved either: other requests are sorted
+     * in behind the last flush, after those for the same or lower sectors.
+     */
+    vblk_req_t **link = &vblk.pending;
+    if (req->op == VBLK_FLUSH) {
+        while (*link)
+            link = &(*link)->next;
+    } else {
+        for (vblk_req_t **l = link; *l; l = &(*l)->next) {
+            if ((*l)->op == VBLK_FLUSH)
+                link = &(*l)->next;
+        }
+        while (*link && (*link)->sector <= req->sector)
+            link = &(*link)->next;
+    }
+    req->next = *link;
+    *link = req;
+
+    vblk_dispatch();
+    hal_interrupt_set(was_enabled);
+    return 0;
+}
+
+int32_t virtio_blk_wait(vblk_req_t *req)
+{
+    int32_t was_enabled = _di();
+
+    while (req->status == VBLK_PENDING) {
+        if (!was_enabled || !kcb->task_current) {
+            /* No interrupts to rely on: poll the used ring */
+            vblk_complete();
+            continue;
+        }
+
+        /* Block until the completion interrupt readies us. Setting the state
+         * with interrupts off means a completion cannot slip in between
+         * the status check and blocking.
+         */
+        tcb_t *self = kcb->task_current->data;
+        req->waiter = self;
+        if (kcb->preemptive)
+            self->state = TASK_BLOCKED;
+        hal_interrupt_set(was_enabled);
+
+        /* A completion taken right here has readied us already, and a yield
+         * would only queue us behind everybody else.
+         */
+        if (self->state == TASK_BLOCKED || !kcb->preemptive)
+            _yield();
+        _di();
+    }
+    req->waiter = NULL;
+
+    hal_interrupt_set(was_enabled);
+    return req->status;
+}
+
+int32_t virtio_blk_rw(uint32_t op, uint32_t sector, void *buf, uint32_t count)
+{
+    vblk_req_t req = {
+        .op = op,
+        .sector = sector,
+        .count = count,
+        .buf = buf,
+    };
+
+    if (virtio_blk_submit(&req) < 0)
+        return VBLK_ERROR;
+    return virtio_blk_wait(&req);
+}
+
+/* Block Device Adapter */
+
+STATIC_ASSERT(BLK_SIZE == VBLK_SECTOR_SIZE, "blocks must be sectors");
+
+static int32_t vblk_dev_read(blkdev_t *dev, uint32_t block, void *buf)
+{
+    return virtio_blk_rw(VBLK_READ, block, buf, 1) == VBLK_OK ? 0 : -EIO;
+}
+
+/* Submits the blocks in batches so that the driver sees several at once and
+ * merges neighbours, then waits for the whole batch.
+ */
+static int32_t vblk_dev_write(blkdev_t *dev,
+                              const uint32_t *blocks,
+                              void *const *bufs,
+                              uint32_t count)
+{
+    vblk_req_t req[VBLK_DEV_BATCH];
+    int32_t err = 0;
+
+    for (uint32_t base = 0; base < count; base += VBLK_DEV_BATCH) {
+        uint32_t n = min(count - base, (uint32_t) VBLK_DEV_BATCH);
+        uint32_t queued = 0;
+
+        for (; queued < n; queued++) {
+            req[queued] = (vblk_req_t){
+                .op = VBLK_WRITE,
+                .sector = blocks[base + queued],
+                .count = 1,
+                .buf = bufs[base + queued],
+            };
+            if (virtio_blk_submit(&req[queued]) < 0) {
+                err = -EIO;
+                break;
+            }
+        }
+        /* Wait even after a failure: queued requests use our stack */
+        for (uint32_t i = 0; i < queued; i++) {
+            if (virtio_blk_wait(&req[i]) != VBLK_OK)
+                err = -EIO;
+        }
+        if (err)
+            return err;
+    }
+    return 0;
+}
+
+static int32_t vblk_dev_sync(blkdev_t *dev)
+{
+    return virtio_blk_rw(VBLK_FLUSH, 0, NULL, 0) == VBLK_OK ? 0 : -EIO;
+}
+
+struct blkdev *hal_blk_device(void)
+{
+    static blkdev_t dev = {
+        .read = vblk_dev_read,
+        .write = vblk_dev_write,
+        .sync = vblk_dev_sync,
+    };
+
+    if (virtio_blk_init() < 0)
+        return NULL;
+
+    dev.blocks = vblk.capacity;
+    return &dev;
+}
@@ -0,0 +1,123 @@
+/* virtio-console Output Driver
+ *
+ * Sends console output to port 0 of a virtio console in large buffers
+ * instead of one UART register write per byte. Two staging buffers
+ * alternate: output is appended to the filling buffer, which is handed to
+ * the device as soon as the other one has completed. While the device is
+ * busy, output accumulates, so the batch size grows with the load.
+ *
+ * Completion is signaled by interrupt, whose handler submits whatever
+ * accumulated meanwhile. With interrupts disabled (trap context) the
+ * writers reclaim completed buffers themselves.
+ */
+
+#include <hal.h>
+#include <lib/libc.h>
+
+#include "private/utils.h"
+#include "virtio.h"
+
+#define VCON_TXQ 1      /* transmitq of port 0 */
+#define VCON_BUF_SZ 512 /* Bytes per staging buffer */
+
+static struct {
+    virtio_dev_t dev;
+    virtq_t txq;
+    uint8_t buf[2][VCON_BUF_SZ];
+    uint32_t fill; /* Bytes staged in 'buf[cur]' */
+    uint32_t cur;  /* Buffer being filled */
+    bool busy[2];  /* Buffer owned by the device */
+    bool ready;
+} vcon;
+
+/* Marks buffers the device has finished with as free again */
+static void vcon_reclaim(void)
+{
+    uint8_t *done;
+    while ((done = virtq_reclaim(&vcon.txq, NULL)))
+        vcon.busy[done == vcon.buf[1]] = false;
+}
+
+/* Hands the filling buffer to the device if it holds data */
+static void vcon_submit(void)
+{
+    if (!vcon.fill)
+        return;
+
+    virtq_buf_t b = {.addr = vcon.buf[vcon.cur], .len = vcon.fill};
+    if (virtq_submit(&vcon.txq, &b, 1, vcon.buf[vcon.cur]) < 0)
+        return; /* Cannot happen: at most two descriptors are in use */
+    virtq_kick(&vcon.txq);
+
+    vcon.busy[vcon.cur] = true;
+    vcon.cur ^= 1;
+    vcon.fill = 0;
+}
+
+static void vcon_irq(void)
+{
+    virtio_irq_ack(&vcon.dev);
+    vcon_reclaim();
+    if (!vcon.busy[vcon.cur])
+        vcon_submit();
+    if (!vcon.busy[vcon.cur])
+        hal_console_drained(); /* The filling buffer takes output again */
+}
+
+int32_t virtio_console_init(void)
+{
+    if (virtio_probe(VIRTIO_ID_CONSOLE, &vcon.dev) < 0 ||
+        virtio_setup(&vcon.dev, 0) < 0 ||
+        virtio_queue_setup(&vcon.dev, &vcon.txq, VCON_TXQ) < 0)
+        return -1;
+
+    virtio_ready(&vcon.dev);
+    hal_irq_attach(vcon.dev.irq, vcon_irq);
+    vcon.ready = true;
+    return 0;
+}
+
+uint32_t virtio_console_write(const void *buf, uint32_t len)
+{
+    if (unlikely(!vcon.ready))
+        return 0;
+
+    int32_t was_enabled = _di();
+    vcon_reclaim();
+
+    uint32_t done = 0;
+    while (done < len && !vcon.busy[vcon.cur]) {
+        uint32_t n = min(len - done, VCON_BUF_SZ - vcon.fill);
+        memcpy(vcon.buf[vcon.cur] + vcon.fill, (const uint8_t *) buf + done,
+               n);
+        vcon.fill += n;
+        done += n;
+
+        /* Send now if the device is idle; otherwise only full buffers */
+        if (!vcon.busy[vcon.cur ^ 1] || vcon.fill == VCON_BUF_SZ)
+            vcon_submit();
+    }
+
+    hal_interrupt_set(was_enabled);
+    return done;
+}
+
+int virtio_console_putchar(int c)
+{
+    uint8_t ch = (uint8_t) c;
+
+    while (!virtio_console_write(&ch, 1))
+        ; /* Both buffers in flight; the device drains them */
+
+    if (ch == '\n') {
+        /* Make sure the line leaves even if no interrupt follows */
+        int32_t was_enabled = _di();
+        while (vcon.fill) {
+            vcon_reclaim();
+            if (!vcon.busy[vcon.cur])
+                vcon_submit();
+        }
+        hal_interrupt_set(was_enabled);
+    }
+    return c;
+}
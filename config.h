@@ -4,3 +4,13 @@
 #ifndef CONFIG_STACK_PROTECTION
 #define CONFIG_STACK_PROTECTION 1 /* Default: enabled for safety */
 #endif
+
+/* Statistical PC-Sampling Profiler */
+#ifndef CONFIG_PROFILER
+#define CONFIG_PROFILER 0 /* Default: disabled, saves the sample buffer */
+#endif
+
+/* Console on virtio-console instead of the NS16550A UART, when present */
+#ifndef CONFIG_VIRTIO_CONSOLE
+#define CONFIG_VIRTIO_CONSOLE 0 /* Default: disabled, UART console */
+#endif
@@ -51,6 +51,11 @@ typedef _Bool bool;
     (((((uint16_t) (n) & 0x00FF)) << 8) | (((uint16_t) (n) & 0xFF00) >> 8))
 
 /* 32-bit byte swap */
+#if defined(__riscv_zbb)
+/* Single 'rev8' instruction */
+#define htonl(n) __builtin_bswap32((uint32_t) (n))
+#define ntohl(n) __builtin_bswap32((uint32_t) (n))
+#else
 #define htonl(n)                               \
     (((((uint32_t) (n) & 0x000000FF)) << 24) | \
      ((((uint32_t) (n) & 0x0000FF00)) << 8) |  \
@@ -62,6 +67,7 @@ typedef _Bool bool;
      ((((uint32_t) (n) & 0x0000FF00)) << 8) |  \
      ((((uint32_t) (n) & 0x00FF0000)) >> 8) |  \
      ((((uint32_t) (n) & 0xFF000000)) >> 24))
+#endif
 
 /* 64-bit byte swap - relies on 32-bit htonl/ntohl */
 #define htonll(x)                                                         \
@@ -109,8 +115,9 @@ char *strtok_r(char *s, const char *delim, char **holder);
 void *memcpy(void *dst, const void *src, uint32_t n);
 void *memmove(void *dst, const void *src, uint32_t n);
 
-/* Memory comparison and initialization */
+/* Memory comparison, search and initialization */
 int32_t memcmp(const void *cs, const void *ct, uint32_t n);
+void *memchr(const void *s, int32_t c, uint32_t n);
 void *memset(void *s, int32_t c, uint32_t n);
 
 /* Mathematical Functions */
@@ -0,0 +1,109 @@
+/* Reference-counted chained packet buffers (pbufs).
+ *
+ * A packet is a chain of segments linked through 'next'. Each segment holds
+ * a reference count, so several owners (protocol layers, queues, tasks) can
+ * share one packet without copying it; the segment is released when its
+ * last reference is dropped. Headers are added and removed in place by
+ * moving 'payload' within headroom reserved at allocation time.
+ *
+ * Segments come either from the heap (one segment sized to the request) or
+ * from a fixed-size segment pool, which gives deterministic allocation and
+ * chains as many segments as the requested length needs.
+ *
+ * Pbufs can be passed by reference through message queues (see
+ * 'mo_mq_enqueue_pbuf()'), which copies nothing. Pipes hold bytes, not
+ * references: 'mo_pipe_write_pbuf()' and 'mo_pipe_read_pbuf()' still copy
+ * the payload into and out of the pipe's ring, and only save linearizing
+ * the chain into a separate buffer first.
+ */
+
+#pragma once
+
+#include <sys/mqueue.h>
+
+struct pbuf_pool;
+
+/* Buffer segment */
+typedef struct pbuf {
+    struct pbuf *next;      /* Next segment of the chain, NULL at the end */
+    uint8_t *payload;       /* Start of valid data within 'data' */
+    uint16_t len;           /* Valid bytes in this segment */
+    uint16_t tot_len;       /* Valid bytes in this and following segments */
+    uint16_t cap;           /* Size of 'data' in bytes */
+    volatile uint16_t refs; /* References held on this segment */
+    struct pbuf_pool *pool; /* Owning pool, or NULL if heap-allocated */
+    message_t msg;          /* Carrier used when queued in an mq_t */
+    uint8_t data[];         /* Segment storage: headroom, then payload */
+} pbuf_t;
+
+/* Pool of equally sized segments carved from one allocation */
+typedef struct pbuf_pool {
+    pbuf_t *free;      /* Free segments, linked through 'next' */
+    void *mem;         /* Backing storage */
+    uint16_t seg_size; /* Data bytes per segment */
+    uint16_t count;    /* Total number of segments */
+    uint16_t avail;    /* Segments currently free */
+} pbuf_pool_t;
+
+/* Creates a segment pool.
+ * @seg_size: Data bytes per segment (must be > 0).
+ * @count: Number of segments (must be > 0).
+ * Return The pool, or NULL on failure.
+ */
+pbuf_pool_t *pbuf_pool_create(uint16_t seg_size, uint16_t count);
+
+/* Destroys a pool. Fails if any of its segments are still in use.
+ * Return 0 on success, or a negative error code on failure.
+ */
+int32_t pbuf_pool_destroy(pbuf_pool_t *pool);
+
+/* Allocates a packet of @len payload bytes with @headroom bytes reserved in
+ * front of the first segment for headers pushed later.
+ * @pool: Segment pool, or NULL to allocate one segment from the heap, whose
+ *        @headroom plus @len must not exceed UINT16_MAX.
+ *        From a pool, the packet is chained over as many segments as needed;
+ *        @headroom must fit in one segment.
+ * Return The packet holding one reference, or NULL on failure.
+ */
+pbuf_t *pbuf_alloc(pbuf_pool_t *pool, uint16_t len, uint16_t headroom);
+
+/* Takes an additional reference on the packet starting at @p. */
+void pbuf_ref(pbuf_t *p);
+
+/* Drops one reference on @p. Segments whose count reaches zero are released,
+ * continuing down the chain until a segment that is still referenced.
+ * Return The number of segments released.
+ */
+uint16_t pbuf_free(pbuf_t *p);
+
+/* Appends the chain @tail to the chain @head. The caller's reference on
+ * @tail passes to @head, so only @head must be freed afterwards.
+ */
+void pbuf_cat(pbuf_t *head, pbuf_t *tail);
+
+/* Prepends @n header bytes to the packet by growing the first segment into
+ * its headroom. No data is moved.
+ * Return Pointer to the new header bytes, or NULL if headroom is short.
+ */
+void *pbuf_push(pbuf_t *p, uint16_t n);
+
+/* Strips @n header bytes from the front of the first segment.
+ * Return 0 on success, or a negative error code if the segment is shorter.
+ */
+int32_t pbuf_pop(pbuf_t *p, uint16_t n);
+
+/* Copies up to @len bytes starting at byte @offset of the packet to @dst.
+ * Return The number of bytes copied.
+ */
+uint16_t pbuf_copy_out(const pbuf_t *p,
+                       void *dst,
+                       uint16_t len,
+                       uint16_t offset);
+
+/* Copies up to @len bytes from @src into the packet at byte @offset.
+ * Return The number of bytes copied.
+ */
+uint16_t pbuf_copy_in(pbuf_t *p,
+                      const void *src,
+                      uint16_t len,
+                      uint16_t offset);
@@ -76,5 +76,15 @@ int32_t queue_enqueue(queue_t *q, void *ptr);
 /* Removes an element from the head of the queue (FIFO). */
 void *queue_dequeue(queue_t *q);
 
+/* Adds up to @n elements from @items to the tail of the queue, in order.
+ * Returns the number of elements added (less than @n if the queue filled).
+ */
+uint32_t queue_enqueue_many(queue_t *q, void *const *items, uint32_t n);
+
+/* Removes up to @max elements from the head of the queue into @out.
+ * Returns the number of elements removed (0 if the queue was empty).
+ */
+uint32_t queue_dequeue_many(queue_t *q, void **out, uint32_t max);
+
 /* Returns the element at the head of the queue without removing it. */
 void *queue_peek(const queue_t *q);
@@ -4,13 +4,23 @@
 
 #include <lib/libc.h>
 #include <lib/malloc.h>
+#include <lib/pbuf.h>
 
+#include <sys/blkdev.h>
 #include <sys/errno.h>
+#include <sys/fcntl.h>
+#include <sys/fd.h>
+#include <sys/fs.h>
+#include <sys/futex.h>
+#include <sys/ipc.h>
 #include <sys/logger.h>
 #include <sys/mqueue.h>
 #include <sys/mutex.h>
 #include <sys/pipe.h>
+#include <sys/profiler.h>
+#include <sys/pt.h>
 #include <sys/semaphore.h>
 #include <sys/syscall.h>
 #include <sys/task.h>
 #include <sys/timer.h>
+#include <sys/topic.h>
@@ -0,0 +1,44 @@
+#pragma once
+
+/* Write-Back Block Cache
+ *
+ * Caches blocks of a block device in a fixed set of buffers replaced in
+ * least-recently-used order. Modified buffers are only marked dirty; they
+ * reach the device when the cache is flushed, all at once and in block
+ * order so that the driver can merge neighbours, or when a dirty buffer has
+ * to be evicted. Not synchronized: the owner serializes access.
+ */
+
+#include <lib/libc.h>
+#include <sys/blkdev.h>
+
+typedef struct bcache bcache_t;
+
+/* Creates a cache of @nbufs buffers (at least 2) in front of @dev.
+ * Returns the cache, or NULL if memory is exhausted.
+ */
+bcache_t *bcache_create(blkdev_t *dev, uint32_t nbufs);
+
+/* Flushes and frees the cache */
+void bcache_destroy(bcache_t *bc);
+
+/* Returns the buffer holding @block, reading it from the device unless
+ * @fill is false (the caller overwrites the whole block), or NULL on an I/O
+ * error. The buffer stays valid until two further 'bcache_get()' calls have
+ * been made, so two blocks can be worked on at once.
+ */
+uint8_t *bcache_get(bcache_t *bc, uint32_t block, bool fill);
+
+/* Marks the cached @block as modified */
+void bcache_dirty(bcache_t *bc, uint32_t block);
+
+/* Drops @block from the cache without writing it back */
+void bcache_discard(bcache_t *bc, uint32_t block);
+
+/* Returns the number of dirty buffers */
+uint32_t bcache_dirty_count(bcache_t *bc);
+
+/* Writes every dirty buffer back in a single device request.
+ * Returns 0 or a negative errno value.
+ */
+int32_t bcache_flush(bcache_t *bc);
@@ -24,6 +24,7 @@ enum {
     ERR_TASK_INVALID_ENTRY, /* Invalid task entry point */
     ERR_TASK_BUSY,          /* Task is busy or in wrong state */
     ERR_NOT_OWNER,          /* Operation requires ownership */
+    ERR_SCHED_LOCK,         /* Unbalanced or overflowing scheduler lock */
 
     /* Memory Protection Errors */
     ERR_STACK_CHECK,  /* Stack overflow or corruption detected */
@@ -37,6 +38,8 @@ enum {
     ERR_SEM_OPERATION, /* Semaphore operation failed */
     ERR_MQ_NOTEMPTY,   /* Message queue is not empty */
     ERR_TIMEOUT,       /* Operation timed out */
+    ERR_IPC_NO_CALL,   /* No IPC call pending from the given client */
+    ERR_WAIT_VALUE,    /* Wait address no longer holds the expected value */
 
     /* Sentinel - must remain the last entry */
     ERR_UNKNOWN /* Unknown or unclassified error */
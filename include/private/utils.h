@@ -60,3 +60,25 @@ static inline uint32_t nextpowerof2(uint32_t x)
 
     return x;
 }
+
+/* Bit Scan Functions
+ *
+ * With the Zbb extension these compile to a single 'ctz' instruction.
+ * Otherwise a portable fallback is used: the compiler would lower the
+ * builtin to a libgcc helper, which the kernel does not link.
+ */
+
+/* Count trailing zero bits; @x must be non-zero */
+static inline uint32_t ctz32(uint32_t x)
+{
+#if defined(__riscv_zbb)
+    return (uint32_t) __builtin_ctz(x);
+#else
+    /* Isolate the lowest set bit and index a de Bruijn sequence with it */
+    static const uint8_t debruijn[32] = {
+        0,  1,  28, 2,  29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4,  8,
+        31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6,  11, 5,  10, 9,
+    };
+    return debruijn[((x & -x) * 0x077CB531u) >> 27];
+#endif
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+/* Block Devices
+ *
+ * A block device is a linear array of BLK_SIZE byte blocks behind three
+ * operations. Writes take a list of blocks so that a caller flushing many
+ * buffers hands them over in one call; drivers are free to send them to the
+ * hardware concurrently and merge neighbours, and return once all are done.
+ */
+
+#include <types.h>
+
+#define BLK_SIZE 512 /* Bytes per block */
+
+typedef struct blkdev {
+    uint32_t blocks; /* Capacity in blocks */
+
+    /* Reads block @block into @buf. Returns 0 or a negative errno value. */
+    int32_t (*read)(struct blkdev *dev, uint32_t block, void *buf);
+
+    /* Writes @count blocks: block @blocks[i] from @bufs[i]. The blocks need
+     * not be contiguous. Returns 0 or a negative errno value.
+     */
+    int32_t (*write)(struct blkdev *dev,
+                     const uint32_t *blocks,
+                     void *const *bufs,
+                     uint32_t count);
+
+    /* Makes completed writes durable. Returns 0 or a negative errno value. */
+    int32_t (*sync)(struct blkdev *dev);
+
+    void *priv; /* Driver data */
+} blkdev_t;
+
+/* Creates a RAM-backed block device of @blocks zeroed blocks, for testing
+ * and for volatile scratch storage.
+ *
+ * Returns the device, or NULL if memory is exhausted
+ */
+blkdev_t *mo_ramdisk_create(uint32_t blocks);
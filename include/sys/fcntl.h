@@ -0,0 +1,20 @@
+/* Subset of <fcntl.h> and <unistd.h> constants for file access */
+
+#pragma once
+
+/* Access modes for 'open()' */
+#define O_RDONLY 0x0000 /* Open for reading only */
+#define O_WRONLY 0x0001 /* Open for writing only */
+#define O_RDWR 0x0002   /* Open for reading and writing */
+#define O_ACCMODE 0x0003
+
+/* Open flags */
+#define O_APPEND 0x0008 /* Every write goes to the end of the file */
+#define O_CREAT 0x0200  /* Create the file if it does not exist */
+#define O_TRUNC 0x0400  /* Truncate the file to zero length */
+#define O_EXCL 0x0800   /* With O_CREAT, fail if the file exists */
+
+/* Origins for 'lseek()' */
+#define SEEK_SET 0 /* From the start of the file */
+#define SEEK_CUR 1 /* From the current position */
+#define SEEK_END 2 /* From the end of the file */
@@ -0,0 +1,74 @@
+#pragma once
+
+/* File Descriptors
+ *
+ * A single table, shared by all tasks, maps small integers to open objects:
+ * the console, pipe ends, files and any device that provides an 'fd_ops_t'.
+ * Descriptors 0, 1 and 2 are the console from boot on. Duplicated
+ * descriptors share one open object, which is closed with the last of them.
+ *
+ * Data moves through the object's operations in one call per request, so
+ * 'read()' and 'write()' on a pipe or the console cost one bulk transfer,
+ * not one call per byte.
+ *
+ * Functions return a non-negative value on success, or a negative errno
+ * value (e.g. -EBADF) on failure, and must be called from task context.
+ */
+
+#include <types.h>
+
+struct stat;
+
+#define FD_MAX 16        /* Descriptors in the table */
+#define FD_PIPE_SIZE 256 /* Buffer size of pipes made by 'mo_fd_pipe()' */
+
+/* Operations of an open object. Each returns a non-negative value or a
+ * negative errno value; a NULL entry makes the operation fail with -EBADF
+ * (read, write), -ESPIPE (seek) or succeed trivially (fstat, close).
+ */
+typedef struct {
+    /* Reads up to @len bytes, blocking until at least one is available.
+     * Returns the bytes read, 0 at the end of the data.
+     */
+    int32_t (*read)(void *obj, void *buf, uint32_t len);
+
+    /* Writes @len bytes. Returns the bytes written. */
+    int32_t (*write)(void *obj, const void *buf, uint32_t len);
+
+    /* Moves the position (SEEK_* @whence). Returns the new position. */
+    int32_t (*seek)(void *obj, int32_t offset, int32_t whence);
+
+    /* Fills @st, which is zeroed beforehand */
+    int32_t (*fstat)(void *obj, struct stat *st);
+
+    /* Releases @obj once no descriptor refers to it */
+    int32_t (*close)(void *obj);
+} fd_ops_t;
+
+/* Installs @obj with @ops at the lowest free descriptor.
+ * Returns the descriptor, or -EMFILE if the table is full.
+ */
+int32_t mo_fd_install(const fd_ops_t *ops, void *obj);
+
+/* Opens file @name on the mounted file system (see <sys/fs.h>) */
+int32_t mo_fd_open(const char *name, int32_t flags);
+
+/* Creates a pipe: @fds[0] is its read end, @fds[1] its write end. The pipe
+ * is destroyed when both ends are closed. Once the write end is closed,
+ * reads return what is left and then 0; once the read end is closed, writes
+ * fail with -EPIPE.
+ */
+int32_t mo_fd_pipe(int32_t fds[2]);
+
+/* Returns a new descriptor for the object @fd refers to */
+int32_t mo_fd_dup(int32_t fd);
+
+/* Closes @fd. Returns the object's close result if it was the last
+ * descriptor referring to it.
+ */
+int32_t mo_fd_close(int32_t fd);
+
+int32_t mo_fd_read(int32_t fd, void *buf, uint32_t len);
+int32_t mo_fd_write(int32_t fd, const void *buf, uint32_t len);
+int32_t mo_fd_seek(int32_t fd, int32_t offset, int32_t whence);
+int32_t mo_fd_fstat(int32_t fd, struct stat *st);
@@ -0,0 +1,92 @@
+#pragma once
+
+/* Log-Structured File System
+ *
+ * A flat namespace of up to FS_MAX_FILES files on a block device, built for
+ * append-heavy workloads such as telemetry logs:
+ *   - Data blocks are allocated sequentially from a moving log head, so
+ *     appends from one writer produce contiguous extents and sequential
+ *     device writes.
+ *   - Blocks already committed to the device are never overwritten; changes
+ *     to them are written to new blocks (copy-on-write). Blocks written since
+ *     the last commit are updated in place.
+ *   - All metadata lives in a checkpoint, written alternately to one of two
+ *     fixed areas after the data it references. Mounting picks the newest
+ *     valid checkpoint, so a crash loses at most the changes made since the
+ *     last 'mo_fs_sync()', never the file system.
+ *   - File data goes through a write-back block cache, so an append is a
+ *     memory copy; dirty blocks are written back in batches by a kernel
+ *     task, started at the first mount.
+ *
+ * Functions return a non-negative value on success, or a negative errno
+ * value (e.g. -ENOENT) on failure. Without a mounted file system, functions
+ * taking a name fail with -ENOENT and those taking a handle with -EBADF.
+ * All functions must be called from task context.
+ */
+
+#include <sys/blkdev.h>
+#include <sys/stat.h>
+
+#define FS_MAX_FILES 16    /* Files per file system */
+#define FS_NAME_MAX 23     /* Longest file name, excluding the terminator */
+#define FS_EXTENTS 10      /* Contiguous block runs per file */
+#define FS_MAX_OPEN 8      /* Files open at the same time */
+#define FS_CACHE_BLOCKS 32 /* Block cache size */
+
+/* Dirty cache blocks at which a write wakes the write-back task */
+#define FS_DIRTY_HIGH (FS_CACHE_BLOCKS / 2)
+
+/* File System Control */
+
+/* Mounts the file system on @dev, formatting it first if @format is true.
+ * Returns 0 on success, -EINVAL if @dev holds no valid file system and
+ * @format is false, -EBUSY if a file system is already mounted, or -ENOMEM.
+ */
+int32_t mo_fs_mount(blkdev_t *dev, bool format);
+
+/* Commits all changes and unmounts. Fails with -EBUSY while files are open. */
+int32_t mo_fs_unmount(void);
+
+/* Returns true if a file system is mounted */
+bool mo_fs_mounted(void);
+
+/* Writes back all cached data and commits a new checkpoint */
+int32_t mo_fs_sync(void);
+
+/* File Operations */
+
+/* Opens file @name with O_* @flags (see <sys/fcntl.h>).
+ * Returns a file handle in [0, FS_MAX_OPEN). O_TRUNC fails with -EBUSY while
+ * the file is open elsewhere.
+ */
+int32_t mo_fs_open(const char *name, int32_t flags);
+
+/* Closes @fd. Its changes are committed by the next 'mo_fs_sync()' or
+ * 'mo_fs_unmount()', not here. Returns the error of a failed background
+ * write-back if the file was written and no sync has succeeded since.
+ */
+int32_t mo_fs_close(int32_t fd);
+
+/* Reads up to @len bytes at the file position. Returns the bytes read, 0 at
+ * the end of the file.
+ */
+int32_t mo_fs_read(int32_t fd, void *buf, uint32_t len);
+
+/* Writes @len bytes at the file position (at the end with O_APPEND).
+ * Returns the bytes written, fewer than @len only if the disk filled up.
+ */
+int32_t mo_fs_write(int32_t fd, const void *buf, uint32_t len);
+
+/* Moves the file position; positions past the end are rejected.
+ * Returns the new position.
+ */
+int32_t mo_fs_seek(int32_t fd, int32_t offset, int32_t whence);
+
+/* Fills @st for file @name */
+int32_t mo_fs_stat(const char *name, struct stat *st);
+
+/* Fills @st for the open file @fd */
+int32_t mo_fs_fstat(int32_t fd, struct stat *st);
+
+/* Removes file @name; fails with -EBUSY while it is open */
+int32_t mo_fs_unlink(const char *name);
@@ -0,0 +1,51 @@
+#pragma once
+
+/* Wait-on-Address (Futex-like) Primitive
+ *
+ * Lets tasks block on an arbitrary 32-bit word in memory and be woken by
+ * address. The kernel keeps no per-object state: waiters are kept in a small
+ * hashed table of wait queues keyed by address, so any structure built from
+ * atomics in application memory (flags, counters, lock words) can block and
+ * wake efficiently without a dedicated kernel object.
+ *
+ * Typical use is a compare-and-block loop:
+ *   while (flag == 0)
+ *       mo_wait_on(&flag, 0, 0);
+ * paired with 'flag = 1; mo_wake(&flag, 1);' on the producer side.
+ */
+
+#include <types.h>
+
+/* Pass as @n to 'mo_wake()' to wake every waiter on an address */
+#define WAKE_ALL UINT32_MAX
+
+/* Blocks the calling task on @addr if it still holds @expected.
+ *
+ * The comparison and the enqueue happen atomically with respect to
+ * 'mo_wake()', so a wakeup issued after the value changed cannot be missed.
+ * @addr     : Address of the 32-bit word to wait on (must be non-NULL and
+ *             4-byte aligned)
+ * @expected : Value @addr must hold for the task to block
+ * @timeout  : Maximum ticks to wait, or 0 to wait without a time limit
+ *
+ * Returns ERR_OK when woken by 'mo_wake()', ERR_WAIT_VALUE if @addr did not
+ * hold @expected, ERR_TIMEOUT if the timeout expired, or ERR_FAIL on invalid
+ * arguments. Wakeups may be spurious; callers must re-check their condition.
+ */
+int32_t mo_wait_on(volatile uint32_t *addr,
+                   uint32_t expected,
+                   uint16_t timeout);
+
+/* Wakes up to @n tasks waiting on @addr, oldest first.
+ * @addr : Address passed to 'mo_wait_on()' by the waiters
+ * @n    : Maximum number of tasks to wake (WAKE_ALL for all of them)
+ *
+ * Returns the number of tasks woken, or ERR_FAIL on invalid arguments
+ */
+int32_t mo_wake(volatile uint32_t *addr, uint32_t n);
+
+/* Kernel-internal variant of 'mo_wake()' for callers that already run with
+ * the scheduler disabled (NOSCHED_ENTER), e.g., while walking their own
+ * object lists. @addr must be valid.
+ */
+int32_t _futex_wake(volatile uint32_t *addr, uint32_t n);
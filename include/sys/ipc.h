@@ -0,0 +1,83 @@
+#pragma once
+
+/* Synchronous Call/Reply IPC
+ *
+ * L4-style rendezvous messaging for client/server designs. A client calls a
+ * server task and blocks until the server replies; the server loops in
+ * 'mo_ipc_reply_wait()', answering one caller and receiving the next in a
+ * single operation.
+ *
+ * Compared with a request queue, a reply queue and a semaphore, a call costs
+ * one copy of a small fixed-size message in each direction and two context
+ * switches, both of which go directly to the peer task instead of through
+ * the round-robin scheduler. While serving a call, the server runs at the
+ * caller's priority level if that is higher than its own.
+ *
+ * The scheduler does not order ready tasks by priority, so the donated level
+ * only gives the server the time slice length of that level and lets it
+ * pass preemption thresholds the caller could pass. It does not make the
+ * server run ahead of other ready tasks; only the direct handoff does that.
+ */
+
+#include <types.h>
+
+/* Number of 32-bit message registers carried by each call and reply */
+#define IPC_MSG_WORDS 4
+
+/* Message registers
+ *
+ * Fixed-size payload copied directly between the sender's and receiver's
+ * buffers. Larger data should be passed by reference in the registers.
+ */
+typedef struct {
+    uint32_t w[IPC_MSG_WORDS];
+} ipc_msg_t;
+
+/* Client Operations */
+
+/* Sends a request to a server task and blocks until it replies.
+ *
+ * If the server is already waiting in 'mo_ipc_reply_wait()', the request is
+ * delivered immediately and the CPU is handed straight to the server, which
+ * runs on the caller's priority and the rest of its time slice. Otherwise
+ * the caller queues behind earlier callers of the same server.
+ * @server : Task ID of the server (must not be the calling task)
+ * @msg    : Request message registers (must be non-NULL)
+ * @reply  : Buffer receiving the server's reply (must be non-NULL)
+ *
+ * Returns ERR_OK once the reply has been received, ERR_TASK_NOT_FOUND if no
+ * task has the given ID, or ERR_FAIL on invalid arguments
+ *
+ * Note: The caller stays blocked until the server replies, so a server must
+ *       answer every call it receives.
+ */
+int32_t mo_ipc_call(uint16_t server, const ipc_msg_t *msg, ipc_msg_t *reply);
+
+/* Server Operations */
+
+/* Replies to a client, then waits for the next request.
+ *
+ * The reply completes the client's 'mo_ipc_call()'. If another call is
+ * already queued it is received without blocking; otherwise the server
+ * blocks and the CPU is handed directly to the client just answered,
+ * together with what is left of the time slice.
+ * @client : Task ID of the client to answer, or 0 to only wait
+ * @reply  : Reply message registers (ignored when @client is 0)
+ * @msg    : Buffer receiving the next request (must be non-NULL)
+ *
+ * Returns the task ID of the client whose request was received (pass it as
+ * @client on the next iteration), ERR_IPC_NO_CALL if @client has no call
+ * pending on this server, or ERR_FAIL on invalid arguments
+ */
+int32_t mo_ipc_reply_wait(uint16_t client,
+                          const ipc_msg_t *reply,
+                          ipc_msg_t *msg);
+
+/* Replies to a client without waiting for another request.
+ * @client : Task ID of the client to answer
+ * @reply  : Reply message registers (must be non-NULL)
+ *
+ * Returns ERR_OK on success, ERR_IPC_NO_CALL if @client has no call pending
+ * on this server, or ERR_FAIL on invalid arguments
+ */
+int32_t mo_ipc_reply(uint16_t client, const ipc_msg_t *reply);
@@ -18,7 +18,9 @@ typedef struct {
 
 /* Message queue descriptor structure */
 typedef struct {
-    queue_t *q; /* FIFO queue of (message_t *) pointers */
+    queue_t *q;                /* FIFO queue of (message_t *) pointers */
+    volatile uint32_t seq;     /* Bumped per enqueue; receivers wait on it */
+    volatile uint16_t waiters; /* Tasks blocked in 'mo_mq_recv_many()' */
 } mq_t;
 
 /* Message Queue Management */
@@ -55,6 +57,58 @@ int32_t mo_mq_enqueue(mq_t *mq, message_t *m);
  */
 message_t *mo_mq_dequeue(mq_t *mq);
 
+/* Enqueues several messages under a single critical section.
+ * @mq   : Pointer to message queue (must be valid)
+ * @msgs : Array of @n message pointers, enqueued in array order
+ * @n    : Number of messages to enqueue
+ *
+ * Returns the number of messages enqueued, which is less than @n if the
+ * queue filled up, or ERR_FAIL if the queue is invalid. Blocked receivers
+ * are woken once for the whole batch.
+ */
+int32_t mo_mq_send_many(mq_t *mq, message_t *const *msgs, uint32_t n);
+
+/* Dequeues up to @max messages under a single critical section, blocking
+ * while the queue is empty.
+ * @mq      : Pointer to message queue (must be valid)
+ * @out     : Array receiving up to @max message pointers, oldest first
+ * @max     : Capacity of @out (must be > 0)
+ * @timeout : Maximum ticks to wait for a message, or 0 to wait indefinitely
+ *
+ * Returns the number of messages dequeued (at least 1), ERR_TIMEOUT if the
+ * queue stayed empty, or ERR_FAIL on invalid arguments
+ */
+int32_t mo_mq_recv_many(mq_t *mq,
+                        message_t **out,
+                        uint32_t max,
+                        uint16_t timeout);
+
+/* Passing Packet Buffers by Reference */
+
+/* 'message_t' type value reserved for packet buffers queued by reference */
+#define MQ_TYPE_PBUF 0xFFFF
+
+struct pbuf;
+
+/* Enqueues a packet buffer without copying it. The caller's reference moves
+ * to the queue; take an extra one with 'pbuf_ref()' to keep using the packet
+ * or to queue it on several queues at once.
+ * @mq : Pointer to message queue (must be valid)
+ * @p  : Packet to enqueue (must be valid)
+ *
+ * Returns ERR_OK on success, ERR_FAIL if queue is full or invalid
+ */
+int32_t mo_mq_enqueue_pbuf(mq_t *mq, struct pbuf *p);
+
+/* Dequeues a packet buffer queued with 'mo_mq_enqueue_pbuf()'. The queue's
+ * reference passes to the caller, who must eventually 'pbuf_free()' it.
+ * @mq : Pointer to message queue (must be valid)
+ *
+ * Returns the packet, or NULL if the queue is empty, invalid, or its head
+ * message is not a packet buffer (which is then left in place)
+ */
+struct pbuf *mo_mq_dequeue_pbuf(mq_t *mq);
+
 /* Peeks at the next message without removing it from the queue.
  * @mq : Pointer to message queue (must be valid)
  *
@@ -74,3 +128,78 @@ static inline int32_t mo_mq_items(mq_t *mq)
         return 0;
     return queue_count(mq->q);
 }
+
+/* Inline Fixed-Size Message Queue
+ *
+ * Variant for small fixed-size messages (e.g., 16-64 byte commands). Messages
+ * are copied by value into a contiguous ring allocated together with the
+ * descriptor, so sending and receiving need no per-message allocation and no
+ * pointer indirection: each operation is a single memcpy. Blocking is built
+ * on the wait-on-address primitive. Receivers and senders wait on separate
+ * sequence words, so a wakeup always reaches the side that can make progress.
+ */
+typedef struct {
+    volatile uint32_t count;     /* Messages stored */
+    volatile uint32_t not_empty; /* Bumped per send, receivers wait on it */
+    volatile uint32_t not_full;  /* Bumped per receive, senders wait on it */
+    uint16_t elem_size;          /* Size of every message in bytes */
+    uint16_t capacity;           /* Maximum number of messages */
+    uint16_t head;               /* Slot of the oldest message */
+    uint16_t tail;               /* Slot the next message is written to */
+    uint8_t buf[];               /* capacity * elem_size bytes of storage */
+} mq_fixed_t;
+
+/* Creates an inline message queue.
+ * @elem_size : Size of each message in bytes (must be > 0)
+ * @capacity  : Maximum number of messages the queue can hold (must be > 0)
+ *
+ * Returns pointer to new queue on success, NULL on failure
+ */
+mq_fixed_t *mo_mq_fixed_create(uint16_t elem_size, uint16_t capacity);
+
+/* Destroys an inline message queue.
+ * @mq : Pointer to queue (NULL is safe no-op)
+ *
+ * Returns ERR_OK on success, ERR_MQ_NOTEMPTY if messages are still queued
+ */
+int32_t mo_mq_fixed_destroy(mq_fixed_t *mq);
+
+/* Copies a message into the queue, blocking while it is full.
+ * @mq      : Pointer to queue (must be valid)
+ * @msg     : Message of 'elem_size' bytes to copy in (must be valid)
+ * @timeout : Maximum ticks to wait for space, or 0 to wait indefinitely
+ *
+ * Returns ERR_OK on success, ERR_TIMEOUT if no space became available in
+ * time, or ERR_FAIL on invalid arguments
+ */
+int32_t mo_mq_fixed_send(mq_fixed_t *mq, const void *msg, uint16_t timeout);
+
+/* Copies the oldest message out of the queue, blocking while it is empty.
+ * @mq      : Pointer to queue (must be valid)
+ * @msg     : Buffer of 'elem_size' bytes receiving the message (must be valid)
+ * @timeout : Maximum ticks to wait for a message, or 0 to wait indefinitely
+ *
+ * Returns ERR_OK on success, ERR_TIMEOUT if no message arrived in time, or
+ * ERR_FAIL on invalid arguments
+ */
+int32_t mo_mq_fixed_recv(mq_fixed_t *mq, void *msg, uint16_t timeout);
+
+/* Non-blocking variants of send and receive.
+ *
+ * Return ERR_OK on success, or ERR_FAIL if the queue is full (send), empty
+ * (receive), or invalid
+ */
+int32_t mo_mq_fixed_trysend(mq_fixed_t *mq, const void *msg);
+int32_t mo_mq_fixed_tryrecv(mq_fixed_t *mq, void *msg);
+
+/* Gets the current number of messages in an inline queue.
+ * @mq : Pointer to queue
+ *
+ * Returns number of queued messages, or 0 if queue is invalid/empty
+ */
+static inline int32_t mo_mq_fixed_items(mq_fixed_t *mq)
+{
+    if (unlikely(!mq))
+        return 0;
+    return mq->count;
+}
@@ -12,6 +12,24 @@
 /* Magic number for pipe validation and corruption detection */
 #define PIPE_MAGIC 0x50495045 /* "PIPE" */
 
+/* Largest write guaranteed to be atomic: a blocking write of at most this
+ * many bytes (and at most the pipe capacity) is never interleaved with data
+ * from other writers. Can be overridden at build time.
+ */
+#ifndef PIPE_BUF
+#define PIPE_BUF 128
+#endif
+
+/* Pipe Modes */
+typedef enum {
+    PIPE_MODE_STREAM = 0, /* Byte stream (default) */
+    PIPE_MODE_RECORD = 1  /* Message boundaries preserved */
+} pipe_mode_t;
+
+/* Per-record framing overhead in record mode (16-bit length prefix) */
+#define PIPE_RECORD_HDR 2
+#define PIPE_RECORD_MAX UINT16_MAX /* Largest record payload */
+
 /* Pipe descriptor structure
  *
  * The circular buffer uses head/tail indices with power-of-2 masking
@@ -20,22 +38,29 @@
  */
 typedef struct {
     char *buf;              /* Data buffer (power-of-2 size) */
-    uint16_t mask;          /* Capacity - 1 (for efficient modulo) */
-    volatile uint16_t head; /* Read index (consumer position) */
-    volatile uint16_t tail; /* Write index (producer position) */
-    volatile uint16_t used; /* Bytes currently stored (0 to capacity) */
+    uint32_t mask;          /* Capacity - 1 (for efficient modulo) */
+    volatile uint32_t head; /* Read index (consumer position) */
+    volatile uint32_t tail; /* Write index (producer position) */
+    volatile uint32_t used; /* Bytes currently stored (0 to capacity) */
+    uint8_t mode;           /* Framing mode (from pipe_mode_t) */
     uint32_t magic;         /* Magic number for validation */
 } pipe_t;
 
+/* Scatter/gather buffer descriptor for 'mo_pipe_readv()'/'mo_pipe_writev()' */
+struct iovec {
+    void *iov_base;   /* Start of the buffer */
+    uint32_t iov_len; /* Length of the buffer in bytes */
+};
+
 /* Pipe Management Functions */
 
 /* Create a new pipe with specified buffer size.
  * @size : Desired buffer size (will be rounded up to next power-of-2)
  *
  * Returns pointer to new pipe on success, NULL on failure
- * Note: Minimum size is 2 bytes, maximum is 32768 bytes
+ * Note: Minimum size is 4 bytes, maximum is 1 GiB (memory permitting)
  */
-pipe_t *mo_pipe_create(uint16_t size);
+pipe_t *mo_pipe_create(uint32_t size);
 
 /* Destroy a pipe and free its resources.
  * @pipe : Pointer to pipe structure (NULL is safe no-op)
@@ -46,6 +71,20 @@ int32_t mo_pipe_destroy(pipe_t *pipe);
 
 /* Pipe Status and Control Operations */
 
+/* Select stream or record framing.
+ *
+ * In record mode every write is one record, stored with a length prefix and
+ * written atomically, and every read returns exactly one record, so records
+ * from concurrent writers never interleave or merge. A record longer than
+ * the reader's buffer is truncated and its remainder discarded.
+ * @pipe : Pointer to pipe structure (must be valid and empty)
+ * @mode : PIPE_MODE_STREAM or PIPE_MODE_RECORD
+ *
+ * Returns ERR_OK on success, ERR_FAIL if the pipe is invalid, not empty, or
+ * the mode is unknown
+ */
+int32_t mo_pipe_set_mode(pipe_t *pipe, uint8_t mode);
+
 /* Flush all data from the pipe (reset to empty state).
  * @pipe : Pointer to pipe structure (must be valid)
  */
@@ -80,9 +119,11 @@ int32_t mo_pipe_free_space(pipe_t *pipe);
  * @size : Number of bytes to read (must be > 0)
  *
  * Returns number of bytes read (equals size on success), negative on error
- * Note: This function will block until all requested data is available
+ * Note: This function will block until all requested data is available. In
+ *       record mode it instead blocks until one record is available and
+ *       returns its length, truncated to @size.
  */
-int32_t mo_pipe_read(pipe_t *pipe, char *data, uint16_t size);
+int32_t mo_pipe_read(pipe_t *pipe, char *data, uint32_t size);
 
 /* Write data to pipe, blocking until all data is written.
  * @pipe : Pointer to pipe structure (must be valid)
@@ -90,9 +131,30 @@ int32_t mo_pipe_read(pipe_t *pipe, char *data, uint16_t size);
  * @size : Number of bytes to write (must be > 0)
  *
  * Returns number of bytes written (equals size on success), negative on error
- * Note: This function will block until all data can be written
+ * Note: This function will block until all data can be written. Writes of up
+ *       to PIPE_BUF bytes wait for enough space and are written at once, so
+ *       they never interleave with other writers. In record mode every write
+ *       is atomic and fails if the framed record exceeds the capacity or
+ *       PIPE_RECORD_MAX.
+ */
+int32_t mo_pipe_write(pipe_t *pipe, const char *data, uint32_t size);
+
+/* Scatter/gather variants of 'mo_pipe_read()' and 'mo_pipe_write()'.
+ *
+ * Move the concatenation of @iovcnt buffers, filling or draining as many of
+ * them as possible per critical section, so a header and a payload kept in
+ * separate buffers need no assembly copy. A gathered write totalling at most
+ * PIPE_BUF bytes is atomic; in record mode it forms a single record, and a
+ * scattered read spreads a single record over the buffers.
+ * @pipe   : Pointer to pipe structure (must be valid)
+ * @iov    : Array of buffer descriptors (must be non-NULL)
+ * @iovcnt : Number of descriptors (must be > 0)
+ *
+ * Returns the total bytes moved (as the non-vectored calls), negative on
+ * error
  */
-int32_t mo_pipe_write(pipe_t *pipe, const char *data, uint16_t size);
+int32_t mo_pipe_readv(pipe_t *pipe, const struct iovec *iov, int iovcnt);
+int32_t mo_pipe_writev(pipe_t *pipe, const struct iovec *iov, int iovcnt);
 
 /* Non-blocking I/O Operations (returns immediately with partial results) */
 
@@ -102,9 +164,10 @@ int32_t mo_pipe_write(pipe_t *pipe, const char *data, uint16_t size);
  * @size : Maximum number of bytes to read
  *
  * Returns number of bytes actually read (0 to size), negative on error
- * Note: Returns immediately even if no data is available
+ * Note: Returns immediately even if no data is available. In record mode,
+ *       reads one record if available, as 'mo_pipe_read()' does.
  */
-int32_t mo_pipe_nbread(pipe_t *pipe, char *data, uint16_t size);
+int32_t mo_pipe_nbread(pipe_t *pipe, char *data, uint32_t size);
 
 /* Write data to pipe without blocking.
  * @pipe : Pointer to pipe structure (must be valid)
@@ -112,6 +175,35 @@ int32_t mo_pipe_nbread(pipe_t *pipe, char *data, uint16_t size);
  * @size : Number of bytes to write
  *
  * Returns number of bytes actually written (0 to size), negative on error
- * Note: Returns immediately even if no space is available
+ * Note: Returns immediately even if no space is available. In record mode,
+ *       the record is written whole or not at all (returning 0), and a
+ *       record too large to ever fit the pipe fails.
+ */
+int32_t mo_pipe_nbwrite(pipe_t *pipe, const char *data, uint32_t size);
+
+/* Packet Buffer I/O (runs in task context only) */
+
+struct pbuf;
+
+/* Write a packet chain to the pipe by gathering its segments, without first
+ * linearizing it into a bounce buffer. Blocks until all bytes are written.
+ * A chain of up to PIPE_BUF bytes is written as one unit, never interleaved
+ * with other writers.
+ * @pipe : Pointer to pipe structure (must be valid)
+ * @p    : Packet to write (must be non-NULL; the caller keeps its reference)
+ *
+ * Returns number of bytes written (the packet's tot_len), negative on error
+ * Note: Stream mode only; fails on a pipe in record mode
+ */
+int32_t mo_pipe_write_pbuf(pipe_t *pipe, const struct pbuf *p);
+
+/* Read from the pipe directly into the payload of a packet chain, filling
+ * its segments in order. Blocks until @size bytes have been read.
+ * @pipe : Pointer to pipe structure (must be valid)
+ * @p    : Packet to fill (must be non-NULL)
+ * @size : Number of bytes to read (must be > 0 and <= the packet's tot_len)
+ *
+ * Returns number of bytes read (equals size on success), negative on error
+ * Note: Stream mode only; fails on a pipe in record mode
  */
-int32_t mo_pipe_nbwrite(pipe_t *pipe, const char *data, uint16_t size);
+int32_t mo_pipe_read_pbuf(pipe_t *pipe, struct pbuf *p, uint32_t size);
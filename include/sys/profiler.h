@@ -0,0 +1,58 @@
+#pragma once
+
+/* Statistical PC-Sampling Profiler
+ *
+ * While running, a sampling timer independent of the scheduler tick
+ * interrupts the CPU at a fixed rate and records the ID of the current task
+ * together with the interrupted program counter into a RAM ring buffer. The
+ * dump is printed in a line-oriented format that 'scripts/profile.py'
+ * symbolizes against build/image.elf into a flat profile and a per-task
+ * breakdown.
+ *
+ * Sampling happens in the timer trap, so code running with the timer
+ * interrupt masked (NOSCHED or CRITICAL sections) is charged to the point
+ * where the interrupt is unmasked again.
+ *
+ * The profiler is only built when CONFIG_PROFILER is non-zero (make
+ * PROFILER=1); otherwise all operations fail with ERR_FAIL.
+ */
+
+#include <types.h>
+
+/* Number of samples retained; older samples are overwritten when full */
+#ifndef PROF_SAMPLES
+#define PROF_SAMPLES 1024
+#endif
+
+/* Highest accepted sampling rate, bounding the trap overhead */
+#define PROF_MAX_HZ (F_CPU / 1000)
+
+/* Starts sampling, discarding any samples from a previous run.
+ * @hz : Sampling rate in Hz (1 to PROF_MAX_HZ)
+ *
+ * Returns ERR_OK on success, or ERR_FAIL if the rate is out of range or the
+ * profiler is not built in
+ */
+int32_t mo_prof_start(uint32_t hz);
+
+/* Stops sampling, keeping the recorded samples for 'mo_prof_dump()'.
+ *
+ * Returns ERR_OK on success, or ERR_FAIL if the profiler is not built in
+ */
+int32_t mo_prof_stop(void);
+
+/* Returns the number of samples taken since the last start, including
+ * samples that were overwritten.
+ */
+uint32_t mo_prof_count(void);
+
+/* Stops sampling and prints the recorded samples to stdout, oldest first:
+ *
+ *   PROF BEGIN <hz> <retained> <lost>
+ *   PROF <task id> <pc in hex>
+ *   ...
+ *   PROF END
+ *
+ * Returns ERR_OK on success, or ERR_FAIL if the profiler is not built in
+ */
+int32_t mo_prof_dump(void);
@@ -0,0 +1,204 @@
+#pragma once
+
+/* Protothreads: Stackless Fibers
+ *
+ * A protothread is a function that can block without a stack of its own.
+ * Every blocking point records where to resume and returns; the next call
+ * jumps back there through a 'switch' on the recorded line. Many
+ * protothreads share one host task and its stack, so each costs only its
+ * 'pt_t' (a few words), not a task with a stack, an ISR frame reserve and a
+ * TCB. They suit small state machines: blinkers, debouncers, protocol
+ * handlers.
+ *
+ * Rules that follow from having no stack:
+ *   - Local variables do not survive a blocking point. Keep state in a
+ *     structure reachable from 'pt->arg', or in statics.
+ *   - Blocking macros may only be used in the protothread function itself,
+ *     not in functions it calls, and not inside a 'switch' statement.
+ *     Resume points are source lines, so at most one per line.
+ *   - Blocking means returning to the runner, so a protothread must never
+ *     call a blocking kernel function (e.g. 'mo_sem_wait()'); the PT_* waits
+ *     below use the non-blocking variants and retry on the next round.
+ *
+ * Example:
+ *   static int8_t blink(pt_t *pt)
+ *   {
+ *       PT_BEGIN(pt);
+ *       while (1) {
+ *           led_toggle((uint32_t) pt->arg);
+ *           PT_SLEEP(pt, 50);
+ *       }
+ *       PT_END(pt);
+ *   }
+ */
+
+#include <types.h>
+#include <sys/pipe.h>
+#include <sys/semaphore.h>
+#include <sys/task.h>
+
+/* Protothread function results, as seen by the runner */
+#define PT_WAITING 0  /* Blocked on a condition: poll it again next round */
+#define PT_YIELDED 1  /* Gave way to the others, runnable */
+#define PT_SLEEPING 2 /* Not to be run before 'deadline' */
+#define PT_EXITED 3   /* Finished: removed from its runner */
+
+typedef struct pt pt_t;
+typedef int8_t (*pt_fn_t)(pt_t *pt);
+
+struct pt {
+    uint16_t lc;       /* Resume point: source line, 0 at the start */
+    int8_t state;      /* Last PT_* result */
+    bool flag;         /* True if the last timed wait timed out or the last
+                        * pipe write failed */
+    uint32_t deadline; /* Tick at which a sleep or timeout ends */
+    pt_fn_t fn;
+    void *arg; /* Protothread state, for the function's use */
+    pt_t *next;
+};
+
+/* A set of protothreads driven by one task */
+typedef struct {
+    pt_t *head;
+    uint32_t count; /* Protothreads not yet exited */
+} pt_runner_t;
+
+/* Protothread Body */
+
+#define PT_BEGIN(pt)    \
+    switch ((pt)->lc) { \
+    case 0:
+
+#define PT_END(pt)   \
+    }                \
+    (pt)->lc = 0;    \
+    return PT_EXITED
+
+/* Returns @result now and resumes after this point on the next call */
+#define PT_RESUME_POINT(pt, result) \
+    do {                            \
+        (pt)->lc = __LINE__;        \
+        return (result);            \
+    case __LINE__:;                 \
+    } while (0)
+
+/* Blocks until @cond is true, evaluating it once per round */
+#define PT_WAIT_UNTIL(pt, cond) \
+    do {                        \
+        (pt)->lc = __LINE__;    \
+    case __LINE__:              \
+        if (!(cond))            \
+            return PT_WAITING;  \
+    } while (0)
+
+#define PT_WAIT_WHILE(pt, cond) PT_WAIT_UNTIL(pt, !(cond))
+
+/* Lets the other protothreads of the runner run once */
+#define PT_YIELD(pt) PT_RESUME_POINT(pt, PT_YIELDED)
+
+/* Finishes the protothread from anywhere in its body */
+#define PT_EXIT(pt)       \
+    do {                  \
+        (pt)->lc = 0;     \
+        return PT_EXITED; \
+    } while (0)
+
+/* Timing */
+
+/* True once the tick @deadline has passed, robust to tick wrap-around */
+#define PT_EXPIRED(deadline) ((int32_t) (mo_ticks() - (deadline)) >= 0)
+
+/* Sleeps for @ticks system ticks. The runner does not call a sleeping
+ * protothread at all, and sleeps itself when all of its protothreads do.
+ */
+#define PT_SLEEP(pt, ticks)                    \
+    do {                                       \
+        (pt)->deadline = mo_ticks() + (ticks); \
+        PT_RESUME_POINT(pt, PT_SLEEPING);      \
+    } while (0)
+
+/* Blocks until @cond is true or @ticks have passed; 'PT_TIMED_OUT()' then
+ * tells which. @cond is not evaluated again after it was found true.
+ */
+#define PT_WAIT_TIMEOUT(pt, cond, ticks)                   \
+    do {                                                   \
+        (pt)->deadline = mo_ticks() + (ticks);             \
+        PT_WAIT_UNTIL(pt, !((pt)->flag = !(cond)) ||       \
+                              PT_EXPIRED((pt)->deadline)); \
+    } while (0)
+
+#define PT_TIMED_OUT(pt) ((pt)->flag)
+
+/* Kernel Objects */
+
+/* Takes a token of semaphore @sem */
+#define PT_SEM_WAIT(pt, sem) PT_WAIT_UNTIL(pt, mo_sem_trywait(sem) == 0)
+
+/* Takes a token of @sem, giving up after @ticks (see 'PT_TIMED_OUT()') */
+#define PT_SEM_WAIT_TIMEOUT(pt, sem, ticks)              \
+    PT_WAIT_TIMEOUT(pt, mo_sem_trywait(sem) == 0, ticks)
+
+/* Reads what @pipe holds, up to @len bytes, once it holds anything, and
+ * stores the count in the lvalue @n (which must survive blocking).
+ */
+#define PT_PIPE_READ(pt, pipe, buf, len, n)                       \
+    PT_WAIT_UNTIL(pt, ((n) = mo_pipe_nbread(pipe, buf, len)) > 0)
+
+/* Writes all @len bytes to @pipe at once, once it has room for them.
+ * In record mode the record header needs room too. A write that can never
+ * fit the pipe, whether a stream longer than its capacity or a record too
+ * large, fails at once without writing anything; 'PT_PIPE_FAILED()' tells.
+ * A stream write can only be split by writers in other tasks, never by
+ * other protothreads.
+ */
+#define PT_PIPE_WRITE(pt, pipe, buf, len) \
+    PT_WAIT_UNTIL(pt, pt_pipe_trywrite(pipe, buf, len, &(pt)->flag))
+
+#define PT_PIPE_FAILED(pt) ((pt)->flag)
+
+/* Helper for PT_PIPE_WRITE: true once the write is done or has failed,
+ * storing in @failed which of the two.
+ */
+static inline bool pt_pipe_trywrite(pipe_t *pipe,
+                                    const void *buf,
+                                    uint32_t len,
+                                    bool *failed)
+{
+    *failed = false;
+
+    /* Stream writes would go in partially; records go in whole or not */
+    if (pipe->mode == PIPE_MODE_STREAM) {
+        if (len > (uint32_t) mo_pipe_capacity(pipe)) {
+            *failed = true;
+            return true;
+        }
+        if (mo_pipe_free_space(pipe) < (int32_t) len)
+            return false;
+    }
+
+    int32_t n = mo_pipe_nbwrite(pipe, buf, len);
+    *failed = n < 0;
+    return n != 0;
+}
+
+/* Runner */
+
+/* Prepares @pt to run @fn from the start with @arg */
+void mo_pt_init(pt_t *pt, pt_fn_t fn, void *arg);
+
+/* Adds the initialized @pt to @runner. Must be called from the task that
+ * runs @runner (a protothread may add others), or before it starts.
+ * Returns 0, or ERR_FAIL for invalid arguments.
+ */
+int32_t mo_pt_add(pt_runner_t *runner, pt_t *pt);
+
+/* Runs every runnable protothread of @runner once, dropping those that
+ * exit. Returns how many are left.
+ */
+uint32_t mo_pt_poll(pt_runner_t *runner);
+
+/* Polls @runner until all its protothreads have exited. Between rounds the
+ * task yields the CPU, or sleeps until the earliest deadline when every
+ * protothread is sleeping.
+ */
+void mo_pt_run(pt_runner_t *runner);
@@ -34,7 +34,9 @@
     _(mknod, 18, int, (const char *path, int mode, int dev)) \
     _(unlink, 19, int, (char *name))                         \
     _(link, 20, int, (char *old, char *new))                 \
-    /* 21-31 reserved for future POSIX extensions */         \
+    _(fstat, 21, int, (int fd, struct stat *st))             \
+    _(isatty, 22, int, (int fd))                             \
+    /* 23-31 reserved for future POSIX extensions */         \
                                                              \
     /* Linmo-specific system calls (32+) */                  \
     _(tadd, 32, int, (void *task, int stack_sz))             \
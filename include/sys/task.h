@@ -59,6 +59,25 @@ enum task_states {
 #define TASK_TIMESLICE_LOW 10     /* Low priority: longer slice */
 #define TASK_TIMESLICE_IDLE 15    /* Idle tasks: longest slice */
 
+/* Per-task Performance Counters
+ *
+ * Clock cycles and retired instructions are virtualized for every task:
+ * counts are charged to the task that was running on each context switch.
+ * Up to TASK_PERF_EVENTS programmable counters can additionally be bound
+ * with 'mo_task_perf_event()'.
+ */
+#define TASK_PERF_EVENTS 2
+#define TASK_PERF_COUNTERS (2 + TASK_PERF_EVENTS)
+
+/* Snapshot of a task's virtualized counters, see 'mo_task_perf()' */
+typedef struct {
+    uint64_t cycles;                   /* Clock cycles spent running */
+    uint64_t instret;                  /* Instructions retired */
+    uint64_t events[TASK_PERF_EVENTS]; /* Bound programmable counters */
+    uint32_t ipc_milli;                /* Instructions per 1000 cycles */
+    uint32_t cpi_milli;                /* Cycles per 1000 instructions */
+} task_perf_t;
+
 /* Task Control Block (TCB)
  *
  * Contains all essential information about a single task, including saved
@@ -80,6 +99,27 @@ typedef struct tcb {
     uint16_t id;        /* Unique task ID, assigned by kernel upon creation */
     uint8_t state;      /* Current lifecycle state (e.g., TASK_READY) */
     uint8_t flags;      /* Task flags for future extensions (reserved) */
+    uint8_t sched_lock; /* Scheduler lock nesting depth held by this task */
+
+    /* Preemption Threshold Support */
+    uint8_t preempt_threshold; /* Level a tick preemptor must be above */
+
+    /* CPU Budget Support */
+    uint16_t budget;        /* Ticks of CPU per period, 0 = unlimited */
+    uint16_t budget_used;   /* Ticks consumed in the current period */
+    uint16_t budget_period; /* Replenishment period in ticks */
+    uint32_t budget_start;  /* Tick at which the current period began */
+
+    /* Delay Slack Support */
+    uint16_t delay_slack; /* Extra ticks a pending delay may be stretched */
+
+    /* Performance Counter Support */
+    uint64_t perf[TASK_PERF_COUNTERS]; /* Counts accrued while running */
+
+#if HAL_HAS_FP
+    /* Lazy FP Context Support */
+    hal_fp_context_t fp; /* FP registers, saved while another task owns them */
+#endif
 
     /* Real-time Scheduling Support */
     void *rt_prio; /* Opaque pointer for custom real-time scheduler hook */
@@ -102,6 +142,9 @@ typedef struct {
     uint16_t task_count; /* Cached count of active tasks for quick access */
     bool preemptive;     /* true = preemptive; false = cooperative */
 
+    /* Scheduler Lock Support */
+    volatile bool sched_pending; /* Switch deferred while a task held lock */
+
     /* Real-Time Scheduler Hook */
     int32_t (*rt_sched)(void); /* Custom real-time scheduler function */
 
@@ -207,12 +250,35 @@ int32_t mo_task_cancel(uint16_t id);
 /* Voluntarily yields the CPU, allowing the scheduler to run another task */
 void mo_task_yield(void);
 
+/* Yields the CPU directly to a specific task.
+ *
+ * If the target is READY it runs next, skipping the tasks round-robin would
+ * have picked first; otherwise this behaves like 'mo_task_yield()'. The
+ * rotation later resumes from the caller's position, so the skipped tasks
+ * keep their turn.
+ * @id : The ID of the task to switch to
+ *
+ * Returns ERR_OK after the caller is scheduled again, or ERR_TASK_NOT_FOUND
+ */
+int32_t mo_task_yield_to(uint16_t id);
+
 /* Blocks the current task for a specified number of system ticks.
  * @ticks : The number of system ticks to sleep. The task will be unblocked
  *          after this duration has passed.
  */
 void mo_task_delay(uint16_t ticks);
 
+/* Blocks the current task for a number of ticks, with a tolerance.
+ *
+ * Like 'mo_task_delay()', but the task may be woken anywhere from @ticks to
+ * @ticks + @slack ticks later. Within that window the wakeup is held back
+ * until some other delayed task wakes for sure, and both are made ready in
+ * the same tick, reducing the number of ticks on which tasks are woken.
+ * @ticks : The minimum number of system ticks to sleep
+ * @slack : The additional ticks the wakeup may be deferred by
+ */
+void mo_task_delay_slack(uint16_t ticks, uint16_t slack);
+
 /* Suspends a task, removing it from scheduling temporarily.
  * @id : The ID of the task to suspend. A task can suspend itself.
  *
@@ -227,6 +293,30 @@ int32_t mo_task_suspend(uint16_t id);
  */
 int32_t mo_task_resume(uint16_t id);
 
+/* Scheduler Lock
+ *
+ * Defers preemption without masking interrupts. While the running task holds
+ * the lock, timer ticks, wakeups and explicit yields still update task states
+ * (delays expire, waiters become ready), but no context switch happens. The
+ * outermost unlock performs a single reschedule if any switch was deferred.
+ *
+ * The lock belongs to the task that takes it: if that task blocks, the lock
+ * is suspended along with it and reinstated when the task runs again.
+ */
+
+/* Locks the scheduler for the current task. Calls nest up to 255 levels;
+ * exceeding that is a programming error and panics.
+ */
+void mo_sched_lock(void);
+
+/* Releases one level of the scheduler lock taken by mo_sched_lock().
+ * When the outermost level is released and a reschedule was deferred while
+ * locked, the CPU is yielded once.
+ *
+ * Returns ERR_OK on success, or ERR_SCHED_LOCK if the scheduler was not locked
+ */
+int32_t mo_sched_unlock(void);
+
 /* Task Priority Management */
 
 /* Changes a task's base priority.
@@ -237,6 +327,38 @@ int32_t mo_task_resume(uint16_t id);
  */
 int32_t mo_task_priority(uint16_t id, uint16_t priority);
 
+/* Sets a task's preemption threshold (ThreadX-style).
+ *
+ * On a timer tick, a task with a raised threshold is only preempted by a
+ * ready task whose priority is strictly higher than the threshold, and the
+ * CPU then goes to the highest such task; other tasks wait until it yields
+ * or blocks. Tasks sharing a threshold therefore
+ * never preempt each other, which cuts context switches within cooperating
+ * groups. Voluntary yields and blocking are unaffected.
+ * @id        : The ID of the task to modify
+ * @threshold : A priority value (from enum task_priorities) equal to or
+ *              higher than the task's own priority. Passing the task's own
+ *              priority disables the threshold.
+ *
+ * Returns 0 on success, or a negative error code
+ */
+int32_t mo_task_preempt_threshold(uint16_t id, uint16_t threshold);
+
+/* Limits the CPU time a task may consume (deferrable-server semantics).
+ *
+ * The task may run for @budget timer ticks in every window of @period ticks.
+ * Once the budget is spent the task is throttled (blocked) until the next
+ * window begins and the budget is replenished; unused budget does not carry
+ * over. Only ticks during which the task is running are charged. Throttling
+ * is postponed while the task holds the scheduler lock.
+ * @id     : The ID of the task to modify
+ * @budget : Ticks per period, or 0 to remove the limit
+ * @period : Replenishment period in ticks (>= @budget, < UINT16_MAX)
+ *
+ * Returns 0 on success, or a negative error code
+ */
+int32_t mo_task_budget(uint16_t id, uint16_t budget, uint16_t period);
+
 /* Assigns a task to a custom real-time scheduler.
  * @id       : The ID of the task to modify
  * @priority : Opaque pointer to custom priority data for the RT scheduler
@@ -266,6 +388,28 @@ void mo_task_wfi(void);
 /* Gets the total number of active tasks in the system */
 uint16_t mo_task_count(void);
 
+/* Reads a task's virtualized performance counters.
+ * @id   : The ID of the task to query
+ * @perf : Receives the counters and derived IPC/CPI (must be non-NULL)
+ *
+ * The IPC and CPI fields are 0 while their divisor is still 0.
+ *
+ * Returns 0 on success, or a negative error code
+ */
+int32_t mo_task_perf(uint16_t id, task_perf_t *perf);
+
+/* Binds a programmable hardware counter to a per-task event slot.
+ * @slot    : Event slot, 0 to TASK_PERF_EVENTS - 1
+ * @counter : HPM counter index (HAL_PERF_HPM_FIRST to HAL_PERF_HPM_LAST), or
+ *            0 to unbind the slot
+ * @event   : Implementation-defined 'mhpmevent' selector for @counter
+ *
+ * The slot's count is reset to zero for every task.
+ *
+ * Returns 0 on success, or ERR_FAIL on invalid arguments
+ */
+int32_t mo_task_perf_event(uint8_t slot, uint32_t counter, uint32_t event);
+
 /* System Time Functions */
 
 /* Gets the current value of the system tick counter */
@@ -288,6 +432,56 @@ uint64_t mo_uptime(void);
  */
 void _sched_block(queue_t *wait_q);
 
+/* Looks up a task by ID.
+ * Must be called from within a NOSCHED or CRITICAL section, since the task
+ * may otherwise be cancelled under the caller.
+ * @id : The ID of the task to find
+ *
+ * Returns the task's control block, or NULL if no task has that ID
+ */
+tcb_t *_task_lookup(uint16_t id);
+
+/* Yields the CPU directly to a specific task.
+ *
+ * Like '_yield()', but if @target is READY when the switch happens the
+ * scheduler skips its selection and runs @target next. Otherwise it falls
+ * back to the normal scheduling decision. The caller sets its own state
+ * (e.g., TASK_BLOCKED) beforehand, exactly as with '_sched_block()'. A
+ * caller that blocks hands @target the rest of its time slice; otherwise
+ * @target starts a fresh one.
+ *
+ * @target : The task that should run next
+ */
+void _sched_yield_to(tcb_t *target);
+
+/* Readies @task, blocked waiting for a device, from an interrupt handler,
+ * and asks for a switch to it once the interrupt handlers are done. Without
+ * this a task woken by an interrupt would wait for the next tick to run.
+ * Only the last task woken in one interrupt gets the direct switch; others
+ * wait for their round-robin turn as usual.
+ */
+void _sched_wakeup_irq(tcb_t *task);
+
+/* Called by the architecture on the way out of a device or software
+ * interrupt, with the interrupted task's full frame saved and preemption not
+ * masked: switches to the task '_sched_wakeup_irq()' readied. As with a
+ * tick, the scheduler lock defers the switch to the unlock, and a raised
+ * preemption threshold the woken task is not above holds it off.
+ */
+void _sched_irq_exit(void);
+
+/* Starts per-task counter accounting; called once before the first task runs
+ * so that boot time is not charged to it.
+ */
+void _task_perf_init(void);
+
+/* Lends the priority level of @donor to @task if it is higher, so that work
+ * done on behalf of @donor (e.g., serving an IPC call) runs at its priority.
+ * '_sched_donate_end()' restores the task's own base priority level.
+ */
+void _sched_donate(tcb_t *task, const tcb_t *donor);
+void _sched_donate_end(tcb_t *task);
+
 /* Application Entry Point */
 
 /* The main entry point for the user application.
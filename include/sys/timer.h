@@ -26,7 +26,8 @@ typedef enum {
 typedef struct {
     /* Timing Parameters */
     uint32_t deadline_ticks; /* Expiration time in absolute system ticks */
-    uint32_t period_ms;      /* Reload period in milliseconds */
+    uint32_t period_ticks;   /* Reload period in system ticks */
+    uint32_t slack_ticks;    /* Ticks the expiry may be deferred to batch */
 
     /* Timer Identification and State */
     uint16_t id;       /* Unique handle assigned by the kernel */
@@ -55,6 +56,21 @@ int32_t mo_timer_create(void *(*callback)(void *arg),
                         uint32_t period_ms,
                         void *arg);
 
+/* Creates a new software timer with a period given in system ticks.
+ *
+ * Same as 'mo_timer_create()', but the period is used as is, avoiding the
+ * millisecond conversion and its rounding.
+ *
+ * @callback     : The function to execute upon expiry (cannot be NULL)
+ * @period_ticks : The timer's period in system ticks (must be > 0)
+ * @arg          : A user-defined argument to be passed to the callback
+ *
+ * Returns a positive timer ID on success, or a negative error code on failure
+ */
+int32_t mo_timer_create_ticks(void *(*callback)(void *arg),
+                              uint32_t period_ticks,
+                              void *arg);
+
 /* Destroys a software timer and frees its resources.
  *
  * If the timer is active, it will be cancelled before being destroyed.
@@ -72,7 +88,8 @@ int32_t mo_timer_destroy(uint16_t id);
  *
  * This function arms the timer and adds it to the active list. If the timer
  * was already running, its deadline is recalculated and it is rescheduled.
- * The timer will fire after its configured period has elapsed.
+ * The timer will fire after its configured period has elapsed; auto-reload
+ * timers then fire every period, measured from the previous deadline.
  *
  * @id   : The ID of the timer to start
  * @mode : The desired mode (TIMER_ONESHOT or TIMER_AUTORELOAD)
@@ -81,6 +98,21 @@ int32_t mo_timer_destroy(uint16_t id);
  */
 int32_t mo_timer_start(uint16_t id, uint8_t mode);
 
+/* Starts or restarts a software timer at an absolute tick.
+ *
+ * The first expiry happens at @abs_tick (immediately on the next tick if it
+ * has already passed). Auto-reload timers then fire at @abs_tick plus whole
+ * multiples of their period, so timers started against a common base tick
+ * stay phase-aligned with each other.
+ *
+ * @id       : The ID of the timer to start
+ * @abs_tick : The system tick (see 'mo_ticks()') of the first expiry
+ * @mode     : The desired mode (TIMER_ONESHOT or TIMER_AUTORELOAD)
+ *
+ * Returns ERR_OK on success, or ERR_FAIL if the ID or mode is invalid
+ */
+int32_t mo_timer_start_at(uint16_t id, uint32_t abs_tick, uint8_t mode);
+
 /* Cancels a running software timer.
  *
  * This function disarms the timer and removes it from the active list. The
@@ -94,6 +126,20 @@ int32_t mo_timer_start(uint16_t id, uint8_t mode);
  */
 int32_t mo_timer_cancel(uint16_t id);
 
+/* Sets the slack window of a software timer.
+ *
+ * A timer with slack may fire anywhere between its deadline and the deadline
+ * plus the slack. Within that window it is held back until another timer is
+ * strictly due, and then fires in the same tick, so that periodic activities
+ * with loose timing share wakeups instead of scattering them across ticks.
+ *
+ * @id       : The ID of the timer to configure
+ * @slack_ms : Tolerated lateness in milliseconds (0 = fire exactly on time)
+ *
+ * Returns ERR_OK on success, or ERR_FAIL if the ID is not found
+ */
+int32_t mo_timer_set_slack(uint16_t id, uint32_t slack_ms);
+
 /* Timer Utility Macros */
 
 /* Convert milliseconds to system ticks.
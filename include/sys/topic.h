@@ -0,0 +1,122 @@
+#pragma once
+
+/* Publish/Subscribe Topic Bus
+ *
+ * One-to-many message distribution with zero-copy fan-out. A publisher fills
+ * a reference-counted buffer and publishes it on a topic; every subscriber
+ * receives a pointer to the same buffer through its own bounded queue. The
+ * buffer is freed when the last holder releases it, so no payload is copied
+ * per consumer and publishing costs one pointer push per subscriber.
+ *
+ * Topic operations must be called from task context, not from ISRs.
+ */
+
+#include <lib/queue.h>
+
+/* Overflow policy of a subscriber queue */
+typedef enum {
+    TOPIC_DROP_NEWEST = 0, /* Full queue: the new message is not delivered */
+    TOPIC_DROP_OLDEST = 1  /* Full queue: the oldest message is discarded */
+} topic_policy_t;
+
+/* Reference-counted message buffer */
+typedef struct {
+    uint16_t refs;  /* Holders: publisher and/or pending deliveries */
+    uint16_t size;  /* Payload size in bytes */
+    uint8_t data[]; /* Payload */
+} topic_buf_t;
+
+struct topic;
+
+/* Subscription: a bounded queue of buffers published on one topic */
+typedef struct topic_sub {
+    struct topic_sub *next;    /* Next subscription of the same topic */
+    struct topic *topic;       /* Topic this subscription belongs to */
+    queue_t *q;                /* Pending (topic_buf_t *) deliveries */
+    uint16_t depth;            /* Maximum pending deliveries */
+    uint8_t policy;            /* Overflow policy (topic_policy_t) */
+    volatile uint16_t waiters; /* Tasks blocked in 'mo_topic_recv()' */
+    volatile uint32_t seq;     /* Bumped per delivery; receivers wait on it */
+    uint32_t dropped;          /* Deliveries lost to overflow */
+} topic_sub_t;
+
+/* Topic descriptor */
+typedef struct topic {
+    topic_sub_t *subs;  /* Singly-linked list of subscriptions */
+    uint32_t published; /* Number of messages published */
+} topic_t;
+
+/* Topic Management */
+
+/* Creates a topic with no subscribers.
+ *
+ * Returns pointer to new topic on success, NULL on failure
+ */
+topic_t *mo_topic_create(void);
+
+/* Destroys a topic.
+ * @topic : Pointer to topic (NULL is safe no-op)
+ *
+ * Returns ERR_OK on success, or ERR_TASK_BUSY if it still has subscribers
+ */
+int32_t mo_topic_destroy(topic_t *topic);
+
+/* Subscribes to a topic.
+ * @topic  : Pointer to topic (must be valid)
+ * @depth  : Maximum number of undelivered messages (must be > 0)
+ * @policy : What to drop once @depth messages are pending
+ *
+ * Returns the new subscription on success, NULL on failure
+ */
+topic_sub_t *mo_topic_subscribe(topic_t *topic, uint16_t depth, uint8_t policy);
+
+/* Cancels a subscription, releasing any messages still pending on it.
+ * @sub : Subscription returned by 'mo_topic_subscribe()'
+ *
+ * Returns ERR_OK on success, ERR_TASK_BUSY if a task is blocked in
+ * 'mo_topic_recv()' on @sub, or ERR_FAIL if @sub is invalid
+ *
+ * Note: @sub is freed, so no other task may be about to receive on it.
+ */
+int32_t mo_topic_unsubscribe(topic_sub_t *sub);
+
+/* Buffers */
+
+/* Allocates a message buffer holding one reference for the caller.
+ * @size : Payload size in bytes (must be > 0)
+ *
+ * Returns the buffer on success, NULL on failure. The payload is 'data'.
+ */
+topic_buf_t *mo_topic_buf_alloc(uint16_t size);
+
+/* Drops one reference to a buffer, freeing it when none remain.
+ * @buf : Buffer from 'mo_topic_buf_alloc()' or 'mo_topic_recv()'
+ */
+void mo_topic_buf_release(topic_buf_t *buf);
+
+/* Messaging */
+
+/* Publishes a buffer to every current subscriber of a topic.
+ *
+ * Each subscriber gains a reference; the caller's own reference is consumed,
+ * so the buffer must not be touched after publishing. A subscriber whose
+ * queue is full loses either this message or its oldest one, according to
+ * its policy.
+ * @topic : Pointer to topic (must be valid)
+ * @buf   : Buffer holding the caller's reference (must be valid)
+ *
+ * Returns the number of subscribers the message was delivered to, or
+ * ERR_FAIL on invalid arguments
+ */
+int32_t mo_topic_publish(topic_t *topic, topic_buf_t *buf);
+
+/* Receives the oldest pending message of a subscription, blocking while none
+ * is pending.
+ * @sub     : Subscription to receive from (must be valid)
+ * @timeout : Maximum ticks to wait, or 0 to wait indefinitely
+ *
+ * Returns the buffer, whose reference now belongs to the caller and must be
+ * dropped with 'mo_topic_buf_release()', or NULL on timeout or invalid
+ * arguments
+ */
+topic_buf_t *mo_topic_recv(topic_sub_t *sub, uint16_t timeout);
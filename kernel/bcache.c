@@ -0,0 +1,185 @@
+/* Write-Back Block Cache
+ *
+ * Buffers are found by linear search, which for the few dozen buffers a
+ * small system affords is cheaper than maintaining a hash. Each use stamps
+ * the buffer with a running clock; replacement takes the least recently
+ * used clean buffer, and only when every buffer is dirty does a miss force
+ * a write-back, which then writes all of them in one request.
+ */
+
+#include <lib/libc.h>
+#include <lib/malloc.h>
+
+#include "private/bcache.h"
+#include "private/utils.h"
+
+typedef struct {
+    uint32_t block;
+    uint32_t stamp; /* Cache clock at the last use */
+    bool valid;
+    bool dirty;
+    uint8_t *data;
+} bcache_buf_t;
+
+struct bcache {
+    blkdev_t *dev;
+    bcache_buf_t *bufs;
+    uint32_t nbufs;
+    uint32_t clock;  /* Incremented on every lookup */
+    uint32_t ndirty; /* Dirty buffers */
+
+    /* Scratch lists for 'bcache_flush()', sized for every buffer */
+    uint32_t *wb_blocks;
+    void **wb_data;
+};
+
+bcache_t *bcache_create(blkdev_t *dev, uint32_t nbufs)
+{
+    if (unlikely(!dev || nbufs < 2))
+        return NULL;
+
+    bcache_t *bc = calloc(1, sizeof(bcache_t));
+    if (unlikely(!bc))
+        return NULL;
+
+    bc->dev = dev;
+    bc->nbufs = nbufs;
+    bc->bufs = calloc(nbufs, sizeof(bcache_buf_t));
+    bc->wb_blocks = malloc(nbufs * sizeof(uint32_t));
+    bc->wb_data = malloc(nbufs * sizeof(void *));
+    uint8_t *mem = malloc(nbufs * BLK_SIZE);
+    if (unlikely(!bc->bufs || !bc->wb_blocks || !bc->wb_data || !mem)) {
+        free(mem);
+        free(bc->wb_data);
+        free(bc->wb_blocks);
+        free(bc->bufs);
+        free(bc);
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < nbufs; i++)
+        bc->bufs[i].data = mem + i * BLK_SIZE;
+    return bc;
+}
+
+void bcache_destroy(bcache_t *bc)
+{
+    if (!bc)
+        return;
+
+    bcache_flush(bc);
+    free(bc->bufs[0].data); /* Start of the buffer memory */
+    free(bc->wb_data);
+    free(bc->wb_blocks);
+    free(bc->bufs);
+    free(bc);
+}
+
+static bcache_buf_t *bcache_lookup(bcache_t *bc, uint32_t block)
+{
+    for (uint32_t i = 0; i < bc->nbufs; i++) {
+        if (bc->bufs[i].valid && bc->bufs[i].block == block)
+            return &bc->bufs[i];
+    }
+    return NULL;
+}
+
+/* Picks the buffer to reuse: a free one, else the least recently used clean
+ * one other than the most recent, or NULL if all of those are dirty.
+ */
+static bcache_buf_t *bcache_victim(bcache_t *bc)
+{
+    bcache_buf_t *victim = NULL;
+
+    for (uint32_t i = 0; i < bc->nbufs; i++) {
+        bcache_buf_t *b = &bc->bufs[i];
+        if (!b->valid)
+            return b;
+        if (!b->dirty && b->stamp != bc->clock &&
+            (!victim || b->stamp < victim->stamp))
+            victim = b;
+    }
+    return victim;
+}
+
+uint8_t *bcache_get(bcache_t *bc, uint32_t block, bool fill)
+{
+    bcache_buf_t *b = bcache_lookup(bc, block);
+
+    if (!b) {
+        b = bcache_victim(bc);
+        if (!b) {
+            /* Every candidate is dirty: write them all back at once */
+            if (bcache_flush(bc) < 0)
+                return NULL;
+            b = bcache_victim(bc);
+        }
+
+        b->valid = false;
+        if (fill && bc->dev->read(bc->dev, block, b->data) < 0)
+            return NULL;
+        b->block = block;
+        b->dirty = false;
+        b->valid = true;
+    }
+
+    b->stamp = ++bc->clock;
+    return b->data;
+}
+
+void bcache_dirty(bcache_t *bc, uint32_t block)
+{
+    bcache_buf_t *b = bcache_lookup(bc, block);
+    if (b && !b->dirty) {
+        b->dirty = true;
+        bc->ndirty++;
+    }
+}
+
+void bcache_discard(bcache_t *bc, uint32_t block)
+{
+    bcache_buf_t *b = bcache_lookup(bc, block);
+    if (!b)
+        return;
+
+    if (b->dirty)
+        bc->ndirty--;
+    b->dirty = false;
+    b->valid = false;
+}
+
+uint32_t bcache_dirty_count(bcache_t *bc)
+{
+    return bc->ndirty;
+}
+
+int32_t bcache_flush(bcache_t *bc)
+{
+    if (!bc->ndirty)
+        return 0;
+
+    /* Gather dirty buffers sorted by block (insertion sort, few entries) */
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < bc->nbufs; i++) {
+        bcache_buf_t *b = &bc->bufs[i];
+        if (!b->dirty)
+            continue;
+
+        uint32_t j = n++;
+        for (; j > 0 && bc->wb_blocks[j - 1] > b->block; j--) {
+            bc->wb_blocks[j] = bc->wb_blocks[j - 1];
+            bc->wb_data[j] = bc->wb_data[j - 1];
+        }
+        bc->wb_blocks[j] = b->block;
+        bc->wb_data[j] = b->data;
+    }
+
+    int32_t err = bc->dev->write(bc->dev, bc->wb_blocks, bc->wb_data, n);
+    if (unlikely(err < 0))
+        return err; /* Buffers stay dirty for a later attempt */
+
+    for (uint32_t i = 0; i < bc->nbufs; i++)
+        bc->bufs[i].dirty = false;
+    bc->ndirty = 0;
+    return 0;
+}
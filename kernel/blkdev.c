@@ -0,0 +1,55 @@
+/* Block Devices: RAM Disk
+ *
+ * A RAM disk keeps its blocks in one heap allocation. It completes every
+ * request immediately, which makes it the reference backend for testing
+ * code layered on 'blkdev_t'.
+ */
+
+#include <lib/libc.h>
+#include <lib/malloc.h>
+#include <sys/blkdev.h>
+
+#include "private/utils.h"
+
+static int32_t ramdisk_read(blkdev_t *dev, uint32_t block, void *buf)
+{
+    memcpy(buf, (uint8_t *) dev->priv + block * BLK_SIZE, BLK_SIZE);
+    return 0;
+}
+
+static int32_t ramdisk_write(blkdev_t *dev,
+                             const uint32_t *blocks,
+                             void *const *bufs,
+                             uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+        memcpy((uint8_t *) dev->priv + blocks[i] * BLK_SIZE, bufs[i], BLK_SIZE);
+    return 0;
+}
+
+static int32_t ramdisk_sync(blkdev_t *dev)
+{
+    return 0; /* Writes are durable (for the RAM's lifetime) once done */
+}
+
+blkdev_t *mo_ramdisk_create(uint32_t blocks)
+{
+    if (unlikely(!blocks || blocks > UINT32_MAX / BLK_SIZE))
+        return NULL;
+
+    blkdev_t *dev = malloc(sizeof(blkdev_t));
+    if (unlikely(!dev))
+        return NULL;
+
+    dev->priv = calloc(blocks, BLK_SIZE);
+    if (unlikely(!dev->priv)) {
+        free(dev);
+        return NULL;
+    }
+
+    dev->blocks = blocks;
+    dev->read = ramdisk_read;
+    dev->write = ramdisk_write;
+    dev->sync = ramdisk_sync;
+    return dev;
+}
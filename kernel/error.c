@@ -19,6 +19,7 @@ static const struct error_code error_desc[] = {
     {ERR_TASK_INVALID_PRIO, "invalid task priority"},
     {ERR_TASK_BUSY, "resource busy"},
     {ERR_NOT_OWNER, "operation not permitted"},
+    {ERR_SCHED_LOCK, "scheduler lock imbalance"},
 
     /* stack guard */
     {ERR_STACK_CHECK, "stack corruption"},
@@ -32,6 +33,8 @@ static const struct error_code error_desc[] = {
     {ERR_SEM_OPERATION, "semaphore operation"},
     {ERR_MQ_NOTEMPTY, "message queue not empty"},
     {ERR_TIMEOUT, "operation timed out"},
+    {ERR_IPC_NO_CALL, "no pending IPC call"},
+    {ERR_WAIT_VALUE, "wait value mismatch"},
 
     /* must be last */
     {ERR_UNKNOWN, "unknown error"},
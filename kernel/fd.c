@@ -0,0 +1,416 @@
+/* File Descriptors
+ *
+ * The table holds pointers to open-file entries, which carry the object,
+ * its operations and a reference count. Every descriptor counts as one
+ * reference, and so does every operation in progress, so a descriptor
+ * closed by one task while another is blocked reading it stays valid until
+ * that read returns; the object is closed with the last reference.
+ * Table updates only exclude the scheduler, since no ISR touches them.
+ */
+
+#include <hal.h>
+#include <lib/libc.h>
+#include <lib/malloc.h>
+#include <sys/errno.h>
+#include <sys/fcntl.h>
+#include <sys/fd.h>
+#include <sys/fs.h>
+#include <sys/logger.h>
+#include <sys/pipe.h>
+#include <sys/task.h>
+
+#include "private/error.h"
+#include "private/stdio.h"
+#include "private/utils.h"
+
+typedef struct {
+    const fd_ops_t *ops; /* NULL if the entry is free */
+    void *obj;
+    uint32_t refs; /* Descriptors plus operations in progress */
+} fd_file_t;
+
+/* Console */
+
+/* Blocks for the first byte, then takes what has already arrived up to the
+ * end of the line, like a terminal in canonical mode.
+ */
+static int32_t console_read(void *obj, void *buf, uint32_t len)
+{
+    char *p = buf;
+    uint32_t n = 0;
+
+    while (n < len) {
+        int c = _getchar();
+        if (c < 0)
+            break;
+        p[n++] = (char) c;
+        if (c == '\n' || !_kbhit())
+            break;
+    }
+    return n;
+}
+
+static void console_write_direct(const char *p, uint32_t len)
+{
+    while (len) {
+        uint32_t n = hal_console_write(p, len);
+        if (!n) {
+            _putchar(*p); /* Transmit ring full: waits for room */
+            n = 1;
+        }
+        p += n;
+        len -= n;
+    }
+}
+
+/* Goes through the logger like 'printf()' so that both stay in order, in
+ * chunks of one log entry; output the logger cannot take is queued on the
+ * console device directly.
+ */
+static int32_t console_write(void *obj, const void *buf, uint32_t len)
+{
+    const char *p = buf;
+
+    for (uint32_t done = 0; done < len;) {
+        uint32_t n = min(len - done, (uint32_t) (LOG_ENTRY_SZ - 1));
+        if (mo_logger_direct_mode() || mo_logger_enqueue(p + done, n) != ERR_OK)
+            console_write_direct(p + done, n);
+        done += n;
+    }
+    return len;
+}
+
+static int32_t console_fstat(void *obj, struct stat *st)
+{
+    st->st_mode = S_IFCHR;
+    return 0;
+}
+
+static const fd_ops_t console_ops = {
+    .read = console_read,
+    .write = console_write,
+    .fstat = console_fstat,
+};
+
+/* Pipes */
+
+typedef struct {
+    pipe_t *pipe;
+    volatile uint32_t readers; /* Open read ends */
+    volatile uint32_t writers; /* Open write ends */
+} fd_pipe_t;
+
+/* Returns what is buffered, waiting while nothing is and a write end is
+ * still open. An empty pipe without writers is at its end and reads 0.
+ */
+static int32_t pipe_read(void *obj, void *buf, uint32_t len)
+{
+    fd_pipe_t *fp = obj;
+
+    if (!len)
+        return 0;
+
+    while (1) {
+        /* Sampled first: data written before the last close is then seen */
+        bool writers = fp->writers != 0;
+        int32_t n = mo_pipe_nbread(fp->pipe, buf, len);
+        if (n != 0 || !writers)
+            return n < 0 ? -EIO : n;
+        mo_task_wfi(); /* Waits as the pipe's own blocking reads do */
+    }
+}
+
+static int32_t pipe_write(void *obj, const void *buf, uint32_t len)
+{
+    fd_pipe_t *fp = obj;
+
+    if (!fp->readers)
+        return -EPIPE;
+    if (!len)
+        return 0;
+
+    int32_t n = mo_pipe_write(fp->pipe, buf, len);
+    return n < 0 ? -EINVAL : n;
+}
+
+static int32_t pipe_fstat(void *obj, struct stat *st)
+{
+    st->st_mode = S_IFIFO;
+    st->st_size = mo_pipe_size(((fd_pipe_t *) obj)->pipe);
+    return 0;
+}
+
+/* Drops one of the open ends counted by @ends, and the pipe with the last */
+static int32_t pipe_close_end(fd_pipe_t *fp, volatile uint32_t *ends)
+{
+    NOSCHED_ENTER();
+    --*ends;
+    bool last = !fp->readers && !fp->writers;
+    NOSCHED_LEAVE();
+
+    if (last) {
+        mo_pipe_destroy(fp->pipe);
+        free(fp);
+    }
+    return 0;
+}
+
+static int32_t pipe_close_read(void *obj)
+{
+    fd_pipe_t *fp = obj;
+    return pipe_close_end(fp, &fp->readers);
+}
+
+static int32_t pipe_close_write(void *obj)
+{
+    fd_pipe_t *fp = obj;
+    return pipe_close_end(fp, &fp->writers);
+}
+
+static const fd_ops_t pipe_read_ops = {
+    .read = pipe_read,
+    .fstat = pipe_fstat,
+    .close = pipe_close_read,
+};
+
+static const fd_ops_t pipe_write_ops = {
+    .write = pipe_write,
+    .fstat = pipe_fstat,
+    .close = pipe_close_write,
+};
+
+/* Files: the object is the file system handle */
+
+static int32_t file_read(void *obj, void *buf, uint32_t len)
+{
+    return mo_fs_read((int32_t) (uintptr_t) obj, buf, len);
+}
+
+static int32_t file_write(void *obj, const void *buf, uint32_t len)
+{
+    return mo_fs_write((int32_t) (uintptr_t) obj, buf, len);
+}
+
+static int32_t file_seek(void *obj, int32_t offset, int32_t whence)
+{
+    return mo_fs_seek((int32_t) (uintptr_t) obj, offset, whence);
+}
+
+static int32_t file_fstat(void *obj, struct stat *st)
+{
+    return mo_fs_fstat((int32_t) (uintptr_t) obj, st);
+}
+
+static int32_t file_close(void *obj)
+{
+    return mo_fs_close((int32_t) (uintptr_t) obj);
+}
+
+static const fd_ops_t file_ops = {
+    .read = file_read,
+    .write = file_write,
+    .seek = file_seek,
+    .fstat = file_fstat,
+    .close = file_close,
+};
+
+/* Descriptor Table */
+
+/* Standard input, output and error share the console entry */
+static fd_file_t files[FD_MAX] = {
+    [0] = {.ops = &console_ops, .refs = 3},
+};
+
+static fd_file_t *table[FD_MAX] = {&files[0], &files[0], &files[0]};
+
+/* Takes a reference on the entry of @fd, or returns NULL if it is closed */
+static fd_file_t *fd_get(int32_t fd)
+{
+    fd_file_t *f = NULL;
+
+    if (unlikely(fd < 0 || fd >= FD_MAX))
+        return NULL;
+
+    NOSCHED_ENTER();
+    if (table[fd]) {
+        f = table[fd];
+        f->refs++;
+    }
+    NOSCHED_LEAVE();
+    return f;
+}
+
+/* Drops a reference, closing the object with the last one */
+static int32_t fd_put(fd_file_t *f)
+{
+    const fd_ops_t *ops = f->ops;
+    void *obj = f->obj;
+
+    NOSCHED_ENTER();
+    bool last = --f->refs == 0;
+    if (last)
+        f->ops = NULL; /* Entry is free again */
+    NOSCHED_LEAVE();
+
+    return last && ops->close ? ops->close(obj) : 0;
+}
+
+/* Points the lowest free descriptor at @f. Called with the scheduler off. */
+static int32_t fd_bind(fd_file_t *f)
+{
+    for (int32_t fd = 0; fd < FD_MAX; fd++) {
+        if (!table[fd]) {
+            table[fd] = f;
+            f->refs++;
+            return fd;
+        }
+    }
+    return -EMFILE;
+}
+
+int32_t mo_fd_install(const fd_ops_t *ops, void *obj)
+{
+    if (unlikely(!ops))
+        return -EINVAL;
+
+    int32_t fd = -EMFILE;
+
+    NOSCHED_ENTER();
+    for (uint32_t i = 0; i < FD_MAX; i++) {
+        fd_file_t *f = &files[i];
+        if (f->ops)
+            continue;
+
+        f->ops = ops;
+        f->obj = obj;
+        f->refs = 0;
+        fd = fd_bind(f);
+        if (fd < 0)
+            f->ops = NULL;
+        break;
+    }
+    NOSCHED_LEAVE();
+    return fd;
+}
+
+int32_t mo_fd_open(const char *name, int32_t flags)
+{
+    int32_t handle = mo_fs_open(name, flags);
+    if (handle < 0)
+        return handle;
+
+    int32_t fd = mo_fd_install(&file_ops, (void *) (uintptr_t) handle);
+    if (fd < 0)
+        mo_fs_close(handle);
+    return fd;
+}
+
+int32_t mo_fd_pipe(int32_t fds[2])
+{
+    if (unlikely(!fds))
+        return -EFAULT;
+
+    fd_pipe_t *fp = malloc(sizeof(fd_pipe_t));
+    pipe_t *pipe = fp ? mo_pipe_create(FD_PIPE_SIZE) : NULL;
+    if (!pipe) {
+        free(fp);
+        return -ENOMEM;
+    }
+    fp->pipe = pipe;
+    fp->readers = fp->writers = 1;
+
+    fds[0] = mo_fd_install(&pipe_read_ops, fp);
+    fds[1] = fds[0] < 0 ? -EMFILE : mo_fd_install(&pipe_write_ops, fp);
+    if (fds[1] < 0) {
+        if (fds[0] >= 0)
+            mo_fd_close(fds[0]);
+        mo_pipe_destroy(pipe);
+        free(fp);
+        return -EMFILE;
+    }
+    return 0;
+}
+
+int32_t mo_fd_dup(int32_t fd)
+{
+    fd_file_t *f = fd_get(fd);
+    if (!f)
+        return -EBADF;
+
+    NOSCHED_ENTER();
+    int32_t nfd = fd_bind(f);
+    NOSCHED_LEAVE();
+
+    fd_put(f);
+    return nfd;
+}
+
+int32_t mo_fd_close(int32_t fd)
+{
+    fd_file_t *f = NULL;
+
+    if (unlikely(fd < 0 || fd >= FD_MAX))
+        return -EBADF;
+
+    NOSCHED_ENTER();
+    f = table[fd];
+    table[fd] = NULL;
+    NOSCHED_LEAVE();
+
+    return f ? fd_put(f) : -EBADF;
+}
+
+int32_t mo_fd_read(int32_t fd, void *buf, uint32_t len)
+{
+    if (unlikely(!buf))
+        return -EFAULT;
+
+    fd_file_t *f = fd_get(fd);
+    if (!f)
+        return -EBADF;
+
+    int32_t ret = f->ops->read ? f->ops->read(f->obj, buf, len) : -EBADF;
+    fd_put(f);
+    return ret;
+}
+
+int32_t mo_fd_write(int32_t fd, const void *buf, uint32_t len)
+{
+    if (unlikely(!buf))
+        return -EFAULT;
+
+    fd_file_t *f = fd_get(fd);
+    if (!f)
+        return -EBADF;
+
+    int32_t ret = f->ops->write ? f->ops->write(f->obj, buf, len) : -EBADF;
+    fd_put(f);
+    return ret;
+}
+
+int32_t mo_fd_seek(int32_t fd, int32_t offset, int32_t whence)
+{
+    fd_file_t *f = fd_get(fd);
+    if (!f)
+        return -EBADF;
+
+    int32_t ret =
+        f->ops->seek ? f->ops->seek(f->obj, offset, whence) : -ESPIPE;
+    fd_put(f);
+    return ret;
+}
+
+int32_t mo_fd_fstat(int32_t fd, struct stat *st)
+{
+    if (unlikely(!st))
+        return -EFAULT;
+
+    fd_file_t *f = fd_get(fd);
+    if (!f)
+        return -EBADF;
+
+    memset(st, 0, sizeof(*st));
+    int32_t ret = f->ops->fstat ? f->ops->fstat(f->obj, st) : 0;
+    fd_put(f);
+    return ret;
+}
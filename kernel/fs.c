@@ -0,0 +1,804 @@
+/* Log-Structured File System
+ *
+ * Disk layout, in BLK_SIZE blocks:
+ *   [0, FS_CKPT_BLOCKS)                   checkpoint area 0
+ *   [FS_CKPT_BLOCKS, 2 * FS_CKPT_BLOCKS)  checkpoint area 1
+ *   [FS_DATA_START, blocks)               data blocks, allocated from the log
+ *                                         head onwards and wrapping around
+ *
+ * A checkpoint holds the whole metadata: a sequence number, the log head
+ * and the inode table, where each file is a name, a size and a list of
+ * extents. The RAM copy is the live state; committing writes back the
+ * dirty data, then the checkpoint into the area not holding the previous
+ * one, with a device sync after each step.
+ *
+ * Three block bitmaps keep the live state from ever overwriting what the
+ * on-disk checkpoint references:
+ *   - used:   referenced by the live state
+ *   - fresh:  allocated since the last commit, so updated in place
+ *   - pinned: dropped since the last commit but still referenced on disk,
+ *             so not reusable until the next commit
+ * Rewriting committed file bytes therefore moves the block to a new location
+ * (copy-on-write). Appending past the committed size of a file touches no
+ * committed byte and may fill the unused tail of its last block in place;
+ * this relies on the device writing a block without corrupting the bytes
+ * that did not change, which all sector-atomic media guarantee.
+ */
+
+#include <lib/libc.h>
+#include <lib/malloc.h>
+#include <sys/errno.h>
+#include <sys/fcntl.h>
+#include <sys/fs.h>
+#include <sys/mutex.h>
+#include <sys/semaphore.h>
+#include <sys/task.h>
+
+#include "private/bcache.h"
+#include "private/utils.h"
+
+#define FS_MAGIC 0x53464D4CU /* "LMFS" */
+#define FS_CKPT_BLOCKS 4
+#define FS_DATA_START (2 * FS_CKPT_BLOCKS)
+
+typedef struct {
+    uint32_t start; /* First block */
+    uint32_t count; /* Blocks in the run */
+} fs_extent_t;
+
+typedef struct {
+    char name[FS_NAME_MAX + 1]; /* Empty for an unused inode */
+    uint32_t size;
+    uint32_t nextents;
+    fs_extent_t ext[FS_EXTENTS];
+} fs_inode_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;      /* Higher is newer */
+    uint32_t blocks;   /* Device size the file system was made for */
+    uint32_t head;     /* Where the next allocation search starts */
+    uint32_t checksum; /* FNV-1a of the checkpoint with this field zero */
+    fs_inode_t inode[FS_MAX_FILES];
+} fs_ckpt_t;
+
+typedef union {
+    fs_ckpt_t c;
+    uint8_t raw[FS_CKPT_BLOCKS * BLK_SIZE];
+} fs_ckpt_area_t;
+
+STATIC_ASSERT(sizeof(fs_ckpt_t) <= FS_CKPT_BLOCKS * BLK_SIZE,
+              "checkpoint does not fit its area");
+
+typedef struct {
+    fs_inode_t *ino; /* NULL if the slot is free */
+    uint32_t pos;
+    int32_t flags;
+    bool written; /* Report write-back errors on close */
+} fs_file_t;
+
+static struct {
+    blkdev_t *dev;
+    bcache_t *cache;
+    mutex_t lock;
+    fs_ckpt_area_t ckpt;               /* Live metadata */
+    uint32_t committed[FS_MAX_FILES];  /* File sizes in the disk checkpoint */
+    uint32_t area;                     /* Area of the last checkpoint */
+    uint8_t *used, *fresh, *pinned;    /* Block bitmaps */
+    uint32_t nfree;                    /* Blocks neither used nor pinned */
+    uint32_t npinned;
+    fs_file_t file[FS_MAX_OPEN];
+    sem_t *wb_wake;  /* Signaled when the cache passes FS_DIRTY_HIGH */
+    bool wb_queued;  /* Write-back requested but not started */
+    int32_t wb_err;  /* Last write-back failure, not yet reported */
+    bool lock_ready; /* Lock and write-back task exist */
+    bool mounted;
+} fs;
+
+static inline bool bit_test(const uint8_t *map, uint32_t b)
+{
+    return map[b >> 3] & (1U << (b & 7));
+}
+
+static inline void bit_set(uint8_t *map, uint32_t b)
+{
+    map[b >> 3] |= 1U << (b & 7);
+}
+
+static inline void bit_clear(uint8_t *map, uint32_t b)
+{
+    map[b >> 3] &= ~(1U << (b & 7));
+}
+
+static inline uint32_t fs_nblocks(uint32_t size)
+{
+    return (size + BLK_SIZE - 1) / BLK_SIZE;
+}
+
+static uint32_t fs_checksum(fs_ckpt_area_t *area)
+{
+    uint32_t saved = area->c.checksum, hash = 0x811C9DC5U;
+
+    area->c.checksum = 0;
+    for (uint32_t i = 0; i < sizeof(fs_ckpt_t); i++)
+        hash = (hash ^ area->raw[i]) * 0x01000193U;
+    area->c.checksum = saved;
+    return hash;
+}
+
+/* Block Allocation */
+
+/* Allocates a data block at or after the log head. Returns 0 if full. */
+static uint32_t fs_alloc(void)
+{
+    uint32_t blocks = fs.ckpt.c.blocks;
+    uint32_t b = fs.ckpt.c.head;
+
+    if (!fs.nfree)
+        return 0;
+
+    while (bit_test(fs.used, b) || bit_test(fs.pinned, b)) {
+        if (++b == blocks)
+            b = FS_DATA_START;
+    }
+
+    bit_set(fs.used, b);
+    bit_set(fs.fresh, b);
+    fs.nfree--;
+    fs.ckpt.c.head = b + 1 == blocks ? FS_DATA_START : b + 1;
+    return b;
+}
+
+/* Drops block @b from the live state */
+static void fs_release(uint32_t b)
+{
+    bit_clear(fs.used, b);
+    bcache_discard(fs.cache, b);
+
+    if (bit_test(fs.fresh, b)) {
+        bit_clear(fs.fresh, b); /* Never committed: reusable right away */
+        fs.nfree++;
+    } else {
+        bit_set(fs.pinned, b); /* Still in the disk checkpoint */
+        fs.npinned++;
+    }
+}
+
+/* Extents */
+
+/* Returns the block holding file block @fblock, or 0 past the end */
+static uint32_t fs_map(const fs_inode_t *ino, uint32_t fblock)
+{
+    for (uint32_t i = 0; i < ino->nextents; i++) {
+        if (fblock < ino->ext[i].count)
+            return ino->ext[i].start + fblock;
+        fblock -= ino->ext[i].count;
+    }
+    return 0;
+}
+
+/* Appends block @b to the file, extending the last extent if contiguous */
+static int32_t fs_extent_append(fs_inode_t *ino, uint32_t b)
+{
+    fs_extent_t *last = ino->nextents ? &ino->ext[ino->nextents - 1] : NULL;
+
+    if (last && last->start + last->count == b) {
+        last->count++;
+        return 0;
+    }
+    if (ino->nextents == FS_EXTENTS)
+        return -EFBIG;
+
+    ino->ext[ino->nextents++] = (fs_extent_t){b, 1};
+    return 0;
+}
+
+/* Makes file block @fblock refer to block @b, splitting its extent */
+static int32_t fs_extent_remap(fs_inode_t *ino, uint32_t fblock, uint32_t b)
+{
+    uint32_t i = 0;
+    while (fblock >= ino->ext[i].count)
+        fblock -= ino->ext[i++].count;
+
+    fs_extent_t old = ino->ext[i];
+    uint32_t head = fblock, tail = old.count - fblock - 1;
+    uint32_t extra = (head > 0) + (tail > 0);
+
+    if (ino->nextents + extra > FS_EXTENTS)
+        return -EFBIG;
+
+    /* Replace extent i by [head part] [b] [tail part] */
+    memmove(&ino->ext[i + 1 + extra], &ino->ext[i + 1],
+            (ino->nextents - i - 1) * sizeof(fs_extent_t));
+    ino->nextents += extra;
+    if (head)
+        ino->ext[i++] = (fs_extent_t){old.start, head};
+    ino->ext[i++] = (fs_extent_t){b, 1};
+    if (tail)
+        ino->ext[i] = (fs_extent_t){old.start + fblock + 1, tail};
+
+    /* Rejoin runs that became contiguous, as when neighbours move together */
+    uint32_t n = 0;
+    for (uint32_t j = 1; j < ino->nextents; j++) {
+        if (ino->ext[n].start + ino->ext[n].count == ino->ext[j].start)
+            ino->ext[n].count += ino->ext[j].count;
+        else
+            ino->ext[++n] = ino->ext[j];
+    }
+    ino->nextents = n + 1;
+    return 0;
+}
+
+static void fs_truncate(fs_inode_t *ino)
+{
+    for (uint32_t i = 0; i < ino->nextents; i++) {
+        for (uint32_t j = 0; j < ino->ext[i].count; j++)
+            fs_release(ino->ext[i].start + j);
+    }
+    ino->nextents = 0;
+    ino->size = 0;
+}
+
+/* Checkpoints */
+
+/* Writes back all data, then the checkpoint into the other area */
+static int32_t fs_commit(void)
+{
+    int32_t err = bcache_flush(fs.cache);
+    if (!err)
+        err = fs.dev->sync(fs.dev);
+    if (err)
+        return err;
+
+    uint32_t area = fs.area ^ 1;
+    uint32_t blocks[FS_CKPT_BLOCKS];
+    void *bufs[FS_CKPT_BLOCKS];
+    for (uint32_t i = 0; i < FS_CKPT_BLOCKS; i++) {
+        blocks[i] = area * FS_CKPT_BLOCKS + i;
+        bufs[i] = fs.ckpt.raw + i * BLK_SIZE;
+    }
+
+    fs.ckpt.c.seq++;
+    fs.ckpt.c.checksum = fs_checksum(&fs.ckpt);
+    err = fs.dev->write(fs.dev, blocks, bufs, FS_CKPT_BLOCKS);
+    if (!err)
+        err = fs.dev->sync(fs.dev);
+    if (err)
+        return err;
+
+    /* The new checkpoint is durable: the old one's blocks are free now */
+    fs.area = area;
+    uint32_t map_bytes = (fs.ckpt.c.blocks + 7) / 8;
+    memset(fs.fresh, 0, map_bytes);
+    memset(fs.pinned, 0, map_bytes);
+    fs.nfree += fs.npinned;
+    fs.npinned = 0;
+    for (uint32_t i = 0; i < FS_MAX_FILES; i++)
+        fs.committed[i] = fs.ckpt.c.inode[i].size;
+    return 0;
+}
+
+static bool fs_ckpt_valid(fs_ckpt_area_t *area, uint32_t blocks)
+{
+    const fs_ckpt_t *c = &area->c;
+    return c->magic == FS_MAGIC && c->blocks == blocks &&
+           c->head >= FS_DATA_START && c->head < blocks &&
+           c->checksum == fs_checksum(area);
+}
+
+/* Loads the newer valid checkpoint into the live state */
+static int32_t fs_load(void)
+{
+    fs_ckpt_area_t *tmp = malloc(sizeof(fs_ckpt_area_t));
+    if (!tmp)
+        return -ENOMEM;
+
+    bool found = false;
+    for (uint32_t area = 0; area < 2; area++) {
+        for (uint32_t i = 0; i < FS_CKPT_BLOCKS; i++) {
+            if (fs.dev->read(fs.dev, area * FS_CKPT_BLOCKS + i,
+                             tmp->raw + i * BLK_SIZE) < 0) {
+                free(tmp);
+                return -EIO;
+            }
+        }
+        if (fs_ckpt_valid(tmp, fs.dev->blocks) &&
+            (!found || tmp->c.seq > fs.ckpt.c.seq)) {
+            memcpy(&fs.ckpt, tmp, sizeof(fs_ckpt_area_t));
+            fs.area = area;
+            found = true;
+        }
+    }
+    free(tmp);
+    return found ? 0 : -EINVAL;
+}
+
+static fs_inode_t *fs_lookup(const char *name)
+{
+    for (uint32_t i = 0; i < FS_MAX_FILES; i++) {
+        fs_inode_t *ino = &fs.ckpt.c.inode[i];
+        if (ino->name[0] && !strcmp(ino->name, name))
+            return ino;
+    }
+    return NULL;
+}
+
+static bool fs_is_open(const fs_inode_t *ino)
+{
+    for (uint32_t i = 0; i < FS_MAX_OPEN; i++) {
+        if (fs.file[i].ino == ino)
+            return true;
+    }
+    return false;
+}
+
+static fs_file_t *fs_file(int32_t fd)
+{
+    if (fd < 0 || fd >= FS_MAX_OPEN || !fs.file[fd].ino)
+        return NULL;
+    return &fs.file[fd];
+}
+
+static void fs_fill_stat(const fs_inode_t *ino, struct stat *st)
+{
+    memset(st, 0, sizeof(*st));
+    st->st_ino = ino - fs.ckpt.c.inode + 1;
+    st->st_nlink = 1;
+    st->st_mode = S_IFREG | S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+    st->st_size = ino->size;
+    st->st_blksize = BLK_SIZE;
+    st->st_blocks = fs_nblocks(ino->size) * (BLK_SIZE / 512);
+}
+
+/* Entry points take the lock and fail early without a mounted file system.
+ * The lock only exists once the first mount created it.
+ */
+#define FS_ENTER(err)                  \
+    do {                               \
+        if (unlikely(!fs.lock_ready))  \
+            return (err);              \
+        mo_mutex_lock(&fs.lock);       \
+        if (unlikely(!fs.mounted)) {   \
+            mo_mutex_unlock(&fs.lock); \
+            return (err);              \
+        }                              \
+    } while (0)
+
+#define FS_LEAVE(ret)              \
+    do {                           \
+        mo_mutex_unlock(&fs.lock); \
+        return (ret);              \
+    } while (0)
+
+/* Write-back task: writes the dirty cache back for writers that passed the
+ * high-water mark, so that they go on copying into the cache meanwhile. The
+ * cache is not synchronized, so it flushes under the lock like any other
+ * operation; a failed flush leaves the blocks dirty for the next attempt
+ * and is reported by the next close of a written file.
+ */
+static void fs_writeback_task(void)
+{
+    while (1) {
+        mo_sem_wait(fs.wb_wake);
+
+        mo_mutex_lock(&fs.lock);
+        fs.wb_queued = false;
+        if (fs.mounted) {
+            int32_t err = bcache_flush(fs.cache);
+            if (err)
+                fs.wb_err = err;
+        }
+        mo_mutex_unlock(&fs.lock);
+    }
+}
+
+/* File System Control */
+
+int32_t mo_fs_mount(blkdev_t *dev, bool format)
+{
+    if (unlikely(!dev || dev->blocks <= FS_DATA_START))
+        return -EINVAL;
+
+    if (!fs.lock_ready) {
+        if (mo_mutex_init(&fs.lock) != 0)
+            return -ENOMEM;
+        fs.wb_wake = mo_sem_create(1, 0);
+        if (!fs.wb_wake || mo_task_spawn(fs_writeback_task, 1024) < 0) {
+            if (fs.wb_wake)
+                mo_sem_destroy(fs.wb_wake);
+            mo_mutex_destroy(&fs.lock);
+            return -ENOMEM;
+        }
+        fs.lock_ready = true;
+    }
+
+    mo_mutex_lock(&fs.lock);
+    if (fs.mounted)
+        FS_LEAVE(-EBUSY);
+
+    uint32_t map_bytes = (dev->blocks + 7) / 8;
+    uint8_t *maps = calloc(3, map_bytes);
+    bcache_t *cache = bcache_create(dev, FS_CACHE_BLOCKS);
+    if (!maps || !cache) {
+        free(maps);
+        bcache_destroy(cache);
+        FS_LEAVE(-ENOMEM);
+    }
+
+    fs.dev = dev;
+    fs.cache = cache;
+    fs.used = maps;
+    fs.fresh = maps + map_bytes;
+    fs.pinned = maps + 2 * map_bytes;
+    fs.npinned = 0;
+    fs.wb_err = 0;
+    memset(fs.file, 0, sizeof(fs.file));
+
+    int32_t err = 0;
+    if (format) {
+        memset(&fs.ckpt, 0, sizeof(fs.ckpt));
+        fs.ckpt.c.magic = FS_MAGIC;
+        fs.ckpt.c.blocks = dev->blocks;
+        fs.ckpt.c.head = FS_DATA_START;
+        fs.nfree = dev->blocks - FS_DATA_START;
+        /* Write both areas so no older file system survives in either */
+        fs.area = 1;
+        err = fs_commit();
+        if (!err)
+            err = fs_commit();
+    } else {
+        err = fs_load();
+        if (!err) {
+            fs.nfree = dev->blocks - FS_DATA_START;
+            for (uint32_t i = 0; i < FS_MAX_FILES; i++) {
+                fs_inode_t *ino = &fs.ckpt.c.inode[i];
+                fs.committed[i] = ino->size;
+                for (uint32_t e = 0; e < ino->nextents; e++) {
+                    for (uint32_t j = 0; j < ino->ext[e].count; j++)
+                        bit_set(fs.used, ino->ext[e].start + j);
+                    fs.nfree -= ino->ext[e].count;
+                }
+            }
+        }
+    }
+
+    if (err) {
+        bcache_destroy(cache);
+        free(maps);
+        FS_LEAVE(err);
+    }
+
+    fs.mounted = true;
+    FS_LEAVE(0);
+}
+
+int32_t mo_fs_unmount(void)
+{
+    FS_ENTER(-EINVAL);
+
+    for (uint32_t i = 0; i < FS_MAX_OPEN; i++) {
+        if (fs.file[i].ino)
+            FS_LEAVE(-EBUSY);
+    }
+
+    int32_t err = fs_commit();
+    if (err)
+        FS_LEAVE(err);
+
+    bcache_destroy(fs.cache);
+    free(fs.used);
+    fs.mounted = false;
+    FS_LEAVE(0);
+}
+
+bool mo_fs_mounted(void)
+{
+    return fs.mounted;
+}
+
+int32_t mo_fs_sync(void)
+{
+    FS_ENTER(-EINVAL);
+
+    /* A commit writes back whatever an earlier failed flush left dirty */
+    int32_t err = fs_commit();
+    if (!err)
+        fs.wb_err = 0;
+    FS_LEAVE(err);
+}
+
+/* File Operations */
+
+int32_t mo_fs_open(const char *name, int32_t flags)
+{
+    if (unlikely(!name || !*name))
+        return -ENOENT;
+    if (unlikely(strlen(name) > FS_NAME_MAX))
+        return -ENAMETOOLONG;
+
+    FS_ENTER(-ENOENT);
+
+    fs_file_t *f = NULL;
+    for (uint32_t i = 0; i < FS_MAX_OPEN && !f; i++) {
+        if (!fs.file[i].ino)
+            f = &fs.file[i];
+    }
+    if (!f)
+        FS_LEAVE(-EMFILE);
+
+    fs_inode_t *ino = fs_lookup(name);
+    if (ino && (flags & O_CREAT) && (flags & O_EXCL))
+        FS_LEAVE(-EEXIST);
+
+    if (!ino) {
+        if (!(flags & O_CREAT))
+            FS_LEAVE(-ENOENT);
+        for (uint32_t i = 0; i < FS_MAX_FILES && !ino; i++) {
+            if (!fs.ckpt.c.inode[i].name[0])
+                ino = &fs.ckpt.c.inode[i];
+        }
+        if (!ino)
+            FS_LEAVE(-ENOSPC);
+        memset(ino, 0, sizeof(*ino));
+        strcpy(ino->name, name);
+    }
+
+    /* Other handles would keep positions past the new end */
+    bool writable = (flags & O_ACCMODE) != O_RDONLY;
+    if ((flags & O_TRUNC) && writable && ino->size) {
+        if (fs_is_open(ino))
+            FS_LEAVE(-EBUSY);
+        fs_truncate(ino);
+    }
+
+    f->ino = ino;
+    f->pos = 0;
+    f->flags = flags;
+    f->written = false;
+    FS_LEAVE(f - fs.file);
+}
+
+int32_t mo_fs_close(int32_t fd)
+{
+    FS_ENTER(-EBADF);
+
+    fs_file_t *f = fs_file(fd);
+    if (!f)
+        FS_LEAVE(-EBADF);
+
+    /* Committing is left to 'mo_fs_sync()', which batches many files */
+    int32_t err = 0;
+    if (f->written) {
+        err = fs.wb_err;
+        fs.wb_err = 0;
+    }
+    f->ino = NULL;
+    FS_LEAVE(err);
+}
+
+int32_t mo_fs_read(int32_t fd, void *buf, uint32_t len)
+{
+    if (unlikely(!buf))
+        return -EFAULT;
+
+    FS_ENTER(-EBADF);
+
+    fs_file_t *f = fs_file(fd);
+    if (!f || (f->flags & O_ACCMODE) == O_WRONLY)
+        FS_LEAVE(-EBADF);
+
+    fs_inode_t *ino = f->ino;
+    if (f->pos >= ino->size)
+        FS_LEAVE(0);
+    len = min(len, ino->size - f->pos);
+
+    uint32_t done = 0;
+    bool failed = false;
+    while (done < len) {
+        uint32_t off = f->pos % BLK_SIZE;
+        uint32_t n = min(len - done, BLK_SIZE - off);
+        uint8_t *data =
+            bcache_get(fs.cache, fs_map(ino, f->pos / BLK_SIZE), true);
+        if (!data) {
+            failed = true;
+            break;
+        }
+
+        memcpy((uint8_t *) buf + done, data + off, n);
+        f->pos += n;
+        done += n;
+    }
+    FS_LEAVE(failed && !done ? -EIO : (int32_t) done);
+}
+
+/* Returns the cache buffer of file block @fblock ready for writing bytes
+ * from @pos on, moving a committed block first if bytes the disk checkpoint
+ * references would change. Stores the block number in @block.
+ */
+static uint8_t *fs_write_block(fs_inode_t *ino,
+                               uint32_t fblock,
+                               uint32_t pos,
+                               uint32_t *block,
+                               int32_t *err)
+{
+    uint32_t committed = fs.committed[ino - fs.ckpt.c.inode];
+    uint32_t nblocks = fs_nblocks(ino->size);
+
+    /* Writes start at or before the end, so this only guards against a
+     * position left stale by a bug: mapping it would hit the checkpoint.
+     */
+    if (unlikely(fblock > nblocks)) {
+        *err = -EINVAL;
+        return NULL;
+    }
+
+    if (fblock == nblocks) {
+        /* Appending a new block: only link it once its buffer exists */
+        uint32_t b = fs_alloc();
+        if (!b) {
+            *err = -ENOSPC;
+            return NULL;
+        }
+        uint8_t *data = bcache_get(fs.cache, b, false);
+        *err = data ? fs_extent_append(ino, b) : -EIO;
+        if (*err) {
+            fs_release(b);
+            return NULL;
+        }
+        memset(data, 0, BLK_SIZE);
+        *block = b;
+        return data;
+    }
+
+    uint32_t b = fs_map(ino, fblock);
+    if (bit_test(fs.fresh, b) || pos >= committed) {
+        *block = b; /* Not committed, or only bytes past the committed end */
+        return bcache_get(fs.cache, b, true);
+    }
+
+    /* Copy-on-write of a committed block */
+    uint32_t nb = fs_alloc();
+    if (!nb) {
+        *err = -ENOSPC;
+        return NULL;
+    }
+    uint8_t *src = bcache_get(fs.cache, b, true);
+    uint8_t *dst = src ? bcache_get(fs.cache, nb, false) : NULL;
+    *err = dst ? fs_extent_remap(ino, fblock, nb) : -EIO;
+    if (*err) {
+        fs_release(nb);
+        return NULL;
+    }
+    memcpy(dst, src, BLK_SIZE);
+    fs_release(b);
+    *block = nb;
+    return bcache_get(fs.cache, nb, true); /* Hit: refreshes its LRU stamp */
+}
+
+int32_t mo_fs_write(int32_t fd, const void *buf, uint32_t len)
+{
+    if (unlikely(!buf))
+        return -EFAULT;
+
+    FS_ENTER(-EBADF);
+
+    fs_file_t *f = fs_file(fd);
+    if (!f || (f->flags & O_ACCMODE) == O_RDONLY)
+        FS_LEAVE(-EBADF);
+
+    fs_inode_t *ino = f->ino;
+    if (f->flags & O_APPEND)
+        f->pos = ino->size;
+
+    uint32_t done = 0;
+    int32_t err = 0;
+    while (done < len) {
+        uint32_t off = f->pos % BLK_SIZE;
+        uint32_t n = min(len - done, BLK_SIZE - off);
+        uint32_t b;
+        uint8_t *data =
+            fs_write_block(ino, f->pos / BLK_SIZE, f->pos, &b, &err);
+        if (!data) {
+            if (!err)
+                err = -EIO;
+            break;
+        }
+
+        memcpy(data + off, (const uint8_t *) buf + done, n);
+        bcache_dirty(fs.cache, b);
+        f->pos += n;
+        done += n;
+        if (f->pos > ino->size)
+            ino->size = f->pos;
+    }
+
+    if (done)
+        f->written = true;
+
+    /* Batch write-back once enough dirty blocks have built up */
+    if (bcache_dirty_count(fs.cache) >= FS_DIRTY_HIGH && !fs.wb_queued) {
+        fs.wb_queued = true;
+        mo_sem_signal(fs.wb_wake);
+    }
+
+    FS_LEAVE(done ? (int32_t) done : err);
+}
+
+int32_t mo_fs_seek(int32_t fd, int32_t offset, int32_t whence)
+{
+    FS_ENTER(-EBADF);
+
+    fs_file_t *f = fs_file(fd);
+    if (!f)
+        FS_LEAVE(-EBADF);
+
+    int32_t base;
+    switch (whence) {
+    case SEEK_SET:
+        base = 0;
+        break;
+    case SEEK_CUR:
+        base = f->pos;
+        break;
+    case SEEK_END:
+        base = f->ino->size;
+        break;
+    default:
+        FS_LEAVE(-EINVAL);
+    }
+
+    int32_t pos = base + offset;
+    if (pos < 0 || (uint32_t) pos > f->ino->size)
+        FS_LEAVE(-EINVAL);
+
+    f->pos = pos;
+    FS_LEAVE(pos);
+}
+
+int32_t mo_fs_stat(const char *name, struct stat *st)
+{
+    if (unlikely(!name || !st))
+        return -EFAULT;
+
+    FS_ENTER(-ENOENT);
+
+    fs_inode_t *ino = fs_lookup(name);
+    if (!ino)
+        FS_LEAVE(-ENOENT);
+
+    fs_fill_stat(ino, st);
+    FS_LEAVE(0);
+}
+
+int32_t mo_fs_fstat(int32_t fd, struct stat *st)
+{
+    if (unlikely(!st))
+        return -EFAULT;
+
+    FS_ENTER(-EBADF);
+
+    fs_file_t *f = fs_file(fd);
+    if (!f)
+        FS_LEAVE(-EBADF);
+
+    fs_fill_stat(f->ino, st);
+    FS_LEAVE(0);
+}
+
+int32_t mo_fs_unlink(const char *name)
+{
+    if (unlikely(!name))
+        return -EFAULT;
+
+    FS_ENTER(-ENOENT);
+
+    fs_inode_t *ino = fs_lookup(name);
+    if (!ino)
+        FS_LEAVE(-ENOENT);
+    if (fs_is_open(ino))
+        FS_LEAVE(-EBUSY);
+
+    fs_truncate(ino);
+    ino->name[0] = '\0';
+    FS_LEAVE(0);
+}
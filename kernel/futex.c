@@ -0,0 +1,121 @@
+/* Wait-on-Address (Futex-like) Primitive
+ *
+ * Waiters are described by records on their own stacks, linked into one of
+ * WAIT_HASH_SIZE FIFO buckets selected by hashing the waited-on address.
+ * Tasks waiting on different addresses may share a bucket; wakeups compare
+ * the exact address, so collisions only cost a slightly longer scan.
+ */
+
+#include <sys/futex.h>
+#include <sys/task.h>
+
+#include "private/error.h"
+#include "private/utils.h"
+
+#define WAIT_HASH_BITS 4
+#define WAIT_HASH_SIZE (1U << WAIT_HASH_BITS)
+
+typedef struct wait_rec {
+    struct wait_rec *next;
+    volatile uint32_t *addr; /* Address being waited on */
+    tcb_t *task;             /* Blocked task owning this record */
+    bool woken;              /* Set by 'mo_wake()' before readying @task */
+} wait_rec_t;
+
+static wait_rec_t *wait_table[WAIT_HASH_SIZE];
+
+/* Multiplicative (Fibonacci) hash of the word address */
+static inline wait_rec_t **wait_bucket(volatile uint32_t *addr)
+{
+    uint32_t key = (uint32_t) (uintptr_t) addr >> 2;
+    return &wait_table[(key * 0x9E3779B1U) >> (32 - WAIT_HASH_BITS)];
+}
+
+/* Unlink @w from @bucket if it is still queued */
+static void wait_unlink(wait_rec_t **bucket, wait_rec_t *w)
+{
+    for (; *bucket; bucket = &(*bucket)->next) {
+        if (*bucket == w) {
+            *bucket = w->next;
+            return;
+        }
+    }
+}
+
+int32_t mo_wait_on(volatile uint32_t *addr,
+                   uint32_t expected,
+                   uint16_t timeout)
+{
+    if (unlikely(!addr || ((uintptr_t) addr & 3)))
+        return ERR_FAIL;
+
+    NOSCHED_ENTER();
+
+    if (*addr != expected) {
+        NOSCHED_LEAVE();
+        return ERR_WAIT_VALUE;
+    }
+
+    tcb_t *self = kcb->task_current->data;
+    wait_rec_t w = {
+        .next = NULL,
+        .addr = addr,
+        .task = self,
+        .woken = false,
+    };
+
+    wait_rec_t **bucket = wait_bucket(addr);
+    wait_rec_t **tail = bucket;
+    while (*tail)
+        tail = &(*tail)->next;
+    *tail = &w;
+
+    /* A timeout rides on the task delay mechanism */
+    self->delay = timeout;
+    self->state = TASK_BLOCKED;
+    _yield();
+
+    /* Either 'mo_wake()' dequeued us, or the delay expired first */
+    int32_t result = ERR_OK;
+    if (!w.woken) {
+        wait_unlink(bucket, &w);
+        result = ERR_TIMEOUT;
+    }
+
+    NOSCHED_LEAVE();
+    return result;
+}
+
+int32_t _futex_wake(volatile uint32_t *addr, uint32_t n)
+{
+    int32_t woken = 0;
+
+    wait_rec_t **link = wait_bucket(addr);
+    while (*link && (uint32_t) woken < n) {
+        wait_rec_t *w = *link;
+        if (w->addr != addr) {
+            link = &w->next;
+            continue;
+        }
+
+        *link = w->next;
+        w->woken = true;
+        w->task->delay = 0;
+        if (w->task->state == TASK_BLOCKED)
+            w->task->state = TASK_READY;
+        woken++;
+    }
+    return woken;
+}
+
+int32_t mo_wake(volatile uint32_t *addr, uint32_t n)
+{
+    if (unlikely(!addr || ((uintptr_t) addr & 3)))
+        return ERR_FAIL;
+
+    NOSCHED_ENTER();
+    int32_t woken = _futex_wake(addr, n);
+    NOSCHED_LEAVE();
+
+    return woken;
+}
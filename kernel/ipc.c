@@ -0,0 +1,201 @@
+/* Synchronous Call/Reply IPC
+ *
+ * Each blocked party is described by a wait record living on its own stack,
+ * so no allocation takes place on the IPC path. Records are linked into one
+ * of three global FIFO lists:
+ *   - send_q:  callers whose server is not yet waiting for a request
+ *   - recv_q:  servers waiting in 'mo_ipc_reply_wait()'
+ *   - reply_q: callers whose request was delivered and which await a reply
+ *
+ * Message registers are copied straight from the sender's buffer into the
+ * receiver's buffer, and the CPU is handed directly to the peer through
+ * '_sched_yield_to()' instead of going through the round-robin scheduler.
+ */
+
+#include <sys/ipc.h>
+#include <sys/task.h>
+
+#include "private/error.h"
+#include "private/utils.h"
+
+typedef struct ipc_wait {
+    struct ipc_wait *next;
+    tcb_t *task;          /* Blocked task owning this record */
+    tcb_t *peer;          /* Server being called, or client being served */
+    const ipc_msg_t *msg; /* Caller's request registers */
+    ipc_msg_t *buf;       /* Where the incoming message is copied */
+} ipc_wait_t;
+
+static ipc_wait_t *send_q = NULL;
+static ipc_wait_t *recv_q = NULL;
+static ipc_wait_t *reply_q = NULL;
+
+static void ipc_append(ipc_wait_t **list, ipc_wait_t *w)
+{
+    w->next = NULL;
+    while (*list)
+        list = &(*list)->next;
+    *list = w;
+}
+
+/* Unlink and return the oldest record matching @task and @peer. A NULL
+ * argument matches any value.
+ */
+static ipc_wait_t *ipc_take(ipc_wait_t **list,
+                            const tcb_t *task,
+                            const tcb_t *peer)
+{
+    for (; *list; list = &(*list)->next) {
+        ipc_wait_t *w = *list;
+        if ((!task || w->task == task) && (!peer || w->peer == peer)) {
+            *list = w->next;
+            w->next = NULL;
+            return w;
+        }
+    }
+    return NULL;
+}
+
+/* Recompute the server's donated priority from the callers it still serves */
+static void ipc_redonate(tcb_t *server)
+{
+    _sched_donate_end(server);
+    for (ipc_wait_t *w = reply_q; w; w = w->next) {
+        if (w->peer == server)
+            _sched_donate(server, w->task);
+    }
+}
+
+/* Complete the pending call of @client on @server. Returns the woken client,
+ * or NULL if @client has no call pending on @server.
+ */
+static tcb_t *ipc_reply_locked(tcb_t *server,
+                               uint16_t client,
+                               const ipc_msg_t *reply)
+{
+    tcb_t *task = _task_lookup(client);
+    if (unlikely(!task))
+        return NULL;
+
+    ipc_wait_t *w = ipc_take(&reply_q, task, server);
+    if (unlikely(!w))
+        return NULL;
+
+    *w->buf = *reply;
+    task->state = TASK_READY;
+    ipc_redonate(server);
+    return task;
+}
+
+int32_t mo_ipc_call(uint16_t server, const ipc_msg_t *msg, ipc_msg_t *reply)
+{
+    if (unlikely(!msg || !reply || !server))
+        return ERR_FAIL;
+
+    NOSCHED_ENTER();
+
+    tcb_t *self = kcb->task_current->data;
+    tcb_t *srv = _task_lookup(server);
+    if (unlikely(!srv)) {
+        NOSCHED_LEAVE();
+        return ERR_TASK_NOT_FOUND;
+    }
+    if (unlikely(srv == self)) {
+        NOSCHED_LEAVE();
+        return ERR_FAIL;
+    }
+
+    ipc_wait_t w = {
+        .next = NULL,
+        .task = self,
+        .peer = srv,
+        .msg = msg,
+        .buf = reply,
+    };
+
+    ipc_wait_t *rx = ipc_take(&recv_q, srv, NULL);
+    if (rx) {
+        /* Server is waiting: deliver now and switch straight to it */
+        *rx->buf = *msg;
+        rx->peer = self;
+        ipc_append(&reply_q, &w);
+        _sched_donate(srv, self);
+        srv->state = TASK_READY;
+        self->state = TASK_BLOCKED;
+        _sched_yield_to(srv);
+    } else {
+        /* Queue behind earlier callers until the server receives */
+        ipc_append(&send_q, &w);
+        self->state = TASK_BLOCKED;
+        _yield();
+    }
+
+    /* Woken by the server's reply, which has already filled @reply */
+    NOSCHED_LEAVE();
+    return ERR_OK;
+}
+
+int32_t mo_ipc_reply_wait(uint16_t client,
+                          const ipc_msg_t *reply,
+                          ipc_msg_t *msg)
+{
+    if (unlikely(!msg || (client && !reply)))
+        return ERR_FAIL;
+
+    NOSCHED_ENTER();
+
+    tcb_t *self = kcb->task_current->data;
+    tcb_t *answered = NULL;
+
+    if (client) {
+        answered = ipc_reply_locked(self, client, reply);
+        if (unlikely(!answered)) {
+            NOSCHED_LEAVE();
+            return ERR_IPC_NO_CALL;
+        }
+    }
+
+    /* Receive an already queued call without blocking */
+    ipc_wait_t *tx = ipc_take(&send_q, NULL, self);
+    if (tx) {
+        *msg = *tx->msg;
+        ipc_append(&reply_q, tx);
+        _sched_donate(self, tx->task);
+        int32_t id = tx->task->id;
+        NOSCHED_LEAVE();
+        return id;
+    }
+
+    ipc_wait_t w = {
+        .next = NULL,
+        .task = self,
+        .peer = NULL,
+        .msg = NULL,
+        .buf = msg,
+    };
+    ipc_append(&recv_q, &w);
+    self->state = TASK_BLOCKED;
+
+    /* Hand the CPU back to the client just answered, if any */
+    if (answered)
+        _sched_yield_to(answered);
+    else
+        _yield();
+
+    /* Woken by a caller, which has filled @msg and set itself as peer */
+    int32_t id = w.peer->id;
+    NOSCHED_LEAVE();
+    return id;
+}
+
+int32_t mo_ipc_reply(uint16_t client, const ipc_msg_t *reply)
+{
+    if (unlikely(!client || !reply))
+        return ERR_FAIL;
+
+    NOSCHED_ENTER();
+    tcb_t *answered = ipc_reply_locked(kcb->task_current->data, client, reply);
+    NOSCHED_LEAVE();
+
+    return answered ? ERR_OK : ERR_IPC_NO_CALL;
+}
@@ -3,13 +3,18 @@
  * Design rationale:
  * - Ring buffer + mutex
  * - Logger task at IDLE priority: drains queue without blocking tasks
- * - UART output outside lock: other tasks enqueue while we output
+ * - Batched drain into the HAL's interrupt-driven console (UART TX ring or
+ *   virtio-console): the logger only copies bytes, the device sends them
+ * - Woken by enqueue through a semaphore, no tick polling while idle
+ * - Woken by the console interrupt once a full TX ring has drained
  * - Graceful degradation: fallback to direct output on queue full
  */
 
+#include <hal.h>
 #include <lib/libc.h>
 #include <sys/logger.h>
 #include <sys/mutex.h>
+#include <sys/semaphore.h>
 #include <sys/task.h>
 
 #include "private/error.h"
@@ -24,8 +29,14 @@ typedef struct {
 typedef struct {
     log_entry_t queue[LOG_QSIZE];
     uint32_t head, tail, count;
+    uint16_t sent;    /* Bytes of the tail entry already in the TX ring */
     uint32_t dropped; /* Diagnostic: tracks queue overflow events */
     mutex_t lock;     /* Protects queue manipulation, not UART output */
+    sem_t *wake;      /* Signaled when the queue becomes non-empty */
+    tcb_t *tx_waiter; /* Logger task while it waits for TX room */
+
+    /* Set by the drain hook, so a drain before the wait is not lost */
+    volatile bool tx_drained;
     int32_t task_id;
     bool initialized;
 
@@ -38,34 +49,78 @@ typedef struct {
 
 static logger_state_t logger;
 
+/* Move as many queued messages as fit into the UART TX ring. A message that
+ * only partly fits stays at the tail with 'sent' recording its progress.
+ * Returns true once the queue is empty. Caller holds the lock.
+ */
+static bool logger_drain_locked(void)
+{
+    while (logger.count > 0) {
+        log_entry_t *entry = &logger.queue[logger.tail];
+        uint16_t left = entry->length - logger.sent;
+
+        logger.sent += hal_console_write(entry->data + logger.sent, left);
+        if (logger.sent < entry->length)
+            return false; /* TX ring full */
+
+        logger.sent = 0;
+        logger.tail = (logger.tail + 1) % LOG_QSIZE;
+        logger.count--;
+    }
+    return true;
+}
+
+/* Console drain hook, in interrupt context: readies the waiting logger */
+static void logger_tx_drained(void)
+{
+    logger.tx_drained = true;
+    if (logger.tx_waiter) {
+        _sched_wakeup_irq(logger.tx_waiter);
+        logger.tx_waiter = NULL;
+    }
+}
+
+/* Waits for the console to drain after a write that did not fit, which
+ * armed the drain hook. Blocking with interrupts off means a drain cannot
+ * slip in between the check and blocking.
+ */
+static void logger_wait_tx(void)
+{
+    int32_t was_enabled = _di();
+    tcb_t *self = kcb->task_current->data;
+    bool wait = !logger.tx_drained;
+
+    logger.tx_drained = false;
+    if (wait && kcb->preemptive) {
+        logger.tx_waiter = self;
+        self->state = TASK_BLOCKED;
+    }
+    hal_interrupt_set(was_enabled);
+
+    /* A drain taken right here has readied us already. Cooperative tasks
+     * cannot block here, so they only give the others a turn.
+     */
+    if (wait && (self->state == TASK_BLOCKED || !kcb->preemptive))
+        _yield();
+}
+
 /* Logger task: IDLE priority ensures application tasks run first */
 static void logger_task(void)
 {
-    log_entry_t entry;
-
     while (1) {
-        bool have_message = false;
-
-        /* Critical section: only queue manipulation, not UART I/O */
+        /* Copying into the TX ring is cheap, so it is done under the lock:
+         * the UART interrupt does the slow part while enqueuers proceed.
+         */
         mo_mutex_lock(&logger.lock);
-        if (logger.count > 0) {
-            memcpy(&entry, &logger.queue[logger.tail], sizeof(log_entry_t));
-            logger.tail = (logger.tail + 1) % LOG_QSIZE;
-            logger.count--;
-            have_message = true;
-        }
+        bool idle = logger_drain_locked();
         mo_mutex_unlock(&logger.lock);
 
-        if (have_message) {
-            /* Key design: UART output outside lock prevents blocking enqueuers.
-             * shorter UART write does not hold mutex - other tasks enqueue in
-             * parallel.
-             */
-            for (uint16_t i = 0; i < entry.length; i++)
-                _putchar(entry.data[i]);
+        if (idle) {
+            /* Sleep until the next enqueue */
+            mo_sem_wait(logger.wake);
         } else {
-            /* Block when idle: sleep 1 tick, scheduler wakes us next period */
-            mo_task_delay(1);
+            /* TX ring full: sleep until its interrupt has drained it */
+            logger_wait_tx();
         }
     }
 }
@@ -81,15 +136,23 @@ int32_t mo_logger_init(void)
     if (mo_mutex_init(&logger.lock) != ERR_OK)
         return ERR_FAIL;
 
-    /* 1024B stack: space for log_entry_t (130B) + ISR frame (128B) + calls */
+    logger.wake = mo_sem_create(1, 0);
+    if (!logger.wake) {
+        mo_mutex_destroy(&logger.lock);
+        return ERR_FAIL;
+    }
+
+    /* 1024B stack: ISR frame (128B) + calls */
     logger.task_id = mo_task_spawn(logger_task, 1024);
     if (logger.task_id < 0) {
+        mo_sem_destroy(logger.wake);
         mo_mutex_destroy(&logger.lock);
         return ERR_FAIL;
     }
 
     /* IDLE priority: runs only when no application tasks are ready */
     mo_task_priority(logger.task_id, TASK_PRIO_IDLE);
+    hal_console_on_drain(logger_tx_drained);
 
     logger.initialized = true;
     return ERR_OK;
@@ -123,10 +186,14 @@ int32_t mo_logger_enqueue(const char *msg, uint16_t length)
     entry->data[length] = '\0';
 
     logger.head = (logger.head + 1) % LOG_QSIZE;
-    logger.count++;
+    bool wake = logger.count++ == 0;
 
     mo_mutex_unlock(&logger.lock);
 
+    /* Only the empty to non-empty transition needs to wake the logger */
+    if (wake)
+        mo_sem_signal(logger.wake);
+
     return ERR_OK;
 }
 
@@ -180,10 +247,13 @@ void mo_logger_flush(void)
 
     while (1) {
         bool have_message = false;
+        uint16_t start = 0;
 
         mo_mutex_lock(&logger.lock);
         if (logger.count > 0) {
             memcpy(&entry, &logger.queue[logger.tail], sizeof(log_entry_t));
+            start = logger.sent; /* Skip what the logger already queued */
+            logger.sent = 0;
             logger.tail = (logger.tail + 1) % LOG_QSIZE;
             logger.count--;
             have_message = true;
@@ -196,8 +266,8 @@ void mo_logger_flush(void)
         if (!have_message)
             break;
 
-        /* Output outside lock */
-        for (uint16_t i = 0; i < entry.length; i++)
+        /* Output outside lock; '_putchar()' first drains the TX ring */
+        for (uint16_t i = start; i < entry.length; i++)
             _putchar(entry.data[i]);
     }
 }
@@ -72,6 +72,8 @@ int32_t main(void)
      */
     scheduler_started = true;
 
+    _task_perf_init();
+
     hal_dispatch_init(first_task->context);
 
     /* This line should be unreachable. */
@@ -1,8 +1,10 @@
 /* message queues backed by the generic queue_t */
 
 #include <lib/malloc.h>
+#include <lib/pbuf.h>
 #include <lib/queue.h>
 
+#include <sys/futex.h>
 #include <sys/mqueue.h>
 #include <sys/task.h>
 
@@ -20,6 +22,8 @@ mq_t *mo_mq_create(uint16_t max_items)
         free(mq);
         return NULL;
     }
+    mq->seq = 0;
+    mq->waiters = 0;
     return mq;
 }
 
@@ -56,11 +60,34 @@ int32_t mo_mq_enqueue(mq_t *mq, message_t *msg)
 
     CRITICAL_ENTER();
     rc = queue_enqueue(mq->q, msg);
+    if (rc == ERR_OK)
+        mq->seq++;
     CRITICAL_LEAVE();
 
+    if (rc == ERR_OK && mq->waiters)
+        mo_wake(&mq->seq, 1);
+
     return rc; /* 0 on success, −1 on full */
 }
 
+int32_t mo_mq_send_many(mq_t *mq, message_t *const *msgs, uint32_t n)
+{
+    if (unlikely(!mq || !mq->q || (n && !msgs)))
+        return ERR_FAIL;
+
+    CRITICAL_ENTER();
+    uint32_t sent = queue_enqueue_many(mq->q, (void *const *) msgs, n);
+    if (sent)
+        mq->seq++;
+    CRITICAL_LEAVE();
+
+    /* One wakeup for the whole batch; receivers drain in bulk as well */
+    if (sent && mq->waiters)
+        mo_wake(&mq->seq, WAKE_ALL);
+
+    return (int32_t) sent;
+}
+
 /* remove oldest message (FIFO) */
 message_t *mo_mq_dequeue(mq_t *mq)
 {
@@ -76,6 +103,80 @@ message_t *mo_mq_dequeue(mq_t *mq)
     return msg; /* NULL when queue is empty */
 }
 
+int32_t mo_mq_recv_many(mq_t *mq,
+                        message_t **out,
+                        uint32_t max,
+                        uint16_t timeout)
+{
+    if (unlikely(!mq || !mq->q || !out || !max))
+        return ERR_FAIL;
+
+    uint32_t deadline = mo_ticks() + timeout;
+
+    for (;;) {
+        CRITICAL_ENTER();
+        uint32_t got = queue_dequeue_many(mq->q, (void **) out, max);
+        uint32_t seq = mq->seq;
+        if (!got)
+            mq->waiters++;
+        CRITICAL_LEAVE();
+
+        if (got)
+            return (int32_t) got;
+
+        uint16_t left = 0;
+        if (timeout) {
+            int32_t remaining = (int32_t) (deadline - mo_ticks());
+            left = remaining > 0 ? (uint16_t) remaining : 0;
+        }
+
+        /* Sleep until an enqueue moves 'seq' past the value seen empty */
+        int32_t rc = ERR_TIMEOUT;
+        if (!timeout || left)
+            rc = mo_wait_on(&mq->seq, seq, left);
+
+        CRITICAL_ENTER();
+        mq->waiters--;
+        CRITICAL_LEAVE();
+
+        if (rc == ERR_TIMEOUT)
+            return ERR_TIMEOUT;
+    }
+}
+
+int32_t mo_mq_enqueue_pbuf(mq_t *mq, pbuf_t *p)
+{
+    if (unlikely(!p))
+        return ERR_FAIL;
+
+    /* The carrier lives in the pbuf itself, so queuing allocates nothing.
+     * Its contents only identify the packet, so a packet referenced from
+     * several queues can share it.
+     */
+    p->msg.payload = p;
+    p->msg.type = MQ_TYPE_PBUF;
+    p->msg.size = p->tot_len;
+    return mo_mq_enqueue(mq, &p->msg);
+}
+
+pbuf_t *mo_mq_dequeue_pbuf(mq_t *mq)
+{
+    if (unlikely(!mq || !mq->q))
+        return NULL;
+
+    message_t *msg;
+
+    CRITICAL_ENTER();
+    msg = queue_peek(mq->q);
+    if (msg && msg->type == MQ_TYPE_PBUF)
+        queue_dequeue(mq->q);
+    else
+        msg = NULL;
+    CRITICAL_LEAVE();
+
+    return msg ? msg->payload : NULL;
+}
+
 /* inspect head without removing */
 message_t *mo_mq_peek(mq_t *mq)
 {
@@ -90,3 +191,134 @@ message_t *mo_mq_peek(mq_t *mq)
 
     return msg; /* NULL when queue is empty */
 }
+
+/* Inline fixed-size message queues */
+
+mq_fixed_t *mo_mq_fixed_create(uint16_t elem_size, uint16_t capacity)
+{
+    if (unlikely(!elem_size || !capacity))
+        return NULL;
+
+    /* Descriptor and ring in a single allocation */
+    mq_fixed_t *mq =
+        malloc(sizeof(mq_fixed_t) + (uint32_t) elem_size * capacity);
+    if (unlikely(!mq))
+        return NULL;
+
+    mq->count = 0;
+    mq->not_empty = 0;
+    mq->not_full = 0;
+    mq->elem_size = elem_size;
+    mq->capacity = capacity;
+    mq->head = 0;
+    mq->tail = 0;
+    return mq;
+}
+
+int32_t mo_mq_fixed_destroy(mq_fixed_t *mq)
+{
+    if (unlikely(!mq))
+        return ERR_OK; /* Destroying NULL is no-op */
+
+    if (unlikely(mq->count != 0))
+        return ERR_MQ_NOTEMPTY;
+
+    free(mq);
+    return ERR_OK;
+}
+
+int32_t mo_mq_fixed_trysend(mq_fixed_t *mq, const void *msg)
+{
+    if (unlikely(!mq || !msg))
+        return ERR_FAIL;
+
+    CRITICAL_ENTER();
+    if (unlikely(mq->count == mq->capacity)) {
+        CRITICAL_LEAVE();
+        return ERR_FAIL;
+    }
+
+    memcpy(&mq->buf[(uint32_t) mq->tail * mq->elem_size], msg, mq->elem_size);
+    if (++mq->tail == mq->capacity)
+        mq->tail = 0;
+    mq->count++;
+    mq->not_empty++;
+    CRITICAL_LEAVE();
+
+    mo_wake(&mq->not_empty, 1); /* Hand the message to one blocked receiver */
+    return ERR_OK;
+}
+
+int32_t mo_mq_fixed_tryrecv(mq_fixed_t *mq, void *msg)
+{
+    if (unlikely(!mq || !msg))
+        return ERR_FAIL;
+
+    CRITICAL_ENTER();
+    if (unlikely(mq->count == 0)) {
+        CRITICAL_LEAVE();
+        return ERR_FAIL;
+    }
+
+    memcpy(msg, &mq->buf[(uint32_t) mq->head * mq->elem_size], mq->elem_size);
+    if (++mq->head == mq->capacity)
+        mq->head = 0;
+    mq->count--;
+    mq->not_full++;
+    CRITICAL_LEAVE();
+
+    mo_wake(&mq->not_full, 1); /* Hand the free slot to one blocked sender */
+    return ERR_OK;
+}
+
+/* Block while the sequence word @seq still holds @snap, i.e. until the other
+ * side completed an operation since the caller's attempt. A non-zero
+ * @timeout bounds the total wait at @deadline.
+ */
+static int32_t mq_fixed_wait(volatile uint32_t *seq,
+                             uint32_t snap,
+                             uint16_t timeout,
+                             uint32_t deadline)
+{
+    uint16_t left = 0;
+    if (timeout) {
+        int32_t remaining = (int32_t) (deadline - mo_ticks());
+        if (remaining <= 0)
+            return ERR_TIMEOUT;
+        left = (uint16_t) remaining;
+    }
+
+    /* ERR_WAIT_VALUE just means the state changed meanwhile: retry */
+    return mo_wait_on(seq, snap, left) == ERR_TIMEOUT ? ERR_TIMEOUT : ERR_OK;
+}
+
+int32_t mo_mq_fixed_send(mq_fixed_t *mq, const void *msg, uint16_t timeout)
+{
+    if (unlikely(!mq || !msg))
+        return ERR_FAIL;
+
+    uint32_t deadline = mo_ticks() + timeout;
+    for (;;) {
+        /* Snapshot before trying, so a receive in between is not missed */
+        uint32_t snap = mq->not_full;
+        if (mo_mq_fixed_trysend(mq, msg) == ERR_OK)
+            return ERR_OK;
+        if (mq_fixed_wait(&mq->not_full, snap, timeout, deadline) != ERR_OK)
+            return ERR_TIMEOUT;
+    }
+}
+
+int32_t mo_mq_fixed_recv(mq_fixed_t *mq, void *msg, uint16_t timeout)
+{
+    if (unlikely(!mq || !msg))
+        return ERR_FAIL;
+
+    uint32_t deadline = mo_ticks() + timeout;
+    for (;;) {
+        uint32_t snap = mq->not_empty;
+        if (mo_mq_fixed_tryrecv(mq, msg) == ERR_OK)
+            return ERR_OK;
+        if (mq_fixed_wait(&mq->not_empty, snap, timeout, deadline) != ERR_OK)
+            return ERR_TIMEOUT;
+    }
+}
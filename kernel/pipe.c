@@ -1,4 +1,5 @@
 #include <lib/libc.h>
+#include <lib/pbuf.h>
 #include <sys/pipe.h>
 #include <sys/task.h>
 
@@ -7,7 +8,10 @@
 
 /* Minimum and maximum pipe sizes */
 #define PIPE_MIN_SIZE 4
-#define PIPE_MAX_SIZE 32768
+#define PIPE_MAX_SIZE (1U << 30)
+
+/* Segments of a packet chain handed to one 'mo_pipe_writev()' call */
+#define PIPE_PBUF_IOV 8
 
 /* Enhanced validation with comprehensive integrity checks */
 static inline bool pipe_is_valid(const pipe_t *p)
@@ -29,22 +33,22 @@ static inline bool pipe_is_full(const pipe_t *p)
 }
 
 /* Get available space for writing */
-static inline uint16_t pipe_free_space_internal(const pipe_t *p)
+static inline uint32_t pipe_free_space_internal(const pipe_t *p)
 {
     return (p->mask + 1) - p->used;
 }
 
 /* bulk read operation within critical section */
-static uint16_t pipe_bulk_read(pipe_t *p, char *dst, uint16_t max_bytes)
+static uint32_t pipe_bulk_read(pipe_t *p, char *dst, uint32_t max_bytes)
 {
-    uint16_t bytes_read = 0;
-    uint16_t available = p->used;
-    uint16_t to_read = min(max_bytes, available);
+    uint32_t bytes_read = 0;
+    uint32_t available = p->used;
+    uint32_t to_read = min(max_bytes, available);
 
     while (bytes_read < to_read) {
         /* Calculate contiguous bytes until wrap */
-        uint16_t head_to_end = (p->mask + 1) - p->head;
-        uint16_t chunk_size = min(to_read - bytes_read, head_to_end);
+        uint32_t head_to_end = (p->mask + 1) - p->head;
+        uint32_t chunk_size = min(to_read - bytes_read, head_to_end);
 
         /* Copy contiguous chunk */
         memcpy(dst + bytes_read, p->buf + p->head, chunk_size);
@@ -59,16 +63,16 @@ static uint16_t pipe_bulk_read(pipe_t *p, char *dst, uint16_t max_bytes)
 }
 
 /* bulk write operation within critical section */
-static uint16_t pipe_bulk_write(pipe_t *p, const char *src, uint16_t max_bytes)
+static uint32_t pipe_bulk_write(pipe_t *p, const char *src, uint32_t max_bytes)
 {
-    uint16_t bytes_written = 0;
-    uint16_t available_space = pipe_free_space_internal(p);
-    uint16_t to_write = min(max_bytes, available_space);
+    uint32_t bytes_written = 0;
+    uint32_t available_space = pipe_free_space_internal(p);
+    uint32_t to_write = min(max_bytes, available_space);
 
     while (bytes_written < to_write) {
         /* Calculate contiguous bytes until wrap */
-        uint16_t tail_to_end = (p->mask + 1) - p->tail;
-        uint16_t chunk_size = min(to_write - bytes_written, tail_to_end);
+        uint32_t tail_to_end = (p->mask + 1) - p->tail;
+        uint32_t chunk_size = min(to_write - bytes_written, tail_to_end);
 
         /* Copy contiguous chunk */
         memcpy(p->buf + p->tail, src + bytes_written, chunk_size);
@@ -82,17 +86,85 @@ static uint16_t pipe_bulk_write(pipe_t *p, const char *src, uint16_t max_bytes)
     return bytes_written;
 }
 
+/* Discard bytes from the head of the pipe within critical section */
+static inline void pipe_skip(pipe_t *p, uint32_t n)
+{
+    p->head = (p->head + n) & p->mask;
+    p->used -= n;
+}
+
+/* Gather-write the concatenation of @iov within critical section; the
+ * caller has checked that @total bytes are free.
+ */
+static void pipe_gather_write(pipe_t *p,
+                              const struct iovec *iov,
+                              int iovcnt,
+                              uint32_t total)
+{
+    for (int i = 0; i < iovcnt && total; i++) {
+        uint32_t n = min(iov[i].iov_len, total);
+        pipe_bulk_write(p, iov[i].iov_base, n);
+        total -= n;
+    }
+}
+
+/* Scatter-read up to @max bytes into @iov within critical section */
+static uint32_t pipe_scatter_read(pipe_t *p,
+                                  const struct iovec *iov,
+                                  int iovcnt,
+                                  uint32_t max)
+{
+    uint32_t done = 0;
+    for (int i = 0; i < iovcnt && done < max; i++)
+        done += pipe_bulk_read(p, iov[i].iov_base,
+                               min(iov[i].iov_len, max - done));
+    return done;
+}
+
+/* Write a length-prefixed record within critical section; the caller has
+ * checked that PIPE_RECORD_HDR + @len bytes are free.
+ */
+static void pipe_record_write(pipe_t *p,
+                              const struct iovec *iov,
+                              int iovcnt,
+                              uint32_t len)
+{
+    char hdr[PIPE_RECORD_HDR] = {(char) (len & 0xFF), (char) (len >> 8)};
+    pipe_bulk_write(p, hdr, PIPE_RECORD_HDR);
+    pipe_gather_write(p, iov, iovcnt, len);
+}
+
+/* Read one record within critical section, truncating it to @max bytes.
+ * Returns the bytes copied, or -1 if no record is stored.
+ */
+static int32_t pipe_record_read(pipe_t *p,
+                                const struct iovec *iov,
+                                int iovcnt,
+                                uint32_t max)
+{
+    if (p->used < PIPE_RECORD_HDR)
+        return -1;
+
+    uint8_t hdr[PIPE_RECORD_HDR];
+    pipe_bulk_read(p, (char *) hdr, PIPE_RECORD_HDR);
+    uint32_t len = hdr[0] | ((uint32_t) hdr[1] << 8);
+
+    uint32_t n = pipe_scatter_read(p, iov, iovcnt, min(len, max));
+    pipe_skip(p, len - n);
+    return (int32_t) n;
+}
+
 /* Invalidate pipe during destruction to prevent reuse */
 static inline void pipe_invalidate(pipe_t *p)
 {
     if (p) {
         p->magic = 0xDEADBEEF;
         p->mask = 0;
-        p->used = UINT16_MAX; /* Invalid state */
+        p->used = UINT32_MAX; /* Invalid state */
     }
 }
 
-pipe_t *mo_pipe_create(uint16_t size)
+pipe_t *mo_pipe_create(uint32_t size)
 {
     /* Input validation and size adjustment */
     if (unlikely(size < PIPE_MIN_SIZE))
@@ -113,6 +185,7 @@ pipe_t *mo_pipe_create(uint16_t size)
     p->buf = NULL;
     p->mask = 0;
     p->head = p->tail = p->used = 0;
+    p->mode = PIPE_MODE_STREAM;
     p->magic = 0;
 
     /* Allocate buffer with alignment for better performance */
@@ -161,12 +234,29 @@ void mo_pipe_flush(pipe_t *p)
     CRITICAL_LEAVE();
 }
 
+int32_t mo_pipe_set_mode(pipe_t *p, uint8_t mode)
+{
+    if (unlikely(!pipe_is_valid(p) ||
+                 (mode != PIPE_MODE_STREAM && mode != PIPE_MODE_RECORD)))
+        return ERR_FAIL;
+
+    CRITICAL_ENTER();
+    if (unlikely(!pipe_is_empty(p))) {
+        CRITICAL_LEAVE();
+        return ERR_FAIL;
+    }
+    p->mode = mode;
+    CRITICAL_LEAVE();
+
+    return ERR_OK;
+}
+
 int32_t mo_pipe_size(pipe_t *p)
 {
     if (unlikely(!pipe_is_valid(p)))
         return -1;
 
-    /* Volatile read is atomic for 16-bit values on RV32I */
+    /* Aligned 32-bit volatile read is atomic on RV32I */
     return (int32_t) p->used;
 }
 
@@ -219,13 +309,78 @@ static void pipe_wait_until_writable(pipe_t *p)
     }
 }
 
+/* Write @len bytes gathered from @iov (plus a record header in record mode)
+ * in a single critical section, waiting until all of it fits. Checking for
+ * space and writing under the same critical section is what keeps
+ * concurrent writers from interleaving.
+ */
+static void pipe_write_atomic(pipe_t *p,
+                              const struct iovec *iov,
+                              int iovcnt,
+                              uint32_t len)
+{
+    bool record = p->mode == PIPE_MODE_RECORD;
+    uint32_t need = len + (record ? PIPE_RECORD_HDR : 0);
+
+    while (1) {
+        CRITICAL_ENTER();
+        if (pipe_free_space_internal(p) >= need) {
+            if (record)
+                pipe_record_write(p, iov, iovcnt, len);
+            else
+                pipe_gather_write(p, iov, iovcnt, len);
+            CRITICAL_LEAVE();
+            return;
+        }
+        CRITICAL_LEAVE();
+        mo_task_wfi(); /* Yield CPU without blocking task state */
+    }
+}
+
+/* Blocking record read, shared by 'mo_pipe_read()' and 'mo_pipe_readv()' */
+static int32_t pipe_record_read_wait(pipe_t *p,
+                                     const struct iovec *iov,
+                                     int iovcnt,
+                                     uint32_t max)
+{
+    while (1) {
+        CRITICAL_ENTER();
+        int32_t n = pipe_record_read(p, iov, iovcnt, max);
+        CRITICAL_LEAVE();
+        if (n >= 0)
+            return n;
+        mo_task_wfi();
+    }
+}
+
+/* Whether a write of @len bytes must go in as one piece, and can */
+static int32_t pipe_write_class(const pipe_t *p, uint32_t len)
+{
+    uint32_t capacity = p->mask + 1;
+
+    /* Records are always atomic and must fit the pipe whole */
+    if (p->mode == PIPE_MODE_RECORD)
+        return (len > PIPE_RECORD_MAX || len > capacity - PIPE_RECORD_HDR)
+                   ? ERR_FAIL
+                   : 1;
+
+    /* PIPE_BUF semantics: small writes go in as one piece */
+    return (len <= PIPE_BUF && len <= capacity) ? 1 : 0;
+}
+
 /* Blocking read with optimized bulk operations */
-int32_t mo_pipe_read(pipe_t *p, char *dst, uint16_t len)
+int32_t mo_pipe_read(pipe_t *p, char *dst, uint32_t len)
 {
     if (unlikely(!pipe_is_valid(p) || !dst || !len))
         return ERR_FAIL;
 
-    uint16_t bytes_read = 0;
+    /* Record mode: wait for and return exactly one record */
+    if (p->mode == PIPE_MODE_RECORD) {
+        struct iovec iov = {dst, len};
+        return pipe_record_read_wait(p, &iov, 1, len);
+    }
+
+    uint32_t bytes_read = 0;
 
     while (bytes_read < len) {
         /* Wait for data to become available */
@@ -233,7 +388,7 @@ int32_t mo_pipe_read(pipe_t *p, char *dst, uint16_t len)
 
         /* Read as much as possible in one critical section */
         CRITICAL_ENTER();
-        uint16_t chunk = pipe_bulk_read(p, dst + bytes_read, len - bytes_read);
+        uint32_t chunk = pipe_bulk_read(p, dst + bytes_read, len - bytes_read);
         CRITICAL_LEAVE();
 
         bytes_read += chunk;
@@ -245,12 +400,21 @@ int32_t mo_pipe_read(pipe_t *p, char *dst, uint16_t len)
 }
 
 /* Blocking write with optimized bulk operations */
-int32_t mo_pipe_write(pipe_t *p, const char *src, uint16_t len)
+int32_t mo_pipe_write(pipe_t *p, const char *src, uint32_t len)
 {
     if (unlikely(!pipe_is_valid(p) || !src || len == 0))
         return ERR_FAIL;
 
-    uint16_t bytes_written = 0;
+    int32_t atomic = pipe_write_class(p, len);
+    if (unlikely(atomic < 0))
+        return atomic;
+    if (atomic) {
+        struct iovec iov = {(void *) src, len};
+        pipe_write_atomic(p, &iov, 1, len);
+        return (int32_t) len;
+    }
+
+    uint32_t bytes_written = 0;
 
     while (bytes_written < len) {
         /* Wait for space to become available */
@@ -258,7 +422,7 @@ int32_t mo_pipe_write(pipe_t *p, const char *src, uint16_t len)
 
         /* Write as much as possible in one critical section */
         CRITICAL_ENTER();
-        uint16_t chunk =
+        uint32_t chunk =
             pipe_bulk_write(p, src + bytes_written, len - bytes_written);
         CRITICAL_LEAVE();
 
@@ -272,31 +436,197 @@ int32_t mo_pipe_write(pipe_t *p, const char *src, uint16_t len)
 }
 
 /* Non-blocking read with optimized bulk operations */
-int32_t mo_pipe_nbread(pipe_t *p, char *dst, uint16_t len)
+int32_t mo_pipe_nbread(pipe_t *p, char *dst, uint32_t len)
 {
     if (unlikely(!pipe_is_valid(p) || !dst || len == 0))
         return ERR_FAIL;
 
-    uint16_t bytes_read;
+    int32_t bytes_read;
 
     CRITICAL_ENTER();
-    bytes_read = pipe_bulk_read(p, dst, len);
+    if (p->mode == PIPE_MODE_RECORD) {
+        struct iovec iov = {dst, len};
+        bytes_read = pipe_record_read(p, &iov, 1, len);
+        if (bytes_read < 0)
+            bytes_read = 0;
+    } else {
+        bytes_read = pipe_bulk_read(p, dst, len);
+    }
     CRITICAL_LEAVE();
 
-    return (int32_t) bytes_read;
+    return bytes_read;
 }
 
 /* Non-blocking write with optimized bulk operations */
-int32_t mo_pipe_nbwrite(pipe_t *p, const char *src, uint16_t len)
+int32_t mo_pipe_nbwrite(pipe_t *p, const char *src, uint32_t len)
 {
     if (unlikely(!pipe_is_valid(p) || !src || len == 0))
         return ERR_FAIL;
 
-    uint16_t bytes_written;
+    uint32_t bytes_written = 0;
+
+    /* A record that can never fit must fail, not report "no room yet" */
+    if (p->mode == PIPE_MODE_RECORD &&
+        unlikely(pipe_write_class(p, len) < 0))
+        return ERR_FAIL;
 
     CRITICAL_ENTER();
-    bytes_written = pipe_bulk_write(p, src, len);
+    if (p->mode != PIPE_MODE_RECORD) {
+        bytes_written = pipe_bulk_write(p, src, len);
+    } else if (pipe_free_space_internal(p) >= len + PIPE_RECORD_HDR) {
+        struct iovec iov = {(void *) src, len};
+        pipe_record_write(p, &iov, 1, len);
+        bytes_written = len;
+    }
     CRITICAL_LEAVE();
 
     return (int32_t) bytes_written;
 }
+
+/* Total length of an iovec array, or -1 if it is malformed */
+static int64_t pipe_iov_total(const struct iovec *iov, int iovcnt)
+{
+    int64_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        if (unlikely(!iov[i].iov_base && iov[i].iov_len))
+            return -1;
+        total += iov[i].iov_len;
+    }
+    return total > INT32_MAX ? -1 : total;
+}
+
+int32_t mo_pipe_writev(pipe_t *p, const struct iovec *iov, int iovcnt)
+{
+    if (unlikely(!pipe_is_valid(p) || !iov || iovcnt <= 0))
+        return ERR_FAIL;
+
+    int64_t total = pipe_iov_total(iov, iovcnt);
+    if (unlikely(total <= 0))
+        return ERR_FAIL;
+
+    int32_t atomic = pipe_write_class(p, (uint32_t) total);
+    if (unlikely(atomic < 0))
+        return atomic;
+    if (atomic) {
+        pipe_write_atomic(p, iov, iovcnt, (uint32_t) total);
+        return (int32_t) total;
+    }
+
+    /* Large stream write: gather as much as fits per critical section */
+    for (int i = 0; i < iovcnt; i++) {
+        const char *src = iov[i].iov_base;
+        uint32_t done = 0;
+        while (done < iov[i].iov_len) {
+            pipe_wait_until_writable(p);
+            CRITICAL_ENTER();
+            do {
+                done += pipe_bulk_write(p, src + done, iov[i].iov_len - done);
+                if (done == iov[i].iov_len && i + 1 < iovcnt) {
+                    src = iov[++i].iov_base;
+                    done = 0;
+                }
+            } while (done < iov[i].iov_len && !pipe_is_full(p));
+            CRITICAL_LEAVE();
+        }
+    }
+    return (int32_t) total;
+}
+
+int32_t mo_pipe_readv(pipe_t *p, const struct iovec *iov, int iovcnt)
+{
+    if (unlikely(!pipe_is_valid(p) || !iov || iovcnt <= 0))
+        return ERR_FAIL;
+
+    int64_t total = pipe_iov_total(iov, iovcnt);
+    if (unlikely(total <= 0))
+        return ERR_FAIL;
+
+    if (p->mode == PIPE_MODE_RECORD)
+        return pipe_record_read_wait(p, iov, iovcnt, (uint32_t) total);
+
+    /* Scatter whatever is available per critical section until filled */
+    for (int i = 0; i < iovcnt; i++) {
+        char *dst = iov[i].iov_base;
+        uint32_t done = 0;
+        while (done < iov[i].iov_len) {
+            pipe_wait_until_readable(p);
+            CRITICAL_ENTER();
+            do {
+                done += pipe_bulk_read(p, dst + done, iov[i].iov_len - done);
+                if (done == iov[i].iov_len && i + 1 < iovcnt) {
+                    dst = iov[++i].iov_base;
+                    done = 0;
+                }
+            } while (done < iov[i].iov_len && !pipe_is_empty(p));
+            CRITICAL_LEAVE();
+        }
+    }
+    return (int32_t) total;
+}
+
+/* Scatter/gather I/O on packet buffers, one segment at a time */
+int32_t mo_pipe_write_pbuf(pipe_t *p, const pbuf_t *pb)
+{
+    if (unlikely(!pipe_is_valid(p) || !pb || p->mode != PIPE_MODE_STREAM))
+        return ERR_FAIL;
+
+    struct iovec iov[PIPE_PBUF_IOV];
+    int iovcnt = 0;
+    int32_t total = 0;
+
+    /* A chain of up to PIPE_BUF bytes in more segments than one writev takes
+     * is gathered first, so that it still goes in as one unit.
+     */
+    if (pb->tot_len <= PIPE_BUF) {
+        uint32_t segs = 0;
+        for (const pbuf_t *q = pb; q; q = q->next)
+            segs += q->len != 0;
+        if (segs > PIPE_PBUF_IOV) {
+            char bounce[PIPE_BUF];
+            for (const pbuf_t *q = pb; q; q = q->next) {
+                memcpy(bounce + total, q->payload, q->len);
+                total += q->len;
+            }
+            return mo_pipe_write(p, bounce, total);
+        }
+    }
+
+    for (; pb; pb = pb->next) {
+        if (!pb->len)
+            continue;
+        iov[iovcnt++] = (struct iovec){pb->payload, pb->len};
+        if (iovcnt == PIPE_PBUF_IOV) {
+            int32_t n = mo_pipe_writev(p, iov, iovcnt);
+            if (unlikely(n < 0))
+                return n;
+            total += n;
+            iovcnt = 0;
+        }
+    }
+    if (iovcnt) {
+        int32_t n = mo_pipe_writev(p, iov, iovcnt);
+        if (unlikely(n < 0))
+            return n;
+        total += n;
+    }
+    return total;
+}
+
+int32_t mo_pipe_read_pbuf(pipe_t *p, pbuf_t *pb, uint32_t len)
+{
+    if (unlikely(!pipe_is_valid(p) || !pb || !len || len > pb->tot_len ||
+                 p->mode != PIPE_MODE_STREAM))
+        return ERR_FAIL;
+
+    uint32_t total = 0;
+    for (; pb && total < len; pb = pb->next) {
+        uint32_t chunk = min(pb->len, (uint32_t) (len - total));
+        if (!chunk)
+            continue;
+        int32_t n = mo_pipe_read(p, (char *) pb->payload, chunk);
+        if (unlikely(n < 0))
+            return n;
+        total += chunk;
+    }
+    return (int32_t) total;
+}
@@ -0,0 +1,104 @@
+/* Statistical PC-Sampling Profiler
+ *
+ * Samples are written by the timer trap into a fixed ring and only read back
+ * once sampling has stopped, so no locking is needed beyond starting and
+ * stopping the sampling timer itself.
+ */
+
+#include <hal.h>
+#include <lib/libc.h>
+#include <sys/profiler.h>
+#include <sys/task.h>
+
+#include "private/error.h"
+#include "private/utils.h"
+
+#if CONFIG_PROFILER
+
+typedef struct {
+    uint16_t task; /* ID of the interrupted task, 0 if none */
+    uint32_t pc;   /* Interrupted program counter */
+} prof_sample_t;
+
+static prof_sample_t samples[PROF_SAMPLES];
+static volatile uint32_t sample_count = 0; /* Total taken, may exceed ring */
+static uint32_t sample_hz = 0;
+static bool running = false;
+
+/* Timer trap hook: record one sample, overwriting the oldest when full */
+static void prof_sample(uint32_t epc)
+{
+    uint32_t n = sample_count;
+    prof_sample_t *s = &samples[n % PROF_SAMPLES];
+
+    s->task = kcb->task_current ? ((tcb_t *) kcb->task_current->data)->id : 0;
+    s->pc = epc;
+    sample_count = n + 1;
+}
+
+int32_t mo_prof_start(uint32_t hz)
+{
+    if (unlikely(!hz || hz > PROF_MAX_HZ))
+        return ERR_FAIL;
+
+    hal_prof_timer_stop();
+    sample_count = 0;
+    sample_hz = hz;
+    running = true;
+    hal_prof_timer_start(F_CPU / hz, prof_sample);
+    return ERR_OK;
+}
+
+int32_t mo_prof_stop(void)
+{
+    hal_prof_timer_stop();
+    running = false;
+    return ERR_OK;
+}
+
+uint32_t mo_prof_count(void)
+{
+    return sample_count;
+}
+
+int32_t mo_prof_dump(void)
+{
+    if (running)
+        mo_prof_stop();
+
+    uint32_t total = sample_count;
+    uint32_t kept = total < PROF_SAMPLES ? total : PROF_SAMPLES;
+
+    printf("PROF BEGIN %u %u %u\n", (unsigned) sample_hz, (unsigned) kept,
+           (unsigned) (total - kept));
+    for (uint32_t i = total - kept; i < total; i++) {
+        const prof_sample_t *s = &samples[i % PROF_SAMPLES];
+        printf("PROF %u %08x\n", (unsigned) s->task, (unsigned) s->pc);
+    }
+    printf("PROF END\n");
+    return ERR_OK;
+}
+
+#else /* !CONFIG_PROFILER */
+
+int32_t mo_prof_start(uint32_t hz)
+{
+    return ERR_FAIL;
+}
+
+int32_t mo_prof_stop(void)
+{
+    return ERR_FAIL;
+}
+
+uint32_t mo_prof_count(void)
+{
+    return 0;
+}
+
+int32_t mo_prof_dump(void)
+{
+    return ERR_FAIL;
+}
+
+#endif /* CONFIG_PROFILER */
@@ -0,0 +1,91 @@
+/* Protothread Runner
+ *
+ * A runner is a singly linked list walked in order, one call per runnable
+ * protothread per round. Sleeping protothreads are skipped by comparing
+ * their deadline, so they cost nothing until due. The runner only touches
+ * state owned by its host task and needs no locking.
+ */
+
+#include <lib/libc.h>
+#include <sys/pt.h>
+#include <sys/task.h>
+
+#include "private/error.h"
+#include "private/utils.h"
+
+void mo_pt_init(pt_t *pt, pt_fn_t fn, void *arg)
+{
+    if (unlikely(!pt))
+        return;
+
+    pt->lc = 0;
+    pt->state = PT_YIELDED;
+    pt->flag = false;
+    pt->deadline = 0;
+    pt->fn = fn;
+    pt->arg = arg;
+    pt->next = NULL;
+}
+
+int32_t mo_pt_add(pt_runner_t *runner, pt_t *pt)
+{
+    if (unlikely(!runner || !pt || !pt->fn))
+        return ERR_FAIL;
+
+    /* Append, so a protothread added during a round cannot be unlinked
+     * together with the one removed in front of it.
+     */
+    pt_t **link = &runner->head;
+    while (*link)
+        link = &(*link)->next;
+
+    pt->next = NULL;
+    *link = pt;
+    runner->count++;
+    return ERR_OK;
+}
+
+uint32_t mo_pt_poll(pt_runner_t *runner)
+{
+    pt_t **link = &runner->head;
+
+    while (*link) {
+        pt_t *pt = *link;
+
+        if (pt->state == PT_SLEEPING && !PT_EXPIRED(pt->deadline)) {
+            link = &pt->next;
+            continue;
+        }
+
+        pt->state = pt->fn(pt);
+        if (pt->state == PT_EXITED) {
+            *link = pt->next;
+            runner->count--;
+        } else {
+            link = &pt->next;
+        }
+    }
+    return runner->count;
+}
+
+void mo_pt_run(pt_runner_t *runner)
+{
+    while (mo_pt_poll(runner)) {
+        /* Sleep to the earliest deadline if every protothread is sleeping,
+         * otherwise just give other tasks a turn before the next round.
+         */
+        uint32_t now = mo_ticks();
+        int32_t idle = INT32_MAX;
+        for (pt_t *pt = runner->head; pt && idle > 0; pt = pt->next) {
+            int32_t left = pt->state == PT_SLEEPING
+                               ? (int32_t) (pt->deadline - now)
+                               : 0;
+            idle = min(idle, left);
+        }
+
+        if (idle > 0)
+            mo_task_delay(min(idle, (int32_t) UINT16_MAX));
+        else
+            mo_task_yield();
+    }
+}
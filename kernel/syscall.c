@@ -1,9 +1,11 @@
 #include <hal.h>
+#include <lib/libc.h>
 #include <sys/errno.h>
+#include <sys/fd.h>
+#include <sys/fs.h>
 #include <sys/syscall.h>
 #include <sys/task.h>
 
-#include "private/stdio.h"
 #include "private/utils.h"
 
 /* syscall wrappers */
@@ -33,7 +35,19 @@ static char *_env[1] = {0};
 char **environ = _env;
 int errno = 0;
 
-/* UNIX syscalls (dummy implementation) */
+/* Converts a negative errno return into errno and -1 */
+static int fd_result(int32_t ret)
+{
+    if (ret < 0) {
+        errno = -ret;
+        return -1;
+    }
+    return ret;
+}
+
+/* UNIX syscalls: files, pipes and the console go through the descriptor
+ * table; process management is not supported.
+ */
 
 static int _fork(void)
 {
@@ -58,8 +72,7 @@ static int _wait(int *status)
 
 static int _pipe(int fildes[2])
 {
-    errno = EFAULT;
-    return -1;
+    return fd_result(mo_fd_pipe(fildes));
 }
 
 static int _kill(int pid, int sig)
@@ -76,8 +89,7 @@ static int _execve(char *name, char **argv, char **env)
 
 static int _dup(int oldfd)
 {
-    errno = EBADF;
-    return -1;
+    return fd_result(mo_fd_dup(oldfd));
 }
 
 static int _getpid(void)
@@ -123,23 +135,25 @@ static int _stat(char *file, struct stat *st)
         return -1;
     }
 
+    if (file && mo_fs_mounted())
+        return fd_result(mo_fs_stat(file, st));
+
     st->st_mode = S_IFCHR;
     return 0;
 }
 
 static int _open(char *path, int flags)
 {
-    errno = ENOENT;
-    return -1;
+    if (unlikely(!path)) {
+        errno = EFAULT;
+        return -1;
+    }
+    return fd_result(mo_fd_open(path, flags));
 }
 
 static int _close(int file)
 {
-    if (unlikely(file < 0)) {
-        errno = EBADF;
-        return -1;
-    }
-    return -1;
+    return fd_result(mo_fd_close(file));
 }
 
 static int _read(int file, char *ptr, int len)
@@ -148,17 +162,7 @@ static int _read(int file, char *ptr, int len)
         errno = EFAULT;
         return -1;
     }
-
-    if (unlikely(file < 0)) {
-        errno = EBADF;
-        return -1;
-    }
-
-    int idx;
-    for (idx = 0; idx < len; idx++)
-        *ptr++ = _getchar();
-
-    return len;
+    return fd_result(mo_fd_read(file, ptr, len));
 }
 
 static int _write(int file, char *ptr, int len)
@@ -167,26 +171,12 @@ static int _write(int file, char *ptr, int len)
         errno = EFAULT;
         return -1;
     }
-
-    if (unlikely(file < 0)) {
-        errno = EBADF;
-        return -1;
-    }
-
-    int idx;
-    for (idx = 0; idx < len; idx++)
-        _putchar(*ptr++);
-
-    return len;
+    return fd_result(mo_fd_write(file, ptr, len));
 }
 
 static int _lseek(int file, int ptr, int dir)
 {
-    if (unlikely(file < 0)) {
-        errno = EBADF;
-        return -1;
-    }
-    return 0;
+    return fd_result(mo_fd_seek(file, ptr, dir));
 }
 
 static int _chdir(const char *path)
@@ -215,8 +205,7 @@ static int _unlink(char *name)
         errno = EFAULT;
         return -1;
     }
-    errno = ENOENT;
-    return -1;
+    return fd_result(mo_fs_unlink(name));
 }
 
 static int _link(char *old, char *new)
@@ -229,6 +218,28 @@ static int _link(char *old, char *new)
     return -1;
 }
 
+static int _fstat(int fd, struct stat *st)
+{
+    if (unlikely(!st)) {
+        errno = EFAULT;
+        return -1;
+    }
+    return fd_result(mo_fd_fstat(fd, st));
+}
+
+static int _isatty(int fd)
+{
+    struct stat st;
+
+    if (_fstat(fd, &st) < 0)
+        return 0;
+    if (!S_ISCHR(st.st_mode)) {
+        errno = ENOTTY;
+        return 0;
+    }
+    return 1;
+}
+
 /* Linmo syscalls (wrapper implementation) */
 
 static int _tadd(void *task, int stack_size)
@@ -39,6 +39,45 @@ volatile bool scheduler_started = false;
 static volatile uint32_t timer_work_pending = 0;    /* timer work types */
 static volatile uint32_t timer_work_generation = 0; /* counter for coalescing */
 
+/* Set by dispatcher() while handling a timer tick, so that dispatch() can
+ * tell involuntary preemption apart from a voluntary yield.
+ */
+static bool sched_from_tick = false;
+
+/* Pending directed handoff: the next switch away from 'handoff_from' goes
+ * straight to 'handoff_to' instead of through the scheduling decision.
+ */
+static tcb_t *handoff_from = NULL;
+static tcb_t *handoff_to = NULL;
+
+/* Task a preemption threshold let a tick displace; it runs again as soon as
+ * its preemptor gives up the CPU.
+ */
+static uint16_t threshold_resume_id = 0;
+
+/* Task readied by an interrupt handler, switched to on interrupt exit */
+static tcb_t *irq_woken = NULL;
+
+/* Round-robin position saved by the first handoff of a chain. The next
+ * regular selection resumes from there, so the tasks a handoff jumped over
+ * are not pushed back by a full round.
+ */
+static uint16_t rr_resume_id = 0;
+
+/* Virtualized performance counter slots */
+#define PERF_SLOT_CYCLE 0
+#define PERF_SLOT_INSTRET 1
+#define PERF_SLOT_EVENT 2 /* First slot bound by mo_task_perf_event() */
+
+/* Hardware counter behind each slot (0 = unbound event slot), and its value
+ * at the last context switch.
+ */
+static uint32_t perf_counter[TASK_PERF_COUNTERS] = {
+    [PERF_SLOT_CYCLE] = HAL_PERF_CYCLE,
+    [PERF_SLOT_INSTRET] = HAL_PERF_INSTRET,
+};
+static uint64_t perf_mark[TASK_PERF_COUNTERS];
+
 /* Timer work types for prioritized processing */
 #define TIMER_WORK_TICK_HANDLER (1U << 0) /* Standard timer callbacks */
 #define TIMER_WORK_DELAY_UPDATE (1U << 1) /* Task delay processing */
@@ -110,6 +149,37 @@ static inline uint8_t extract_priority_level(uint16_t prio)
     }
 }
 
+/* The running task holds the scheduler lock and has not blocked, so any
+ * context switch must be deferred until it releases the lock.
+ */
+static inline bool sched_switch_deferred(const tcb_t *task)
+{
+    return task->sched_lock &&
+           (task->state == TASK_RUNNING || task->state == TASK_READY);
+}
+
+/* Finds the task a tick should switch to while @task runs under a raised
+ * preemption threshold: the highest-priority ready task above the threshold,
+ * or NULL if there is none and @task keeps the CPU. Without per-level ready
+ * queues this scans the master list, and only for tasks that opted into a
+ * threshold.
+ */
+static tcb_t *sched_threshold_preemptor(const tcb_t *task)
+{
+    tcb_t *best = NULL;
+
+    list_node_t *node = kcb->tasks->head->next;
+    while (node != kcb->tasks->tail) {
+        tcb_t *t = node->data;
+        if (t && t != task && t->state == TASK_READY &&
+            t->prio_level < task->preempt_threshold &&
+            (!best || t->prio_level < best->prio_level))
+            best = t;
+        node = node->next;
+    }
+    return best;
+}
+
 static inline bool is_valid_task(tcb_t *task)
 {
     return (task && task->stack && task->stack_sz >= MIN_TASK_STACK_SIZE &&
@@ -168,6 +238,38 @@ static void task_stack_check(void)
 #endif /* CONFIG_STACK_PROTECTION */
 
 /* Batch delay processing for blocked tasks */
+/* Task flag: the delay has run out and the task is inside its slack window */
+#define TASK_FLAG_SLACK (1U << 0)
+
+/* Set when a task enters its slack window; cleared by the flush pass */
+static bool delay_slack_pending = false;
+
+/* Make a task whose delay has expired ready to run */
+static void delay_wake(tcb_t *t, uint32_t *ready_count)
+{
+    t->state = TASK_READY;
+    t->delay = 0;
+    t->flags &= ~TASK_FLAG_SLACK;
+
+    /* If this is an RT task, set its deadline for the next job.
+     * For periodic tasks, deadline should be current_time + period.
+     * This ensures tasks are scheduled based on their actual deadlines,
+     * not inflated values from previous scheduler calls.
+     */
+    if (t->rt_prio) {
+        typedef struct {
+            uint32_t period;
+            uint32_t deadline;
+        } edf_prio_t;
+        edf_prio_t *edf = (edf_prio_t *) t->rt_prio;
+        edf->deadline = kcb->ticks + edf->period;
+    }
+
+    /* Add to appropriate priority ready queue */
+    sched_enqueue_task(t);
+    (*ready_count)++;
+}
+
 static list_node_t *delay_update_batch(list_node_t *node, void *arg)
 {
     uint32_t *ready_count = (uint32_t *) arg;
@@ -181,33 +283,49 @@ static list_node_t *delay_update_batch(list_node_t *node, void *arg)
         return NULL;
 
     /* Process delays only if tick actually advanced */
-    if (t->delay > 0) {
-        if (--t->delay == 0) {
-            t->state = TASK_READY;
-
-            /* If this is an RT task, set its deadline for the next job.
-             * For periodic tasks, deadline should be current_time + period.
-             * This ensures tasks are scheduled based on their actual deadlines,
-             * not inflated values from previous scheduler calls.
-             */
-            if (t->rt_prio) {
-                typedef struct {
-                    uint32_t period;
-                    uint32_t deadline;
-                } edf_prio_t;
-                edf_prio_t *edf = (edf_prio_t *) t->rt_prio;
-                extern kcb_t *kcb;
-                edf->deadline = kcb->ticks + edf->period;
-            }
-
-            /* Add to appropriate priority ready queue */
-            sched_enqueue_task(t);
-            (*ready_count)++;
+    if (t->delay > 0 && --t->delay == 0) {
+        /* Minimum delay elapsed: keep counting down the slack window, during
+         * which the task is only woken together with another task.
+         */
+        if (t->delay_slack) {
+            t->delay = t->delay_slack;
+            t->delay_slack = 0;
+            t->flags |= TASK_FLAG_SLACK;
+            delay_slack_pending = true;
+            return NULL;
         }
+        delay_wake(t, ready_count);
     }
     return NULL;
 }
 
+/* Wake tasks inside their slack window, piggybacking on another wakeup */
+static list_node_t *delay_slack_flush(list_node_t *node, void *arg)
+{
+    if (unlikely(!node || !node->data))
+        return NULL;
+
+    tcb_t *t = node->data;
+    if (t->state == TASK_BLOCKED && (t->flags & TASK_FLAG_SLACK))
+        delay_wake(t, (uint32_t *) arg);
+    return NULL;
+}
+
+/* Counts every delay down by one, waking the tasks whose delay ran out and,
+ * if any woke, those inside their slack window. Returns the tasks woken.
+ */
+static uint32_t delay_advance(void)
+{
+    uint32_t ready_count = 0;
+
+    list_foreach(kcb->tasks, delay_update_batch, &ready_count);
+    if (ready_count && delay_slack_pending) {
+        list_foreach(kcb->tasks, delay_slack_flush, &ready_count);
+        delay_slack_pending = false;
+    }
+    return ready_count;
+}
+
 /* timer work processing with coalescing and prioritization */
 static inline void process_timer_work(uint32_t work_mask)
 {
@@ -245,28 +363,6 @@ static inline void process_deferred_timer_work(void)
     }
 }
 
-/* delay update for cooperative mode */
-static list_node_t *delay_update(list_node_t *node, void *arg)
-{
-    (void) arg;
-    if (unlikely(!node || !node->data))
-        return NULL;
-
-    tcb_t *t = node->data;
-
-    /* Skip non-blocked tasks (common case) */
-    if (likely(t->state != TASK_BLOCKED))
-        return NULL;
-
-    /* Decrement delay and unblock task if expired */
-    if (t->delay > 0 && --t->delay == 0) {
-        t->state = TASK_READY;
-        /* Add to appropriate priority ready queue */
-        sched_enqueue_task(t);
-    }
-    return NULL;
-}
-
 /* Task search callbacks for finding tasks in the master list. */
 static list_node_t *idcmp(list_node_t *node, void *arg)
 {
@@ -367,6 +463,44 @@ static void sched_enqueue_task(tcb_t *task)
     /* Task selection is handled directly through the master task list */
 }
 
+/* Consume a pending directed handoff. Succeeds only if it was requested by
+ * the task being switched away from and the target is still READY; stale
+ * requests are dropped so a later switch cannot be misdirected. A task that
+ * blocks on the handoff (an IPC call or reply) lends the target the rest of
+ * its time slice, as IPC lends its priority, so a call/reply exchange runs
+ * on the caller's quantum instead of starting a fresh one at every hop.
+ */
+static bool sched_take_handoff(void)
+{
+    tcb_t *target = handoff_to;
+    tcb_t *from = handoff_from;
+    handoff_to = handoff_from = NULL;
+
+    if (likely(!target))
+        return false;
+
+    tcb_t *current = kcb->task_current->data;
+    if (from != current || target->state != TASK_READY)
+        return false;
+
+    list_node_t *node = find_task_node_by_id(target->id);
+    if (unlikely(!node))
+        return false;
+
+    bool lend = current->state == TASK_BLOCKED && current->time_slice;
+    if (current->state == TASK_RUNNING)
+        current->state = TASK_READY;
+
+    if (!rr_resume_id)
+        rr_resume_id = current->id;
+
+    kcb->task_current = node;
+    target->state = TASK_RUNNING;
+    target->time_slice = lend ? current->time_slice
+                              : get_priority_timeslice(target->prio_level);
+    return true;
+}
+
 /* Remove task from ready queues - state-based approach for compatibility */
 void sched_dequeue_task(tcb_t *task)
 {
@@ -379,7 +513,95 @@ void sched_dequeue_task(tcb_t *task)
      */
 }
 
-/* Handle time slice expiration for current task */
+/* Charge one tick to a budgeted task and throttle it once the budget of its
+ * current period is spent. Periods are aligned to 'budget_start', so the
+ * replenishment happens lazily on the first charge of a new period.
+ */
+static void sched_budget_charge(tcb_t *task)
+{
+    uint32_t elapsed = kcb->ticks - task->budget_start;
+    if (elapsed >= task->budget_period) {
+        task->budget_start += elapsed - elapsed % task->budget_period;
+        task->budget_used = 0;
+    }
+
+    if (task->budget_used < task->budget)
+        task->budget_used++;
+
+    if (task->budget_used < task->budget || task->sched_lock ||
+        task->state != TASK_RUNNING)
+        return;
+
+    /* Sleep until the next period; the delay pass of this tick's dispatch
+     * already counts down once, hence the extra tick.
+     */
+    task->delay = task->budget_start + task->budget_period - kcb->ticks + 1;
+    task->delay_slack = 0;
+    task->state = TASK_BLOCKED;
+}
+
+/* Charge the counts accrued since the last context switch to @task */
+static void perf_charge(tcb_t *task)
+{
+    for (int i = 0; i < TASK_PERF_COUNTERS; i++) {
+        if (i >= PERF_SLOT_EVENT && !perf_counter[i])
+            continue;
+        uint64_t now = hal_perf_read(perf_counter[i]);
+        task->perf[i] += now - perf_mark[i];
+        perf_mark[i] = now;
+    }
+}
+
+#if HAL_HAS_FP
+/* Task flag: the task has used the FPU and has an FP context */
+#define TASK_FLAG_FP (1U << 1)
+
+/* Task whose FP context is currently held in the FP registers, if any */
+static tcb_t *fp_owner = NULL;
+
+/* Lazy FP switch for preemptive context switches. The outgoing task's FP
+ * registers are saved only if it wrote them since it was switched in, and
+ * the incoming task's are loaded only if it uses the FPU and they are not
+ * still live. Tasks that never used the FPU run with it off, so their first
+ * FP instruction traps into '_task_fp_trap()'.
+ *
+ * Cooperative switches need none of this: they happen inside a call to
+ * yield(), across which the ilp32 ABI treats every FP register as clobbered.
+ */
+static void fp_switch(tcb_t *prev, tcb_t *next)
+{
+    if (hal_fp_dirty())
+        hal_fp_save(&prev->fp); /* Only the owner runs with the FPU on */
+
+    if (!(next->flags & TASK_FLAG_FP)) {
+        hal_fp_disable();
+    } else if (fp_owner != next) {
+        hal_fp_restore(&next->fp);
+        fp_owner = next;
+    } else {
+        hal_fp_enable();
+    }
+}
+
+int32_t _task_fp_trap(void)
+{
+    if (unlikely(!kcb->task_current || !kcb->task_current->data))
+        return 0;
+
+    /* A new FP context starts from the zeroed one set up at spawn */
+    tcb_t *task = kcb->task_current->data;
+    task->flags |= TASK_FLAG_FP;
+    if (fp_owner != task) {
+        hal_fp_restore(&task->fp);
+        fp_owner = task;
+    } else {
+        hal_fp_enable();
+    }
+    return 1;
+}
+#endif /* HAL_HAS_FP */
+
+/* Handle time slice expiration and CPU budget for current task */
 void sched_tick_current_task(void)
 {
     if (unlikely(!kcb->task_current || !kcb->task_current->data))
@@ -387,6 +609,9 @@ void sched_tick_current_task(void)
 
     tcb_t *current_task = kcb->task_current->data;
 
+    if (current_task->budget && sched_from_tick)
+        sched_budget_charge(current_task);
+
     /* Decrement time slice */
     if (current_task->time_slice > 0)
         current_task->time_slice--;
@@ -443,8 +668,16 @@ uint16_t sched_select_next_task(void)
     if (current_task->state == TASK_RUNNING)
         current_task->state = TASK_READY;
 
-    /* Round-robin search: find next ready task in the master task list */
+    /* Round-robin search: find next ready task in the master task list,
+     * continuing from where a directed handoff interrupted the rotation.
+     */
     list_node_t *start_node = kcb->task_current;
+    if (unlikely(rr_resume_id)) {
+        list_node_t *resume = find_task_node_by_id(rr_resume_id);
+        if (resume)
+            start_node = resume;
+        rr_resume_id = 0;
+    }
     list_node_t *node = start_node;
     int iterations = 0; /* Safety counter to prevent infinite loops */
 
@@ -510,6 +743,7 @@ void dispatcher(int from_timer)
 {
     if (from_timer)
         kcb->ticks++;
+    sched_from_tick = from_timer;
 
     /* Handle time slice for current task */
     sched_tick_current_task();
@@ -519,6 +753,7 @@ void dispatcher(int from_timer)
     timer_work_generation++;
 
     _dispatch();
+    sched_from_tick = false;
 }
 
 /* Top-level context-switch for preemptive scheduling. */
@@ -550,15 +785,61 @@ void dispatch(void)
     uint32_t ready_count = 0;
     static uint32_t last_delay_update_tick = 0;
     if (kcb->ticks != last_delay_update_tick) {
-        list_foreach(kcb->tasks, delay_update_batch, &ready_count);
+        ready_count = delay_advance();
         last_delay_update_tick = kcb->ticks;
     }
 
-    /* Hook for real-time scheduler - if it selects a task, use it */
+    /* Scheduler locked: tasks woken above stay READY, and the switch they or
+     * an expired time slice would cause is left to mo_sched_unlock().
+     */
     tcb_t *prev_task = kcb->task_current->data;
-    int32_t rt_task_id = kcb->rt_sched();
+    if (unlikely(sched_switch_deferred(prev_task))) {
+        if (ready_count || prev_task->state == TASK_READY)
+            kcb->sched_pending = true;
+        prev_task->state = TASK_RUNNING;
+        return;
+    }
+    kcb->sched_pending = false;
 
-    if (rt_task_id < 0) {
+    /* Preemption threshold: a tick only displaces the running task in favor of
+     * a ready task above its threshold, and then switches to that task rather
+     * than to the round-robin successor, which may share the threshold.
+     */
+    if (sched_from_tick &&
+        (prev_task->state == TASK_RUNNING || prev_task->state == TASK_READY) &&
+        prev_task->preempt_threshold < prev_task->prio_level) {
+        tcb_t *preemptor = sched_threshold_preemptor(prev_task);
+        if (!preemptor) {
+            prev_task->state = TASK_RUNNING;
+            if (!prev_task->time_slice)
+                prev_task->time_slice =
+                    get_priority_timeslice(prev_task->prio_level);
+            return;
+        }
+        handoff_from = prev_task;
+        handoff_to = preemptor;
+        threshold_resume_id = prev_task->id;
+    } else if (unlikely(threshold_resume_id) && !handoff_to) {
+        /* The displaced task gets the CPU back first, as it would at the
+         * head of its ready queue, before any peer sharing its threshold.
+         */
+        list_node_t *node = find_task_node_by_id(threshold_resume_id);
+        threshold_resume_id = 0;
+        if (node && node->data != prev_task) {
+            handoff_from = prev_task;
+            handoff_to = node->data;
+        }
+    }
+
+    /* A directed handoff (IPC, yield-to) has already picked the next task */
+    bool handed_off = sched_take_handoff();
+
+    /* Hook for real-time scheduler - if it selects a task, use it */
+    int32_t rt_task_id = handed_off ? -1 : kcb->rt_sched();
+
+    if (handed_off) {
+        /* kcb->task_current already points at the handoff target */
+    } else if (rt_task_id < 0) {
         sched_select_next_task(); /* Use O(n) round-robin scheduler */
     } else {
         /* RT scheduler selected a task - update current task pointer */
@@ -588,6 +869,7 @@ void dispatch(void)
 
     /* Check if we're still on the same task (no actual switch needed) */
     tcb_t *next_task = kcb->task_current->data;
+    const tcb_t *handoff_task = handed_off ? next_task : NULL;
 
     /* In preemptive mode, if selected task has pending delay, keep trying to
      * find ready task. We check delay > 0 instead of state == BLOCKED because
@@ -611,10 +893,13 @@ void dispatch(void)
          */
     }
 
-    /* Update task state and time slice before context switch */
+    /* Update task state and time slice before context switch. A handoff
+     * target keeps the slice the handoff lent or started.
+     */
     if (next_task->state != TASK_RUNNING)
         next_task->state = TASK_RUNNING;
-    next_task->time_slice = get_priority_timeslice(next_task->prio_level);
+    if (next_task != handoff_task)
+        next_task->time_slice = get_priority_timeslice(next_task->prio_level);
 
     /* Perform context switch based on scheduling mode */
     if (kcb->preemptive) {
@@ -622,6 +907,11 @@ void dispatch(void)
         if (next_task == prev_task)
             return; /* ISR will restore from current stack naturally */
 
+        perf_charge(prev_task);
+#if HAL_HAS_FP
+        fp_switch(prev_task, next_task);
+#endif
+
         /* Preemptive mode: Switch stack pointer.
          * ISR already saved context to prev_task's stack.
          * Switch SP to next_task's stack.
@@ -633,6 +923,8 @@ void dispatch(void)
          * setjmp/longjmp mechanism. Even if same task continues, we must
          * longjmp back to complete the context save/restore cycle.
          */
+        if (next_task != prev_task)
+            perf_charge(prev_task);
         hal_interrupt_tick();
         hal_context_restore(next_task->context, 1);
     }
@@ -647,6 +939,14 @@ void yield(void)
     /* Process deferred timer work during yield */
     process_deferred_timer_work();
 
+    /* A runnable task holding the scheduler lock keeps the CPU; the yield is
+     * replayed once by the outermost mo_sched_unlock().
+     */
+    if (unlikely(sched_switch_deferred(kcb->task_current->data))) {
+        kcb->sched_pending = true;
+        return;
+    }
+
     /* In preemptive mode, can't use setjmp/longjmp - incompatible with ISR
      * stack frames. Trigger dispatcher via ecall, then wait until task becomes
      * READY again.
@@ -673,9 +973,11 @@ void yield(void)
 #endif
 
     /* In cooperative mode, delays are only processed on an explicit yield. */
-    list_foreach(kcb->tasks, delay_update, NULL);
+    delay_advance();
 
-    sched_select_next_task(); /* Use O(1) priority scheduler */
+    perf_charge(kcb->task_current->data);
+    if (!sched_take_handoff())
+        sched_select_next_task(); /* Use O(1) priority scheduler */
     hal_context_restore(((tcb_t *) kcb->task_current->data)->context, 1);
 }
 
@@ -733,11 +1035,22 @@ int32_t mo_task_spawn(void *task_entry, uint16_t stack_size_req)
     tcb->rt_prio = NULL;
     tcb->state = TASK_STOPPED;
     tcb->flags = 0;
+    tcb->sched_lock = 0;
+    tcb->budget = 0;
+    tcb->budget_used = 0;
+    tcb->budget_period = 0;
+    tcb->budget_start = 0;
+    tcb->delay_slack = 0;
+    memset(tcb->perf, 0, sizeof(tcb->perf));
+#if HAL_HAS_FP
+    memset(&tcb->fp, 0, sizeof(tcb->fp));
+#endif
 
     /* Set default priority with proper scheduler fields */
     tcb->prio = TASK_PRIO_NORMAL;
     tcb->prio_level = extract_priority_level(TASK_PRIO_NORMAL);
     tcb->time_slice = get_priority_timeslice(tcb->prio_level);
+    tcb->preempt_threshold = tcb->prio_level;
 
     /* Initialize stack */
     if (!init_task_stack(tcb, new_stack_size)) {
@@ -826,6 +1139,12 @@ int32_t mo_task_cancel(uint16_t id)
         }
     }
 
+#if HAL_HAS_FP
+    /* A later task allocated at the same address must not inherit it */
+    if (fp_owner == tcb)
+        fp_owner = NULL;
+#endif
+
     CRITICAL_LEAVE();
 
     /* Free memory outside critical section */
@@ -839,7 +1158,66 @@ void mo_task_yield(void)
     _yield();
 }
 
-void mo_task_delay(uint16_t ticks)
+int32_t mo_task_yield_to(uint16_t id)
+{
+    if (id == 0)
+        return ERR_TASK_NOT_FOUND;
+
+    NOSCHED_ENTER();
+    tcb_t *target = _task_lookup(id);
+    if (!target) {
+        NOSCHED_LEAVE();
+        return ERR_TASK_NOT_FOUND;
+    }
+
+    /* A target that is not READY (or is the caller) leaves the handoff
+     * unconsumed, and the switch falls back to round-robin selection.
+     */
+    _sched_yield_to(target);
+    NOSCHED_LEAVE();
+    return ERR_OK;
+}
+
+void mo_sched_lock(void)
+{
+    if (unlikely(!kcb->task_current || !kcb->task_current->data))
+        return;
+
+    tcb_t *self = kcb->task_current->data;
+    if (unlikely(self->sched_lock == UINT8_MAX))
+        panic(ERR_SCHED_LOCK);
+
+    /* Only the owning task writes its counter, and the scheduler reads it
+     * from the same hart, so no critical section is needed.
+     */
+    self->sched_lock++;
+}
+
+int32_t mo_sched_unlock(void)
+{
+    if (unlikely(!kcb->task_current || !kcb->task_current->data))
+        return ERR_SCHED_LOCK;
+
+    tcb_t *self = kcb->task_current->data;
+    if (unlikely(!self->sched_lock))
+        return ERR_SCHED_LOCK;
+
+    if (--self->sched_lock)
+        return ERR_OK;
+
+    /* Outermost unlock: perform the single reschedule batched while locked.
+     * A tick landing between the decrement and this check already
+     * rescheduled and cleared the flag, so no switch is lost or doubled.
+     */
+    if (kcb->sched_pending) {
+        kcb->sched_pending = false;
+        mo_task_yield();
+    }
+    return ERR_OK;
+}
+
+/* Common sleep path for 'mo_task_delay()' and 'mo_task_delay_slack()' */
+static void task_delay(uint16_t ticks, uint16_t slack)
 {
     /* Process deferred timer work before sleeping */
     process_deferred_timer_work();
@@ -857,12 +1235,24 @@ void mo_task_delay(uint16_t ticks)
 
     /* Set delay and blocked state - scheduler will skip blocked tasks */
     self->delay = ticks;
+    self->delay_slack = slack;
+    self->flags &= ~TASK_FLAG_SLACK;
     self->state = TASK_BLOCKED;
     NOSCHED_LEAVE();
 
     mo_task_yield();
 }
 
+void mo_task_delay(uint16_t ticks)
+{
+    task_delay(ticks, 0);
+}
+
+void mo_task_delay_slack(uint16_t ticks, uint16_t slack)
+{
+    task_delay(ticks, slack);
+}
+
 int32_t mo_task_suspend(uint16_t id)
 {
     if (id == 0)
@@ -936,11 +1326,70 @@ int32_t mo_task_priority(uint16_t id, uint16_t priority)
         return ERR_TASK_NOT_FOUND;
     }
 
+    /* An unset threshold tracks the priority; a raised one is kept unless it
+     * would fall below the new priority.
+     */
+    bool threshold_unset = (task->preempt_threshold == task->prio_level);
+
     /* Update priority and level */
     task->prio = priority;
     task->prio_level = extract_priority_level(priority);
     task->time_slice = get_priority_timeslice(task->prio_level);
 
+    if (threshold_unset || task->preempt_threshold > task->prio_level)
+        task->preempt_threshold = task->prio_level;
+
+    CRITICAL_LEAVE();
+    return ERR_OK;
+}
+
+int32_t mo_task_preempt_threshold(uint16_t id, uint16_t threshold)
+{
+    if (id == 0 || !is_valid_priority(threshold))
+        return ERR_TASK_INVALID_PRIO;
+
+    CRITICAL_ENTER();
+    list_node_t *node = find_task_node_by_id(id);
+    if (!node || !node->data) {
+        CRITICAL_LEAVE();
+        return ERR_TASK_NOT_FOUND;
+    }
+
+    tcb_t *task = node->data;
+    uint8_t level = extract_priority_level(threshold);
+
+    /* The threshold cannot be lower than the task's own priority */
+    if (level > task->prio_level) {
+        CRITICAL_LEAVE();
+        return ERR_TASK_INVALID_PRIO;
+    }
+
+    task->preempt_threshold = level;
+
+    CRITICAL_LEAVE();
+    return ERR_OK;
+}
+
+int32_t mo_task_budget(uint16_t id, uint16_t budget, uint16_t period)
+{
+    if (id == 0)
+        return ERR_TASK_NOT_FOUND;
+    if (budget && (period < budget || period == UINT16_MAX))
+        return ERR_FAIL;
+
+    CRITICAL_ENTER();
+    list_node_t *node = find_task_node_by_id(id);
+    if (!node || !node->data) {
+        CRITICAL_LEAVE();
+        return ERR_TASK_NOT_FOUND;
+    }
+
+    tcb_t *task = node->data;
+    task->budget = budget;
+    task->budget_period = budget ? period : 0;
+    task->budget_used = 0;
+    task->budget_start = kcb->ticks;
+
     CRITICAL_LEAVE();
     return ERR_OK;
 }
@@ -1013,6 +1462,78 @@ uint16_t mo_task_count(void)
     return kcb->task_count;
 }
 
+int32_t mo_task_perf(uint16_t id, task_perf_t *perf)
+{
+    if (unlikely(!perf))
+        return ERR_FAIL;
+    if (id == 0)
+        return ERR_TASK_NOT_FOUND;
+
+    CRITICAL_ENTER();
+    list_node_t *node = find_task_node_by_id(id);
+    if (!node || !node->data) {
+        CRITICAL_LEAVE();
+        return ERR_TASK_NOT_FOUND;
+    }
+
+    /* Bring the running task's counts up to date */
+    tcb_t *task = node->data;
+    if (node == kcb->task_current)
+        perf_charge(task);
+
+    perf->cycles = task->perf[PERF_SLOT_CYCLE];
+    perf->instret = task->perf[PERF_SLOT_INSTRET];
+    for (int i = 0; i < TASK_PERF_EVENTS; i++)
+        perf->events[i] = task->perf[PERF_SLOT_EVENT + i];
+    CRITICAL_LEAVE();
+
+    perf->ipc_milli =
+        perf->cycles ? (uint32_t) (perf->instret * 1000 / perf->cycles) : 0;
+    perf->cpi_milli =
+        perf->instret ? (uint32_t) (perf->cycles * 1000 / perf->instret) : 0;
+    return ERR_OK;
+}
+
+static list_node_t *perf_slot_clear(list_node_t *node, void *arg)
+{
+    if (node->data)
+        ((tcb_t *) node->data)->perf[(uint32_t) arg] = 0;
+    return NULL;
+}
+
+int32_t mo_task_perf_event(uint8_t slot, uint32_t counter, uint32_t event)
+{
+    if (slot >= TASK_PERF_EVENTS)
+        return ERR_FAIL;
+    if (counter &&
+        (counter < HAL_PERF_HPM_FIRST || counter > HAL_PERF_HPM_LAST))
+        return ERR_FAIL;
+
+    uint32_t idx = PERF_SLOT_EVENT + slot;
+
+    CRITICAL_ENTER();
+    if (kcb->task_current && kcb->task_current->data)
+        perf_charge(kcb->task_current->data);
+
+    perf_counter[idx] = counter;
+    if (counter) {
+        hal_perf_event(counter, event);
+        perf_mark[idx] = hal_perf_read(counter);
+    }
+    list_foreach(kcb->tasks, perf_slot_clear, (void *) idx);
+    CRITICAL_LEAVE();
+
+    return ERR_OK;
+}
+
+void _task_perf_init(void)
+{
+    for (int i = 0; i < TASK_PERF_COUNTERS; i++) {
+        if (i < PERF_SLOT_EVENT || perf_counter[i])
+            perf_mark[i] = hal_perf_read(perf_counter[i]);
+    }
+}
+
 uint32_t mo_ticks(void)
 {
     return kcb->ticks;
@@ -1041,3 +1562,63 @@ void _sched_block(queue_t *wait_q)
     self->state = TASK_BLOCKED;
     _yield();
 }
+
+tcb_t *_task_lookup(uint16_t id)
+{
+    list_node_t *node = find_task_node_by_id(id);
+    return node ? node->data : NULL;
+}
+
+void _sched_yield_to(tcb_t *target)
+{
+    if (unlikely(!target || !kcb->task_current || !kcb->task_current->data))
+        panic(ERR_TASK_NOT_FOUND);
+
+    handoff_from = kcb->task_current->data;
+    handoff_to = target;
+    _yield();
+}
+
+void _sched_wakeup_irq(tcb_t *task)
+{
+    if (task->state != TASK_BLOCKED)
+        return;
+
+    sched_wakeup_task(task);
+    irq_woken = task;
+}
+
+void _sched_irq_exit(void)
+{
+    tcb_t *target = irq_woken;
+    irq_woken = NULL;
+
+    if (!target || !kcb->preemptive || !kcb->task_current ||
+        !kcb->task_current->data)
+        return;
+
+    tcb_t *current = kcb->task_current->data;
+    if (target == current || target->state != TASK_READY)
+        return;
+
+    /* A raised preemption threshold holds off the wakeup as it does a tick */
+    if (current->state == TASK_RUNNING &&
+        current->preempt_threshold < current->prio_level &&
+        target->prio_level >= current->preempt_threshold)
+        return;
+
+    handoff_from = current;
+    handoff_to = target;
+    _dispatch();
+}
+
+void _sched_donate(tcb_t *task, const tcb_t *donor)
+{
+    if (donor->prio_level < task->prio_level)
+        task->prio_level = donor->prio_level;
+}
+
+void _sched_donate_end(tcb_t *task)
+{
+    task->prio_level = extract_priority_level(task->prio);
+}
@@ -36,11 +36,10 @@ static uint8_t timer_cache_index = 0;
 static list_node_t *get_timer_node(void)
 {
     /* Find first free node in pool */
-    for (int i = 0; i < TIMER_NODE_POOL_SIZE; i++) {
-        if (pool_free_mask & (1 << i)) {
-            pool_free_mask &= ~(1 << i);
-            return &timer_node_pool[i];
-        }
+    if (pool_free_mask) {
+        uint32_t i = ctz32(pool_free_mask);
+        pool_free_mask &= ~(1U << i);
+        return &timer_node_pool[i];
     }
     /* Pool exhausted, fall back to malloc */
     return malloc(sizeof(list_node_t));
@@ -224,6 +223,24 @@ void _timer_tick_handler(void)
     timer_t *expired_timers[TIMER_BATCH_SIZE]; /* Smaller batch size */
     int expired_count = 0;
 
+    /* Timers past their deadline but still inside their slack window are
+     * only fired along with a timer that is strictly due, so expirations
+     * sharing a window coalesce into a single tick.
+     */
+    bool due = false;
+    for (list_node_t *node = kcb->timer_list->head->next;
+         node != kcb->timer_list->tail; node = node->next) {
+        timer_t *t = (timer_t *) node->data;
+        if (now < t->deadline_ticks)
+            break;
+        if (now >= t->deadline_ticks + t->slack_ticks) {
+            due = true;
+            break;
+        }
+    }
+    if (!due)
+        return;
+
     /* Collect expired timers in one pass, limited to batch size */
     while (!list_is_empty(kcb->timer_list) &&
            expired_count < TIMER_BATCH_SIZE) {
@@ -249,9 +266,18 @@ void _timer_tick_handler(void)
         if (likely(t->callback))
             t->callback(t->arg);
 
-        /* Handle auto-reload timers */
+        /* Handle auto-reload timers. The next deadline is derived from the
+         * previous one, not from 'now', so the timer keeps its phase even
+         * when fired late (slack, batching). Periods missed entirely are
+         * skipped rather than fired back to back.
+         */
         if (t->mode == TIMER_AUTORELOAD) {
-            t->deadline_ticks = now + MS_TO_TICKS(t->period_ms);
+            t->deadline_ticks += t->period_ticks;
+            if (unlikely(now >= t->deadline_ticks)) {
+                uint32_t late = now - t->deadline_ticks;
+                t->deadline_ticks +=
+                    (late / t->period_ticks + 1) * t->period_ticks;
+            }
             timer_sorted_insert(t); /* Re-insert for next expiration */
         } else {
             t->mode = TIMER_DISABLED; /* One-shot timers are done */
@@ -282,13 +308,13 @@ static int32_t timer_insert_sorted_by_id(timer_t *timer)
     return ERR_OK;
 }
 
-int32_t mo_timer_create(void *(*callback)(void *arg),
-                        uint32_t period_ms,
-                        void *arg)
+int32_t mo_timer_create_ticks(void *(*callback)(void *arg),
+                              uint32_t period_ticks,
+                              void *arg)
 {
     static uint16_t next_id = 0x6000;
 
-    if (unlikely(!callback || !period_ms))
+    if (unlikely(!callback || !period_ticks))
         return ERR_FAIL;
     if (unlikely(timer_subsystem_init() != ERR_OK))
         return ERR_FAIL;
@@ -303,8 +329,9 @@ int32_t mo_timer_create(void *(*callback)(void *arg),
     t->id = next_id++;
     t->callback = callback;
     t->arg = arg;
-    t->period_ms = period_ms;
+    t->period_ticks = period_ticks;
     t->deadline_ticks = 0;
+    t->slack_ticks = 0;
     t->mode = TIMER_DISABLED;
     t->_reserved = 0;
 
@@ -322,6 +349,19 @@ int32_t mo_timer_create(void *(*callback)(void *arg),
     return t->id;
 }
 
+int32_t mo_timer_create(void *(*callback)(void *arg),
+                        uint32_t period_ms,
+                        void *arg)
+{
+    if (unlikely(!period_ms))
+        return ERR_FAIL;
+
+    /* Convert once here; periods shorter than a tick round up to one */
+    uint32_t period_ticks = MS_TO_TICKS(period_ms);
+    return mo_timer_create_ticks(callback, period_ticks ? period_ticks : 1,
+                                 arg);
+}
+
 int32_t mo_timer_destroy(uint16_t id)
 {
     if (unlikely(!timer_initialized))
@@ -366,7 +406,13 @@ int32_t mo_timer_destroy(uint16_t id)
     return ERR_OK;
 }
 
-int32_t mo_timer_start(uint16_t id, uint8_t mode)
+/* Arm a timer to first expire at @deadline, or one period from now if
+ * @absolute is false.
+ */
+static int32_t timer_arm(uint16_t id,
+                         uint8_t mode,
+                         bool absolute,
+                         uint32_t deadline)
 {
     if (unlikely(mode != TIMER_ONESHOT && mode != TIMER_AUTORELOAD))
         return ERR_FAIL;
@@ -387,7 +433,7 @@ int32_t mo_timer_start(uint16_t id, uint8_t mode)
 
     /* Configure and start timer */
     t->mode = mode;
-    t->deadline_ticks = mo_ticks() + MS_TO_TICKS(t->period_ms);
+    t->deadline_ticks = absolute ? deadline : mo_ticks() + t->period_ticks;
 
     if (unlikely(timer_sorted_insert(t) != ERR_OK)) {
         t->mode = TIMER_DISABLED;
@@ -399,6 +445,16 @@ int32_t mo_timer_start(uint16_t id, uint8_t mode)
     return ERR_OK;
 }
 
+int32_t mo_timer_start(uint16_t id, uint8_t mode)
+{
+    return timer_arm(id, mode, false, 0);
+}
+
+int32_t mo_timer_start_at(uint16_t id, uint32_t abs_tick, uint8_t mode)
+{
+    return timer_arm(id, mode, true, abs_tick);
+}
+
 int32_t mo_timer_cancel(uint16_t id)
 {
     if (unlikely(!timer_initialized))
@@ -418,3 +474,22 @@ int32_t mo_timer_cancel(uint16_t id)
     NOSCHED_LEAVE();
     return ERR_OK;
 }
+
+int32_t mo_timer_set_slack(uint16_t id, uint32_t slack_ms)
+{
+    if (unlikely(!timer_initialized))
+        return ERR_FAIL;
+
+    NOSCHED_ENTER();
+
+    timer_t *t = timer_find_by_id_fast(id);
+    if (unlikely(!t)) {
+        NOSCHED_LEAVE();
+        return ERR_FAIL;
+    }
+
+    t->slack_ticks = MS_TO_TICKS(slack_ms);
+
+    NOSCHED_LEAVE();
+    return ERR_OK;
+}
@@ -0,0 +1,219 @@
+/* Publish/Subscribe Topic Bus
+ *
+ * Subscriber queues hold pointers to shared, reference-counted buffers. All
+ * bookkeeping (subscriber lists, queues and reference counts) is done with
+ * the scheduler disabled, which also keeps the subscriber list stable while
+ * a publish walks it. Receivers block on a per-subscription sequence word
+ * using the wait-on-address primitive.
+ */
+
+#include <lib/malloc.h>
+#include <sys/futex.h>
+#include <sys/task.h>
+#include <sys/topic.h>
+
+#include "private/error.h"
+#include "private/utils.h"
+
+/* Drop one reference; returns the buffer if it must now be freed. Must be
+ * called with the scheduler disabled.
+ */
+static inline topic_buf_t *topic_buf_put(topic_buf_t *buf)
+{
+    return --buf->refs == 0 ? buf : NULL;
+}
+
+topic_t *mo_topic_create(void)
+{
+    topic_t *topic = malloc(sizeof(topic_t));
+    if (unlikely(!topic))
+        return NULL;
+
+    topic->subs = NULL;
+    topic->published = 0;
+    return topic;
+}
+
+int32_t mo_topic_destroy(topic_t *topic)
+{
+    if (unlikely(!topic))
+        return ERR_OK; /* Destroying NULL is no-op */
+
+    if (unlikely(topic->subs))
+        return ERR_TASK_BUSY;
+
+    free(topic);
+    return ERR_OK;
+}
+
+topic_sub_t *mo_topic_subscribe(topic_t *topic, uint16_t depth, uint8_t policy)
+{
+    if (unlikely(!topic || !depth ||
+                 (policy != TOPIC_DROP_NEWEST && policy != TOPIC_DROP_OLDEST)))
+        return NULL;
+
+    topic_sub_t *sub = malloc(sizeof(topic_sub_t));
+    if (unlikely(!sub))
+        return NULL;
+
+    /* queue_t keeps one slot free, so size it for depth + 1 */
+    sub->q = queue_create(depth + 1);
+    if (unlikely(!sub->q)) {
+        free(sub);
+        return NULL;
+    }
+
+    sub->topic = topic;
+    sub->depth = depth;
+    sub->policy = policy;
+    sub->waiters = 0;
+    sub->seq = 0;
+    sub->dropped = 0;
+
+    NOSCHED_ENTER();
+    sub->next = topic->subs;
+    topic->subs = sub;
+    NOSCHED_LEAVE();
+
+    return sub;
+}
+
+int32_t mo_topic_unsubscribe(topic_sub_t *sub)
+{
+    if (unlikely(!sub || !sub->topic))
+        return ERR_FAIL;
+
+    NOSCHED_ENTER();
+
+    /* A blocked receiver still refers to the subscription when it wakes */
+    if (unlikely(sub->waiters)) {
+        NOSCHED_LEAVE();
+        return ERR_TASK_BUSY;
+    }
+
+    topic_sub_t **link = &sub->topic->subs;
+    while (*link && *link != sub)
+        link = &(*link)->next;
+    if (unlikely(!*link)) {
+        NOSCHED_LEAVE();
+        return ERR_FAIL;
+    }
+    *link = sub->next;
+    sub->topic = NULL;
+
+    /* Release everything still pending on this subscription */
+    topic_buf_t *buf;
+    while ((buf = queue_dequeue(sub->q))) {
+        if (topic_buf_put(buf))
+            free(buf);
+    }
+
+    NOSCHED_LEAVE();
+
+    queue_destroy(sub->q);
+    free(sub);
+    return ERR_OK;
+}
+
+topic_buf_t *mo_topic_buf_alloc(uint16_t size)
+{
+    if (unlikely(!size))
+        return NULL;
+
+    topic_buf_t *buf = malloc(sizeof(topic_buf_t) + size);
+    if (unlikely(!buf))
+        return NULL;
+
+    buf->refs = 1;
+    buf->size = size;
+    return buf;
+}
+
+void mo_topic_buf_release(topic_buf_t *buf)
+{
+    if (unlikely(!buf))
+        return;
+
+    NOSCHED_ENTER();
+    topic_buf_t *dead = topic_buf_put(buf);
+    NOSCHED_LEAVE();
+
+    free(dead);
+}
+
+int32_t mo_topic_publish(topic_t *topic, topic_buf_t *buf)
+{
+    if (unlikely(!topic || !buf))
+        return ERR_FAIL;
+
+    int32_t delivered = 0;
+
+    NOSCHED_ENTER();
+
+    for (topic_sub_t *sub = topic->subs; sub; sub = sub->next) {
+        if (queue_count(sub->q) >= sub->depth) {
+            sub->dropped++;
+            if (sub->policy == TOPIC_DROP_NEWEST)
+                continue;
+
+            /* Make room by discarding the oldest pending message */
+            topic_buf_t *old = queue_dequeue(sub->q);
+            if (topic_buf_put(old))
+                free(old);
+        }
+
+        buf->refs++;
+        queue_enqueue(sub->q, buf);
+        sub->seq++;
+        delivered++;
+
+        if (sub->waiters)
+            _futex_wake(&sub->seq, 1);
+    }
+    topic->published++;
+
+    /* The publisher's reference is consumed */
+    topic_buf_t *dead = topic_buf_put(buf);
+
+    NOSCHED_LEAVE();
+
+    free(dead);
+    return delivered;
+}
+
+topic_buf_t *mo_topic_recv(topic_sub_t *sub, uint16_t timeout)
+{
+    if (unlikely(!sub || !sub->q))
+        return NULL;
+
+    uint32_t deadline = mo_ticks() + timeout;
+
+    for (;;) {
+        NOSCHED_ENTER();
+        topic_buf_t *buf = queue_dequeue(sub->q);
+        uint32_t seq = sub->seq;
+        if (!buf)
+            sub->waiters++;
+        NOSCHED_LEAVE();
+
+        if (buf)
+            return buf; /* The delivery's reference passes to the caller */
+
+        uint16_t left = 0;
+        if (timeout) {
+            int32_t remaining = (int32_t) (deadline - mo_ticks());
+            left = remaining > 0 ? (uint16_t) remaining : 0;
+        }
+
+        int32_t rc = ERR_TIMEOUT;
+        if (!timeout || left)
+            rc = mo_wait_on(&sub->seq, seq, left);
+
+        NOSCHED_ENTER();
+        sub->waiters--;
+        NOSCHED_LEAVE();
+
+        if (rc == ERR_TIMEOUT)
+            return NULL;
+    }
+}
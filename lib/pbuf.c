@@ -0,0 +1,239 @@
+#include <lib/libc.h>
+#include <lib/malloc.h>
+#include <lib/pbuf.h>
+#include <sys/task.h>
+
+#include "private/error.h"
+#include "private/utils.h"
+
+/* Bytes occupied by one pool segment, header included */
+static inline uint32_t pbuf_seg_stride(uint16_t seg_size)
+{
+    return ALIGN4(sizeof(pbuf_t) + seg_size);
+}
+
+pbuf_pool_t *pbuf_pool_create(uint16_t seg_size, uint16_t count)
+{
+    if (unlikely(!seg_size || !count))
+        return NULL;
+
+    pbuf_pool_t *pool = malloc(sizeof(pbuf_pool_t));
+    if (unlikely(!pool))
+        return NULL;
+
+    uint32_t stride = pbuf_seg_stride(seg_size);
+    pool->mem = malloc(stride * count);
+    if (unlikely(!pool->mem)) {
+        free(pool);
+        return NULL;
+    }
+
+    /* Thread every segment onto the free list */
+    pool->free = NULL;
+    for (uint16_t i = count; i > 0; i--) {
+        pbuf_t *seg = (pbuf_t *) ((uint8_t *) pool->mem + stride * (i - 1));
+        seg->pool = pool;
+        seg->cap = seg_size;
+        seg->next = pool->free;
+        pool->free = seg;
+    }
+
+    pool->seg_size = seg_size;
+    pool->count = count;
+    pool->avail = count;
+    return pool;
+}
+
+int32_t pbuf_pool_destroy(pbuf_pool_t *pool)
+{
+    if (unlikely(!pool || pool->avail != pool->count))
+        return ERR_FAIL;
+
+    free(pool->mem);
+    free(pool);
+    return ERR_OK;
+}
+
+/* Initialize a fresh segment with @len payload bytes after @headroom */
+static void pbuf_seg_init(pbuf_t *seg, uint16_t len, uint16_t headroom)
+{
+    seg->payload = seg->data + headroom;
+    seg->len = len;
+    seg->tot_len = len;
+    seg->refs = 1;
+}
+
+/* Return a segment to its pool or to the heap */
+static void pbuf_seg_release(pbuf_t *seg)
+{
+    pbuf_pool_t *pool = seg->pool;
+    if (!pool) {
+        free(seg);
+        return;
+    }
+
+    CRITICAL_ENTER();
+    seg->next = pool->free;
+    pool->free = seg;
+    pool->avail++;
+    CRITICAL_LEAVE();
+}
+
+pbuf_t *pbuf_alloc(pbuf_pool_t *pool, uint16_t len, uint16_t headroom)
+{
+    if (!pool) {
+        /* 'cap' could not describe a larger segment */
+        if (unlikely((uint32_t) headroom + len > UINT16_MAX))
+            return NULL;
+
+        pbuf_t *p = malloc(sizeof(pbuf_t) + headroom + len);
+        if (unlikely(!p))
+            return NULL;
+        p->pool = NULL;
+        p->cap = headroom + len;
+        p->next = NULL;
+        pbuf_seg_init(p, len, headroom);
+        return p;
+    }
+
+    if (unlikely(headroom >= pool->seg_size))
+        return NULL;
+
+    /* Segments needed for the payload, the first one short of headroom */
+    uint32_t first = pool->seg_size - headroom;
+    uint32_t nsegs = 1;
+    if (len > first)
+        nsegs += (len - first + pool->seg_size - 1) / pool->seg_size;
+
+    /* Take all segments at once so a short pool fails without side effects */
+    CRITICAL_ENTER();
+    if (unlikely(pool->avail < nsegs)) {
+        CRITICAL_LEAVE();
+        return NULL;
+    }
+    pbuf_t *head = pool->free;
+    pbuf_t *last = head;
+    for (uint32_t i = 1; i < nsegs; i++)
+        last = last->next;
+    pool->free = last->next;
+    pool->avail -= nsegs;
+    CRITICAL_LEAVE();
+    last->next = NULL;
+
+    /* Split the payload over the chain; tot_len counts down along it */
+    uint16_t remaining = len;
+    uint16_t room = headroom;
+    for (pbuf_t *seg = head; seg; seg = seg->next) {
+        uint16_t seg_len = min(remaining, (uint16_t) (seg->cap - room));
+        pbuf_seg_init(seg, seg_len, room);
+        seg->tot_len = remaining;
+        remaining -= seg_len;
+        room = 0;
+    }
+    return head;
+}
+
+void pbuf_ref(pbuf_t *p)
+{
+    if (unlikely(!p))
+        return;
+
+    CRITICAL_ENTER();
+    p->refs++;
+    CRITICAL_LEAVE();
+}
+
+uint16_t pbuf_free(pbuf_t *p)
+{
+    uint16_t released = 0;
+
+    while (p) {
+        CRITICAL_ENTER();
+        uint16_t refs = --p->refs;
+        CRITICAL_LEAVE();
+
+        /* Still shared: the rest of the chain stays referenced through it */
+        if (refs)
+            break;
+
+        pbuf_t *next = p->next;
+        pbuf_seg_release(p);
+        released++;
+        p = next;
+    }
+    return released;
+}
+
+void pbuf_cat(pbuf_t *head, pbuf_t *tail)
+{
+    if (unlikely(!head || !tail))
+        return;
+
+    pbuf_t *p = head;
+    for (; p->next; p = p->next)
+        p->tot_len += tail->tot_len;
+    p->tot_len += tail->tot_len;
+    p->next = tail;
+}
+
+void *pbuf_push(pbuf_t *p, uint16_t n)
+{
+    if (unlikely(!p || (uint32_t) (p->payload - p->data) < n))
+        return NULL;
+
+    p->payload -= n;
+    p->len += n;
+    p->tot_len += n;
+    return p->payload;
+}
+
+int32_t pbuf_pop(pbuf_t *p, uint16_t n)
+{
+    if (unlikely(!p || p->len < n))
+        return ERR_FAIL;
+
+    p->payload += n;
+    p->len -= n;
+    p->tot_len -= n;
+    return ERR_OK;
+}
+
+uint16_t pbuf_copy_out(const pbuf_t *p,
+                       void *dst,
+                       uint16_t len,
+                       uint16_t offset)
+{
+    uint16_t copied = 0;
+
+    for (; p && copied < len; p = p->next) {
+        if (offset >= p->len) {
+            offset -= p->len;
+            continue;
+        }
+        uint16_t chunk = min((uint16_t) (p->len - offset), len - copied);
+        memcpy((uint8_t *) dst + copied, p->payload + offset, chunk);
+        copied += chunk;
+        offset = 0;
+    }
+    return copied;
+}
+
+uint16_t pbuf_copy_in(pbuf_t *p,
+                      const void *src,
+                      uint16_t len,
+                      uint16_t offset)
+{
+    uint16_t copied = 0;
+
+    for (; p && copied < len; p = p->next) {
+        if (offset >= p->len) {
+            offset -= p->len;
+            continue;
+        }
+        uint16_t chunk = min((uint16_t) (p->len - offset), len - copied);
+        memcpy(p->payload + offset, (const uint8_t *) src + copied, chunk);
+        copied += chunk;
+        offset = 0;
+    }
+    return copied;
+}
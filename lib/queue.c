@@ -70,6 +70,46 @@ void *queue_dequeue(queue_t *q)
     return item;
 }
 
+/* Adds elements to the tail of the queue in one pass. Free space is computed
+ * once and the tail index is published once at the end.
+ */
+uint32_t queue_enqueue_many(queue_t *q, void *const *items, uint32_t n)
+{
+    if (unlikely(!q || !items))
+        return 0;
+
+    uint32_t space = (uint32_t) q->mask - queue_count(q);
+    if (n > space)
+        n = space;
+
+    int32_t tail = q->tail;
+    for (uint32_t i = 0; i < n; i++) {
+        q->buf[tail] = items[i];
+        tail = (tail + 1) & q->mask;
+    }
+    q->tail = tail;
+    return n;
+}
+
+/* Removes elements from the head of the queue in one pass. */
+uint32_t queue_dequeue_many(queue_t *q, void **out, uint32_t max)
+{
+    if (unlikely(!q || !out))
+        return 0;
+
+    uint32_t n = queue_count(q);
+    if (n > max)
+        n = max;
+
+    int32_t head = q->head;
+    for (uint32_t i = 0; i < n; i++) {
+        out[i] = q->buf[head];
+        head = (head + 1) & q->mask;
+    }
+    q->head = head;
+    return n;
+}
+
 /* Returns the element at the head of the queue without removing it. */
 void *queue_peek(const queue_t *q)
 {
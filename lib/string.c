@@ -4,19 +4,39 @@
 
 #include "private/utils.h"
 
+#if defined(__riscv_zbb)
+/* Sets every non-zero byte of @v to 0xFF and every zero byte to 0x00. */
+static inline uint32_t orc_b(uint32_t v)
+{
+    uint32_t r;
+    asm("orc.b %0, %1" : "=r"(r) : "r"(v));
+    return r;
+}
+
+/* Checks for any zero byte in a 32-bit word. */
+static inline int byte_is_zero(uint32_t v)
+{
+    return orc_b(v) != 0xFFFFFFFFu;
+}
+
+/* Index of the first zero byte of @v, which must contain one. */
+static inline uint32_t zero_byte_index(uint32_t v)
+{
+    return ctz32(~orc_b(v)) >> 3;
+}
+#else
 /* Checks for any zero byte in a 32-bit word. */
 static inline int byte_is_zero(uint32_t v)
 {
     /* bitwise check for zero bytes. */
     return ((v - 0x01010101u) & ~v & 0x80808080u) != 0;
 }
+#endif
 
-/* Checks if a 32-bit word @w matches the pattern @pat in all bytes. */
+/* Checks if a 32-bit word @w matches the pattern @pat in any byte. */
 static inline int byte_is_match(uint32_t w, uint32_t pat)
 {
-    uint32_t t = w ^ pat; /* t will be zero for matching bytes. */
-    /* Similar logic to byte_is_zero, but applied to the XORed result. */
-    return ((t - 0x01010101u) & ~t & 0x80808080u) != 0;
+    return byte_is_zero(w ^ pat); /* Matching bytes XOR to zero. */
 }
 
 /* strlen that scans by words whenever possible for efficiency. */
@@ -36,6 +56,10 @@ size_t strlen(const char *s)
     while (!byte_is_zero(*w))
         w++;
 
+#if defined(__riscv_zbb)
+    /* The zero byte's position follows directly from the 'orc.b' mask */
+    return (size_t) ((const char *) w - s) + zero_byte_index(*w);
+#else
     /* Final byte scan: Within the word that contained the zero byte, find the
      * exact position.
      */
@@ -43,6 +67,7 @@ size_t strlen(const char *s)
     while (*p) /* Scan byte-by-byte until the null terminator. */
         p++;
     return (size_t) (p - s); /* Return total length. */
+#endif
 }
 
 char *strcpy(char *dst, const char *src)
@@ -127,9 +152,17 @@ int32_t strcmp(const char *s1, const char *s2)
 
             /* Exit if words differ or if a zero byte is found in either word */
             if (!equal_word(v1, v2) || byte_is_zero(v1)) {
+#if defined(__riscv_zbb)
+                /* Compare the first byte that differs or ends @s1 */
+                uint32_t stop = ~orc_b(v1) | orc_b(v1 ^ v2);
+                uint32_t shift = ctz32(stop) & ~7u;
+                return (int32_t) ((v1 >> shift) & 0xFF) -
+                       (int32_t) ((v2 >> shift) & 0xFF);
+#else
                 s1 = (const char *) w1;
                 s2 = (const char *) w2;
                 break;
+#endif
             }
         }
     }
@@ -225,6 +258,42 @@ char *strchr(const char *s, int32_t c)
     }
 }
 
+/* Locates the first occurrence of byte 'c' in the first 'n' bytes of 's'. */
+void *memchr(const void *s, int32_t c, uint32_t n)
+{
+    const uint8_t *p = s;
+    uint8_t ch = (uint8_t) c;
+    uint32_t pat = 0x01010101u * ch;
+
+    /* Byte-by-byte scan until word-aligned */
+    while (n && ((uint32_t) p & 3)) {
+        if (*p == ch)
+            return (void *) p;
+        p++;
+        n--;
+    }
+
+    /* Word scan: stop at the first word holding a match */
+    const uint32_t *w = (const uint32_t *) p;
+    while (n >= 4 && !byte_is_match(*w, pat)) {
+        w++;
+        n -= 4;
+    }
+    p = (const uint8_t *) w;
+
+#if defined(__riscv_zbb)
+    if (n >= 4)
+        return (void *) (p + zero_byte_index(*w ^ pat));
+#endif
+
+    /* Byte scan within the matching word or the tail */
+    for (; n; p++, n--) {
+        if (*p == ch)
+            return (void *) p;
+    }
+    return NULL;
+}
+
 /* Locates the first occurrence of any character from @set in string @s. */
 char *strpbrk(const char *s, const char *set)
 {
@@ -0,0 +1,122 @@
+#!/usr/bin/env python3
+"""Symbolize Linmo PC-sampling profiler output.
+
+Reads the console output of a run that called mo_prof_dump(), resolves each
+sampled PC to the enclosing function of build/image.elf and prints a flat
+profile followed by a per-task breakdown.
+
+Usage:
+    scripts/profile.py [-e build/image.elf] [-n TOP] [console.log]
+
+The console log is read from stdin when no file is given. Symbols are read
+with $(CROSS_COMPILE)nm, defaulting to riscv-none-elf-nm.
+"""
+
+import argparse
+import bisect
+import collections
+import os
+import subprocess
+import sys
+
+
+def load_symbols(elf, nm):
+    out = subprocess.run([nm, "-n", "-S", "--defined-only", elf],
+                         check=True, capture_output=True, text=True).stdout
+    addrs, syms = [], []
+    for line in out.splitlines():
+        fields = line.split()
+        if len(fields) == 4:
+            addr, size, kind, name = fields
+            size = int(size, 16)
+        elif len(fields) == 3:
+            addr, kind, name = fields
+            size = 0
+        else:
+            continue
+        if kind not in "tTwW":
+            continue
+        addrs.append(int(addr, 16))
+        syms.append((name, size))
+    return addrs, syms
+
+
+def symbolize(pc, addrs, syms):
+    i = bisect.bisect_right(addrs, pc) - 1
+    if i < 0:
+        return "?"
+    name, size = syms[i]
+    if size and pc >= addrs[i] + size:
+        return "?"
+    return name
+
+
+def parse_samples(stream):
+    hz = lost = 0
+    samples = []
+    inside = False
+    for line in stream:
+        fields = line.strip().split()
+        if len(fields) < 2 or fields[0] != "PROF":
+            continue
+        if fields[1] == "BEGIN":
+            hz, lost = int(fields[2]), int(fields[4])
+            samples = []
+            inside = True
+        elif fields[1] == "END":
+            inside = False
+        elif inside and len(fields) == 3:
+            samples.append((int(fields[1]), int(fields[2], 16)))
+    return hz, lost, samples
+
+
+def print_table(title, counts, total, top):
+    print(title)
+    print("  %7s %6s  %s" % ("samples", "%", "function"))
+    for name, n in counts.most_common(top):
+        print("  %7d %5.1f%%  %s" % (n, 100.0 * n / total, name))
+    print()
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("log", nargs="?", help="console output (default: stdin)")
+    ap.add_argument("-e", "--elf", default="build/image.elf")
+    ap.add_argument("-n", "--top", type=int, default=20,
+                    help="functions listed per table (default: 20)")
+    args = ap.parse_args()
+
+    nm = os.environ.get("CROSS_COMPILE", "riscv-none-elf-") + "nm"
+    addrs, syms = load_symbols(args.elf, nm)
+
+    if args.log:
+        with open(args.log, errors="replace") as f:
+            hz, lost, samples = parse_samples(f)
+    else:
+        hz, lost, samples = parse_samples(sys.stdin)
+
+    if not samples:
+        sys.exit("no profiler samples found")
+
+    flat = collections.Counter()
+    per_task = collections.defaultdict(collections.Counter)
+    for task, pc in samples:
+        name = symbolize(pc, addrs, syms)
+        flat[name] += 1
+        per_task[task][name] += 1
+
+    total = len(samples)
+    print("%d samples at %d Hz (%.2f s), %d overwritten\n" %
+          (total, hz, total / hz if hz else 0, lost))
+    print_table("Flat profile:", flat, total, args.top)
+
+    for task in sorted(per_task, key=lambda t: -sum(per_task[t].values())):
+        counts = per_task[task]
+        n = sum(counts.values())
+        label = "task %d" % task if task else "no task"
+        print_table("%s: %d samples (%.1f%%)" % (label, n, 100.0 * n / total),
+                    counts, n, args.top)
+
+
+if __name__ == "__main__":
+    main()